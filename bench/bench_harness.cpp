@@ -0,0 +1,30 @@
+#include "bench_harness.hpp"
+
+#include <iomanip>
+
+void print_header(std::ostream& out)
+{
+	out << std::left << std::setw(48) << "benchmark"
+		<< std::right << std::setw(12) << "iterations"
+		<< std::setw(14) << "ns/op"
+		<< std::setw(12) << "allocs/op"
+		<< std::setw(14) << "bytes/op"
+		<< std::setw(12) << "MB/s" << '\n';
+}
+
+void print_result(std::ostream& out, const bench_result& result)
+{
+	out << std::left << std::setw(48) << result.name
+		<< std::right << std::setw(12) << result.iterations
+		<< std::fixed << std::setprecision(1)
+		<< std::setw(14) << result.ns_per_op
+		<< std::setw(12) << result.allocations_per_op
+		<< std::setw(14) << result.bytes_allocated_per_op;
+
+	if (result.mb_per_second > 0)
+		out << std::setw(12) << result.mb_per_second;
+	else
+		out << std::setw(12) << '-';
+
+	out << std::defaultfloat << '\n';
+}
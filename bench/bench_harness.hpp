@@ -0,0 +1,90 @@
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <ostream>
+
+// count_allocations.cpp replaces the global operator new so these count everything the benchmarks allocate
+extern std::atomic<uint64_t> allocation_count;
+extern std::atomic<uint64_t> allocated_bytes;
+
+struct bench_result
+{
+	std::string_view name;
+	uint64_t iterations = 0;
+	double ns_per_op = 0;
+	double allocations_per_op = 0;
+	double bytes_allocated_per_op = 0;
+	// megabytes of input (or output) handled per second. zero if the benchmark didn't say how big its input is.
+	double mb_per_second = 0;
+};
+
+void print_header(std::ostream& out);
+void print_result(std::ostream& out, const bench_result& result);
+
+class bench_runner
+{
+public:
+	// only benchmarks with filter somewhere in their names get run. each runs for at least min_time.
+	bench_runner(std::ostream& out, std::string_view filter, std::chrono::milliseconds min_time) : out(out), filter(filter), min_time(min_time) {}
+
+	// op is called over and over and should return something that depends on its work (a size, a count, whatever)
+	// so the compiler can't throw it away. bytes_per_op is how much data one call chews through, for the throughput column.
+	template <typename Op>
+	void run(std::string_view name, size_t bytes_per_op, Op&& op)
+	{
+		if (name.find(filter) == std::string_view::npos)
+			return;
+
+		// warm up caches and let anything lazy get initialized outside the measurements
+		keep(op());
+
+		bench_result result;
+		result.name = name;
+
+		for (uint64_t batch = 1; ; batch *= 2)
+		{
+			const uint64_t allocs_before = allocation_count.load(std::memory_order_relaxed);
+			const uint64_t bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+			const auto start = clock::now();
+
+			for (uint64_t i = 0; i < batch; i++)
+				keep(op());
+
+			const auto elapsed = clock::now() - start;
+
+			if (elapsed >= min_time || batch >= max_batch)
+			{
+				const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+				result.iterations = batch;
+				result.ns_per_op = ns / batch;
+				result.allocations_per_op = static_cast<double>(allocation_count.load(std::memory_order_relaxed) - allocs_before) / batch;
+				result.bytes_allocated_per_op = static_cast<double>(allocated_bytes.load(std::memory_order_relaxed) - bytes_before) / batch;
+				if (bytes_per_op != 0 && ns > 0)
+					result.mb_per_second = (static_cast<double>(bytes_per_op) * batch / (1024 * 1024)) / (ns / 1e9);
+				break;
+			}
+		}
+
+		print_result(out, result);
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+	static constexpr uint64_t max_batch = uint64_t{ 1 } << 30;
+
+	std::ostream& out;
+	const std::string_view filter;
+	const std::chrono::milliseconds min_time;
+
+	// volatile so the results of each op have to actually be computed
+	volatile size_t sink = 0;
+
+	void keep(size_t value) { sink = sink + value; }
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "bench_harness.hpp"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> allocation_count{ 0 };
+std::atomic<uint64_t> allocated_bytes{ 0 };
+
+// the array, nothrow, and sized versions all end up calling these two,
+// so this is enough to see every allocation the standard library makes on our behalf.
+// over-aligned allocations go through their own path and aren't counted, but nothing in msync asks for those.
+
+void* operator new(std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (void* allocated = std::malloc(size == 0 ? 1 : size))
+		return allocated;
+
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
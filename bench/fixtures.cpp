@@ -0,0 +1,246 @@
+#include "fixtures.hpp"
+
+#include <random>
+#include <array>
+
+constexpr std::array<std::string_view, 8> usernames = { "BestGirlGrace", "crime_skunk", "wiki_tmnt", "princess", "eggbot", "fluency", "hypnovirus", "normal_egg" };
+constexpr std::array<std::string_view, 4> domains = { "", "website.egg", "crime.egg", "princess.software" };
+constexpr std::array<std::string_view, 4> visibilities = { "public", "unlisted", "private", "direct" };
+constexpr std::array<std::string_view, 5> notification_types = { "follow", "mention", "reblog", "favourite", "poll" };
+
+constexpr std::string_view sentences[] = {
+	"I think this has been done before BUT a world where the superhero/villain scene is a kink thing.",
+	"Unit tests are well and good, but they&apos;re no substitute for real-world testing.",
+	"&quot;wins&quot;, though &quot;gritty&quot; pairs are more common these days &amp; that&#39;s fine.",
+	"The buzz in your brain, the tingle behind your eyes, the good girl sneaking through your thoughts.",
+	"msync would have a problem if an image description contained a comma &lt;3",
+};
+
+// each generator gets its own generator with the same seed, so they don't depend on what order they're called in
+std::mt19937 make_rng()
+{
+	return std::mt19937{ 8675309 };
+}
+
+size_t pick(std::mt19937& rng, size_t n)
+{
+	return std::uniform_int_distribution<size_t>{ 0, n - 1 }(rng);
+}
+
+std::string snowflake(size_t n)
+{
+	// these are about the right length and always sort the same way numerically and as strings
+	return std::to_string(103144017685933985ull + n);
+}
+
+void append_account(std::string& out, size_t author)
+{
+	const auto username = usernames[author % usernames.size()];
+	const auto domain = domains[(author / usernames.size()) % domains.size()];
+
+	out += R"({"id":")";
+	out += std::to_string(author + 1);
+	out += R"(","username":")";
+	out += username;
+	out += R"(","acct":")";
+	out += username;
+	if (!domain.empty())
+	{
+		out += '@';
+		out += domain;
+	}
+	out += R"(","display_name":"Account Number )";
+	out += std::to_string(author);
+	out += R"( :qvp:","locked":false,"bot":)";
+	out += author % 7 == 0 ? "true" : "false";
+	out += R"(,"created_at":"2018-08-16T04:45:49.523Z","note":"<p>)";
+	out += sentences[author % std::size(sentences)];
+	out += R"(</p><p>Header by <span class=\"h-card\"><a href=\"https://website.egg/@someone\" class=\"u-url mention\">@<span>someone</span></a></span></p>",)";
+	out += R"("url":"https://website.egg/@)";
+	out += username;
+	out += R"(","avatar":"https://website.egg/system/accounts/avatars/000/000/001/original/2c3b6b7ff75a3d40.gif?1573254299","avatar_static":"https://website.egg/system/accounts/avatars/000/000/001/static/2c3b6b7ff75a3d40.png?1573254299",)";
+	out += R"("header":"https://website.egg/system/accounts/headers/000/000/001/original/ba0b91a0c6545d9a.gif?1536301933","followers_count":1410,"following_count":702,"statuses_count":45048,"last_status_at":"2019-11-15T21:23:54.043Z",)";
+	out += R"("emojis":[{"shortcode":"qvp","url":"https://website.egg/system/custom_emojis/images/000/036/475/original/3470be8e5f2bf943.png","static_url":"https://website.egg/system/custom_emojis/images/000/036/475/static/3470be8e5f2bf943.png","visible_in_picker":true}],)";
+	out += R"("fields":[{"name":"Pronouns","value":"she/her","verified_at":null},{"name":"Website","value":"<a href=\"https://princess.software\" rel=\"me nofollow noopener\" target=\"_blank\"><span class=\"invisible\">https://</span><span class=\"\">princess.software</span><span class=\"invisible\"></span></a>","verified_at":"2019-07-08T07:50:47.669+00:00"}]})";
+}
+
+void append_escaped(std::string& out, std::string_view text)
+{
+	for (const char c : text)
+	{
+		switch (c)
+		{
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		default:
+			out += c;
+		}
+	}
+}
+
+void append_status(std::string& out, std::mt19937& rng, size_t id, size_t distinct_authors, bool allow_reblog)
+{
+	const bool is_reblog = allow_reblog && pick(rng, 4) == 0;
+	const auto author = pick(rng, distinct_authors);
+
+	out += R"({"id":")";
+	out += snowflake(id);
+	out += R"(","created_at":"2019-06-18T05:25:54.100Z","in_reply_to_id":)";
+	if (pick(rng, 3) == 0)
+	{
+		out += '"';
+		out += snowflake(id - 1);
+		out += '"';
+	}
+	else
+	{
+		out += "null";
+	}
+	out += R"(,"in_reply_to_account_id":null,"sensitive":false,"spoiler_text":")";
+	if (pick(rng, 5) == 0)
+		out += "spicy &amp; lewd";
+	out += R"(","visibility":")";
+	out += visibilities[pick(rng, visibilities.size())];
+	out += R"(","language":"en","uri":"https://website.egg/users/someone/statuses/)";
+	out += snowflake(id);
+	out += R"(","url":"https://website.egg/@someone/)";
+	out += snowflake(id);
+	out += R"(","replies_count":)";
+	out += std::to_string(pick(rng, 20));
+	out += R"(,"reblogs_count":)";
+	out += std::to_string(pick(rng, 100));
+	out += R"(,"favourites_count":)";
+	out += std::to_string(pick(rng, 300));
+	out += R"(,"content":")";
+	append_escaped(out, is_reblog ? std::string{} : make_post_html(1 + pick(rng, 3)));
+	out += R"(","reblog":)";
+	if (is_reblog)
+		append_status(out, rng, id + 1000000, distinct_authors, false);
+	else
+		out += "null";
+	out += R"(,"application":{"name":"msync","website":"https://github.com/Kansattica/msync"},"account":)";
+	append_account(out, author);
+	out += R"(,"media_attachments":[)";
+	for (size_t i = 0, count = pick(rng, 4) == 0 ? 1 + pick(rng, 3) : 0; i < count; i++)
+	{
+		if (i != 0)
+			out += ',';
+		out += R"({"id":"22345792","type":"image","url":"https://website.egg/system/media_attachments/files/022/345/792/original/f6a2e6f4e4c2e9f4.png","preview_url":"https://website.egg/system/media_attachments/files/022/345/792/small/f6a2e6f4e4c2e9f4.png","remote_url":null,"text_url":"https://website.egg/media/abcdef","meta":{"original":{"width":640,"height":480,"size":"640x480","aspect":1.3333333333333333}},"description":"A picture of a \"good\" egg","blurhash":"UFS$ovxu~qt7xuj[j[ay~qofIUof%MofIUj["})";
+	}
+	out += R"(],"mentions":[)";
+	if (pick(rng, 3) == 0)
+		out += R"({"id":"2","username":"someone","url":"https://website.egg/@someone","acct":"someone@website.egg"})";
+	out += R"(],"tags":[{"name":"eggs","url":"https://website.egg/tags/eggs"}],"emojis":[],"card":null,"poll":)";
+	if (pick(rng, 10) == 0)
+		out += R"({"id":"34830","expires_at":"2019-12-05T04:05:08.302Z","expired":true,"multiple":false,"votes_count":10,"voters_count":null,"voted":true,"own_votes":[1],"options":[{"title":"accept","votes_count":6},{"title":"deny","votes_count":4}],"emojis":[]})";
+	else
+		out += "null";
+	out += '}';
+}
+
+std::string make_status_page(size_t count, size_t distinct_authors)
+{
+	auto rng = make_rng();
+
+	std::string toreturn{ "[" };
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i != 0)
+			toreturn += ',';
+		// newest first, like the server sends them
+		append_status(toreturn, rng, count - i, distinct_authors, true);
+	}
+	toreturn += ']';
+	return toreturn;
+}
+
+std::string make_notification_page(size_t count, size_t distinct_authors)
+{
+	auto rng = make_rng();
+
+	std::string toreturn{ "[" };
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i != 0)
+			toreturn += ',';
+
+		const auto type = notification_types[pick(rng, notification_types.size())];
+		toreturn += R"({"id":")";
+		toreturn += std::to_string(count - i);
+		toreturn += R"(","type":")";
+		toreturn += type;
+		toreturn += R"(","created_at":"2020-07-19T06:26:55.101Z","account":)";
+		append_account(toreturn, pick(rng, distinct_authors));
+		toreturn += R"(,"status":)";
+		if (type == "follow")
+			toreturn += "null";
+		else
+			append_status(toreturn, rng, count - i, distinct_authors, false);
+		toreturn += '}';
+	}
+	toreturn += ']';
+	return toreturn;
+}
+
+std::string make_post_html(size_t paragraphs)
+{
+	auto rng = make_rng();
+
+	std::string toreturn;
+	for (size_t i = 0; i < paragraphs; i++)
+	{
+		toreturn += "<p>";
+		toreturn += sentences[pick(rng, std::size(sentences))];
+		toreturn += "<br />";
+		toreturn += R"(<span class="h-card"><a href="https://website.egg/@someone" class="u-url mention">@<span>someone</span></a></span> )";
+		toreturn += sentences[pick(rng, std::size(sentences))];
+		toreturn += R"(<br><a href="https://website.egg/tags/eggs" class="mention hashtag" rel="tag">#<span>eggs</span></a> )";
+		toreturn += R"(<a href="https://princess.software/a/long/link" rel="nofollow noopener noreferrer" target="_blank"><span class="invisible">https://</span><span class="ellipsis">princess.software/a/lo</span><span class="invisible">ng/link</span></a>)";
+		toreturn += "</p>";
+	}
+	return toreturn;
+}
+
+std::pair<std::string, std::vector<std::pair<std::string, std::string>>> make_mention_text(size_t mentions)
+{
+	std::pair<std::string, std::vector<std::pair<std::string, std::string>>> toreturn;
+	auto& [text, replacements] = toreturn;
+
+	for (size_t i = 0; i < mentions; i++)
+	{
+		const auto username = usernames[i % usernames.size()];
+		const auto domain = domains[(i / usernames.size()) % domains.size()];
+
+		text += '@';
+		text += username;
+		text += ' ';
+		text += sentences[i % std::size(sentences)];
+		text += ' ';
+
+		std::string acct{ username };
+		if (!domain.empty())
+		{
+			acct += '@';
+			acct += domain;
+		}
+		replacements.emplace_back(std::string{ username }, std::move(acct));
+	}
+
+	return toreturn;
+}
+
+std::vector<std::string> make_ids(size_t count, size_t first)
+{
+	std::vector<std::string> toreturn;
+	toreturn.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		toreturn.push_back(snowflake(first + i));
+	return toreturn;
+}
@@ -0,0 +1,28 @@
+#ifndef BENCH_FIXTURES_HPP
+#define BENCH_FIXTURES_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+
+// synthetic, but shaped like what a busy Mastodon server sends back.
+// everything's made from a fixed seed, so the same build always benchmarks the same input.
+
+// a page of statuses like /api/v1/timelines/home returns. some are boosts, some have attachments, mentions, or polls.
+// the authors are picked from distinct_authors different accounts, so there are repeats like on a real timeline.
+std::string make_status_page(size_t count, size_t distinct_authors);
+
+// a page of notifications like /api/v1/notifications returns, with a status attached to most of them
+std::string make_notification_page(size_t count, size_t distinct_authors);
+
+// a post body with paragraphs, line breaks, links, mentions, hashtags, and entities
+std::string make_post_html(size_t paragraphs);
+
+// post text with plenty of "@username" mentions in it, along with the (username, acct) pairs to swap in for them, in the order they show up
+std::pair<std::string, std::vector<std::pair<std::string, std::string>>> make_mention_text(size_t mentions);
+
+// ids that look like Mastodon snowflake ids, in ascending order
+std::vector<std::string> make_ids(size_t count, size_t first = 0);
+
+#endif
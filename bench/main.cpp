@@ -0,0 +1,203 @@
+#include "bench_harness.hpp"
+#include "fixtures.hpp"
+
+#include "../lib/sync/read_response.hpp"
+#include "../lib/util/util.hpp"
+#include "../lib/postlist/post_list.hpp"
+#include "../lib/queue/queue_list.hpp"
+#include "../lib/queue/queues.hpp"
+#include "../lib/options/option_file.hpp"
+
+#include <print_logger.hpp>
+#include <constants.hpp>
+#include <filesystem.hpp>
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+// usage: msync_bench [filter] [milliseconds per benchmark]
+// only runs the benchmarks with filter in their name, so "msync_bench read_" just does the JSON readers.
+
+void bench_readers(bench_runner& bench)
+{
+	// a full page of each, like recv asks for
+	const std::string statuses = make_status_page(40, 12);
+	const std::string notifications = make_notification_page(30, 12);
+
+	bench.run("read_statuses (40, full accounts)", statuses.size(), [&]()
+	{
+		return read_statuses(statuses).size();
+	});
+
+	bench.run("read_statuses (40, post_list accounts)", statuses.size(), [&]()
+	{
+		return read_statuses(statuses, post_list_account).size();
+	});
+
+	bench.run("read_notifications (30, full accounts)", notifications.size(), [&]()
+	{
+		return read_notifications(notifications).size();
+	});
+
+	bench.run("read_notifications (30, post_list accounts)", notifications.size(), [&]()
+	{
+		return read_notifications(notifications, post_list_account).size();
+	});
+}
+
+void bench_text(bench_runner& bench)
+{
+	const std::string short_post = make_post_html(1);
+	const std::string long_post = make_post_html(20);
+
+	bench.run("clean_up_html (1 paragraph)", short_post.size(), [&]()
+	{
+		return clean_up_html(short_post).size();
+	});
+
+	bench.run("clean_up_html (20 paragraphs)", long_post.size(), [&]()
+	{
+		return clean_up_html(long_post).size();
+	});
+
+	const auto [mention_text, mention_pairs] = make_mention_text(30);
+	std::vector<std::pair<std::string_view, std::string_view>> mentions;
+	for (const auto& pair : mention_pairs)
+		mentions.emplace_back(pair.first, pair.second);
+
+	bench.run("bulk_replace_mentions (30 mentions)", mention_text.size(), [&, text = std::string{}]() mutable
+	{
+		// assign reuses the buffer, so this is mostly measuring the replacing
+		text.assign(mention_text);
+		return bulk_replace_mentions(text, mentions).size();
+	});
+}
+
+void bench_post_list(bench_runner& bench, const fs::path& scratch)
+{
+	const auto statuses = read_statuses(make_status_page(40, 12), post_list_account);
+	const fs::path list_file = scratch / "home.list";
+
+	// write it once to see how big a page is, for the throughput
+	{
+		post_list<mastodon_status> list{ list_file };
+		for (const auto& status : statuses)
+			list.write(status);
+	}
+	const auto page_bytes = fs::file_size(list_file);
+	fs::remove(list_file);
+
+	bench.run("post_list<mastodon_status>::write (40)", static_cast<size_t>(page_bytes), [&]()
+	{
+		{
+			post_list<mastodon_status> list{ list_file };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+		// otherwise the file grows forever
+		fs::remove(list_file);
+		return statuses.size();
+	});
+}
+
+void make_queue_file(const fs::path& account_dir, size_t entries)
+{
+	fs::remove(account_dir / Queue_Filename);
+	queue_list queue{ account_dir / Queue_Filename };
+	// every third one's a boost, so there's more than one kind of call in there
+	size_t i = 0;
+	for (auto& id : make_ids(entries))
+		queue.parsed.push_back(api_call{ i++ % 3 == 0 ? api_route::boost : api_route::fav, std::move(id) });
+}
+
+void bench_file_backed(bench_runner& bench, const fs::path& scratch)
+{
+	constexpr size_t queue_size = 10000;
+
+	const fs::path account_dir = scratch / "account";
+	fs::create_directories(account_dir);
+	make_queue_file(account_dir, queue_size);
+
+	const fs::path queue_file = account_dir / Queue_Filename;
+	const auto queue_bytes = static_cast<size_t>(fs::file_size(queue_file));
+
+	bench.run("readonly_queue_list load (10k)", queue_bytes, [&]()
+	{
+		const readonly_queue_list queue{ queue_file };
+		return queue.parsed.size();
+	});
+
+	bench.run("queue_list load and save (10k)", queue_bytes, [&]()
+	{
+		const queue_list queue{ queue_file };
+		return queue.parsed.size();
+	});
+
+	const auto new_ids = make_ids(100, queue_size * 2);
+
+	bench.run("enqueue then dequeue 1 (10k queue)", queue_bytes, [&]()
+	{
+		enqueue(api_route::fav, account_dir, { new_ids.front() });
+		dequeue(api_route::fav, account_dir, { new_ids.front() });
+		return size_t{ 2 };
+	});
+
+	bench.run("enqueue then dequeue 100 (10k queue)", queue_bytes, [&]()
+	{
+		enqueue(api_route::fav, account_dir, new_ids);
+		dequeue(api_route::fav, account_dir, new_ids);
+		return new_ids.size();
+	});
+
+	// what a script bulk-enqueueing with --from looks like
+	const auto bulk_ids = make_ids(5000, queue_size * 3);
+
+	bench.run("enqueue then dequeue 5000 (10k queue)", queue_bytes, [&]()
+	{
+		enqueue(api_route::fav, account_dir, bulk_ids);
+		dequeue(api_route::fav, account_dir, bulk_ids);
+		return bulk_ids.size();
+	});
+
+	// real config files only have a couple dozen lines, so this is a lot bigger than usual to make the per-line costs show up
+	const fs::path config_file = scratch / User_Options_Filename;
+	{
+		option_file config{ config_file };
+		for (size_t i = 0; i < 2000; i++)
+			config.parsed.insert_or_assign("option_number_" + std::to_string(i), "a value that's about as long as an access token " + std::to_string(i));
+	}
+	const auto config_bytes = static_cast<size_t>(fs::file_size(config_file));
+
+	bench.run("option_file load and save (2k lines)", config_bytes, [&]()
+	{
+		const option_file config{ config_file };
+		return config.parsed.size();
+	});
+}
+
+int main(int argc, char** argv)
+{
+	// enqueue and friends like to talk
+	logs_off = true;
+
+	const std::string_view filter = argc > 1 ? argv[1] : "";
+	const std::chrono::milliseconds min_time{ argc > 2 ? std::strtol(argv[2], nullptr, 10) : 250 };
+
+	const fs::path scratch = fs::temp_directory_path() / "msync_bench";
+	fs::remove_all(scratch);
+	fs::create_directories(scratch);
+
+	bench_runner bench{ std::cout, filter, min_time };
+	print_header(std::cout);
+
+	bench_readers(bench);
+	bench_text(bench);
+	bench_post_list(bench, scratch);
+	bench_file_backed(bench, scratch);
+
+	fs::remove_all(scratch);
+}
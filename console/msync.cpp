@@ -4,6 +4,11 @@
 #include <string>
 #include <string_view>
 #include <algorithm>
+#include <vector>
+#include <optional>
+#include <sstream>
+#include <fstream>
+#include <iostream>
 
 #include "version.hpp"
 #include "../lib/options/global_options.hpp"
@@ -13,6 +18,14 @@
 #include "../lib/queue/queues.hpp"
 #include "../lib/sync/send.hpp"
 #include "../lib/sync/recv.hpp"
+#include "../lib/sync/sync_pool.hpp"
+#include "../lib/sync/sync_stats.hpp"
+#include "../lib/sync/rate_limit_pacer.hpp"
+#include "../lib/sync/backoff.hpp"
+#include "../lib/postlist/post_index.hpp"
+#include "../lib/postlist/list_segments.hpp"
+#include "../lib/postlist/list_compression.hpp"
+#include "../lib/constants/constants.hpp"
 #include "../lib/net/net.hpp"
 #include "../lib/util/util.hpp"
 #include "../lib/accountdirectory/account_directory.hpp"
@@ -26,10 +39,13 @@ std::pair<const std::string, user_options>& assume_account(select_account_result
 std::string get_account_error(select_account_error err);
 
 void do_sync(const parse_result& parsed);
+void show_post(const fs::path& user_dir, const read_options& opts);
+void list_posts(const fs::path& user_dir, const read_options& opts);
 
 void show_all_options(select_account_result user_result);
 
 void print_stringptr(const std::string* toprint);
+std::vector<std::string> queued_ids(const queue_options& opts);
 void print_sensitive(std::string_view name, const std::string* value);
 
 global_options& options();
@@ -80,6 +96,14 @@ int main(int argc, const char* argv[])
 			should_print_newline = false;
 			assume_account(parsed.account).second.set_option(parsed.toset, parsed.sync_opts.mode);
 			break;
+		case mode::configformat:
+			should_print_newline = false;
+			assume_account(parsed.account).second.set_option(parsed.toset, parsed.format);
+			break;
+		case mode::configsegments:
+			should_print_newline = false;
+			assume_account(parsed.account).second.set_option(parsed.toset, parsed.segments);
+			break;
 		case mode::configlist:
 			should_print_newline = false;
 			assume_account(parsed.account).second.set_option(parsed.toset, parsed.listops);
@@ -89,10 +113,10 @@ int main(int argc, const char* argv[])
 			switch (parsed.queue_opt.to_do)
 			{
 			case queue_action::add:
-				enqueue(parsed.queue_opt.selected, assume_account(parsed.account).second.get_user_directory(), parsed.queue_opt.queued);
+				enqueue(parsed.queue_opt.selected, assume_account(parsed.account).second.get_user_directory(), queued_ids(parsed.queue_opt));
 				break;
 			case queue_action::remove:
-				dequeue(parsed.queue_opt.selected, assume_account(parsed.account).second.get_user_directory(), parsed.queue_opt.queued);
+				dequeue(parsed.queue_opt.selected, assume_account(parsed.account).second.get_user_directory(), queued_ids(parsed.queue_opt));
 				break;
 			case queue_action::clear:
 				clear(parsed.queue_opt.selected, assume_account(parsed.account).second.get_user_directory());
@@ -102,6 +126,13 @@ int main(int argc, const char* argv[])
 				break;
 			}
 			break;
+		case mode::show:
+			show_post(assume_account(parsed.account).second.get_user_directory(), parsed.read_opt);
+			break;
+		case mode::list:
+			should_print_newline = false;
+			list_posts(assume_account(parsed.account).second.get_user_directory(), parsed.read_opt);
+			break;
 		case mode::gen:
 		{ //notice the braces- this is a scope
 			outgoing_post post(parsed.gen_opt.filename);
@@ -182,38 +213,199 @@ void do_sync(const parse_result& parsed)
 	}
 
 
-	if (parsed.sync_opts.send)
-	{
+	// only collect stats if someone's going to look at them
+	stats_report report;
+	stats_report* const stats = parsed.sync_opts.stats == stats_format::off ? nullptr : &report;
+
+	backoff_policy backoff;
+	backoff.base = std::chrono::milliseconds{ parsed.sync_opts.retry_delay };
+	backoff.deadline = std::chrono::seconds{ parsed.sync_opts.retry_deadline };
+
+	const auto send_account = [&parsed, &backoff, stats](const user_ptr account) {
+		rate_limit_pacer pacer{ account->second.get_user_directory() / Rate_Limit_Filename };
+		const pacing_scope pacing{ &pacer };
 		send_posts send{ simple_post, simple_delete, new_status, upload_media, get_timeline_and_notifs };
 		send.retries = parsed.sync_opts.retries;
-		if (user == nullptr) 
+		send.backoff = backoff;
+		send.jobs = parsed.sync_opts.send_jobs;
+		send.upload_jobs = parsed.sync_opts.upload_jobs;
+		send.coalesce_calls = parsed.sync_opts.coalesce;
+		send.retry_failed = parsed.sync_opts.retry_failed;
+		send.stats = stats;
+		pl() << "Processing queue for " << account->first << '\n';
+		send.send(account->second.get_user_directory(), account->second.get_option(user_option::instance_url), account->second.get_option(user_option::access_token));
+	};
+
+	const auto recv_account = [&parsed, &backoff, stats](const user_ptr account) {
+		rate_limit_pacer pacer{ account->second.get_user_directory() / Rate_Limit_Filename };
+		const pacing_scope pacing{ &pacer };
+		recv_posts recv{ get_timeline_and_notifs };
+		recv.max_requests = parsed.sync_opts.max_requests;
+		recv.per_call = parsed.sync_opts.per_call;
+		recv.prefetch = parsed.sync_opts.prefetch;
+		recv.retries = parsed.sync_opts.retries;
+		recv.backoff = backoff;
+		recv.stats = stats;
+		recv.get(account->second);
+
+		// save the new last ids now so they're not lost if a later account fails, and so this shows up in the stats
+		const stats_section section{ stats, to_utf8(account->second.get_user_directory().filename()), "config" };
+		const timed_phase saving{ sync_phase::config_save };
+		account->second.save();
+	};
+
+	std::vector<user_ptr> to_sync;
+	if (user == nullptr)
+		options().foreach_account([&to_sync](auto& account) { to_sync.push_back(&account); });
+	else
+		to_sync.push_back(user);
+
+	const auto instance_of = [](const user_ptr account) { return account->second.get_option(user_option::instance_url); };
+
+	if (parsed.sync_opts.jobs <= 1 || to_sync.size() <= 1)
+	{
+		// one at a time: send everything, then get everything.
+		// this still goes through sync_accounts so an account that gets rate limited can wait while the others go.
+		const pool_limits one_at_a_time{ 1, parsed.sync_opts.per_instance };
+		if (parsed.sync_opts.send)
+			sync_accounts(to_sync, one_at_a_time, instance_of, send_account);
+
+		if (parsed.sync_opts.get)
+			sync_accounts(to_sync, one_at_a_time, instance_of, recv_account);
+	}
+	else
+	{
+		// send_posts and recv_posts are made fresh for each account, so the workers don't share anything but the network functions.
+		// if an account gets rate limited partway through, it's synced again from the top later. the queue journal and the
+		// last ids it saved along the way mean the second time picks up about where the first one left off.
+		sync_accounts(to_sync, pool_limits{ parsed.sync_opts.jobs, parsed.sync_opts.per_instance }, instance_of,
+			[&](const user_ptr account) {
+				if (parsed.sync_opts.send)
+					send_account(account);
+				if (parsed.sync_opts.get)
+					recv_account(account);
+			});
+	}
+
+	if (stats != nullptr)
+	{
+		std::ostringstream printed;
+		report.print(printed, parsed.sync_opts.stats);
+		pl() << printed.str();
+	}
+}
+
+std::vector<fs::path> timeline_files(const fs::path& user_dir, timeline which)
+{
+	switch (which)
+	{
+	case timeline::home:
+		return { user_dir / Home_Timeline_Filename };
+	case timeline::notifications:
+		return { user_dir / Notifications_Filename };
+	case timeline::bookmarks:
+		return { user_dir / Bookmarks_Filename };
+	default:
+		return { user_dir / Home_Timeline_Filename, user_dir / Notifications_Filename, user_dir / Bookmarks_Filename };
+	}
+}
+
+// the text of one segment of a list, which isn't opened (or decompressed, if the segment's been compressed) until something asks for it
+class segment_text
+{
+public:
+	segment_text(const fs::path& segment) : segment(segment) {}
+
+	std::istream& get()
+	{
+		if (fs::exists(segment))
+		{
+			if (!plain.is_open())
+				plain.open(segment.c_str(), std::ios::binary);
+			return plain;
+		}
+
+		if (!decompressed.has_value())
+			decompressed.emplace(read_segment(segment));
+		return *decompressed;
+	}
+
+private:
+	const fs::path& segment;
+	std::ifstream plain;
+	std::optional<std::istringstream> decompressed;
+};
+
+// calls on_segment with an index and the text for each segment of timeline_file until on_segment returns true. returns whether it did.
+// a compressed segment's index is used as it is, so the segment only gets decompressed if on_segment actually reads from it.
+template <typename segment_callback>
+bool for_each_segment(const fs::path& timeline_file, bool newest_first, segment_callback on_segment)
+{
+	std::vector<fs::path> segments = read_segments(timeline_file);
+	if (newest_first)
+		std::reverse(segments.begin(), segments.end());
+
+	for (const fs::path& segment : segments)
+	{
+		std::optional<post_index> index;
+		if (fs::exists(segment))
+		{
+			// this catches the index up first if it's behind, which only takes a while the first time
+			index.emplace(segment);
+		}
+		else if (fs::exists(compressed_file_for(segment)))
 		{
-			options().foreach_account([&send](const auto& user) {
-				pl() << "Processing queue for " << user.first << '\n';
-				send.send(user.second.get_user_directory(), user.second.get_option(user_option::instance_url), user.second.get_option(user_option::access_token)); });
+			index.emplace(segment, index_as_is{});
+
+			// it should have been caught up before it was compressed, but if it's gone missing, it has to be made again from the whole thing
+			if (index->size() == 0)
+			{
+				index.reset();
+				index.emplace(segment, read_segment(segment));
+			}
 		}
 		else
 		{
-			pl() << "Processing queue for " << user->first << '\n';
-			send.send(user->second.get_user_directory(), user->second.get_option(user_option::instance_url), user->second.get_option(user_option::access_token));
+			continue;
 		}
+
+		segment_text text{ segment };
+		if (on_segment(*index, text))
+			return true;
 	}
 
-	if (parsed.sync_opts.get)
-	{
-		recv_posts recv{ get_timeline_and_notifs };
-		recv.max_requests = parsed.sync_opts.max_requests;
-		recv.per_call = parsed.sync_opts.per_call;
-		recv.retries = parsed.sync_opts.retries;
+	return false;
+}
 
-		if (user == nullptr)
+void show_post(const fs::path& user_dir, const read_options& opts)
+{
+	for (const fs::path& timeline_file : timeline_files(user_dir, opts.which))
+	{
+		// newest segment first, since that's where most lookups end up
+		const bool found = for_each_segment(timeline_file, true, [&opts](post_index& index, segment_text& list)
 		{
-			options().foreach_account([&recv](auto& user) {
-				recv.get(user.second); });
-		}
-		else
-			recv.get(user->second);
+			const auto entry = index.find(opts.id);
+			if (entry.has_value())
+				pl() << read_post(list.get(), *entry);
+			return entry.has_value();
+		});
+
+		if (found)
+			return;
 	}
+
+	throw msync_exception("Couldn't find anything with the id " + opts.id + ". It might not have been downloaded with msync sync yet.");
+}
+
+void list_posts(const fs::path& user_dir, const read_options& opts)
+{
+	for_each_segment(timeline_files(user_dir, opts.which).front(), false, [&opts](post_index& index, segment_text& list)
+	{
+		// segments from before opts.since don't have to be read at all
+		for (const index_entry& entry : index.since(opts.since))
+			pl() << read_post(list.get(), entry) << "\n--------------\n";
+		return false;
+	});
 }
 
 bool is_sensitive(user_option opt)
@@ -243,7 +435,7 @@ void show_all_options(select_account_result user_result)
 	const auto& user = assume_account(user_result);
 	pl() << "\nSettings for " << user.first << ":\n";
 	constexpr auto first_boolean_option = user_option::is_default;
-	for (auto opt = user_option(0); opt <= user_option::pull_notifications; opt = user_option(static_cast<int>(opt) + 1))
+	for (auto opt = user_option(0); opt <= user_option::list_segments; opt = user_option(static_cast<int>(opt) + 1))
 	{
 		const auto option_name = USER_OPTION_NAMES[static_cast<int>(opt)];
 		if (opt < first_boolean_option)
@@ -264,6 +456,14 @@ void show_all_options(select_account_result user_result)
 		{
 			pl() << option_name << ": " << (user.second.get_bool_option(opt) ? "true" : "false") << '\n';
 		}
+		else if (opt == user_option::list_format)
+		{
+			pl() << option_name << ": " << LIST_FORMAT_NAMES[static_cast<int>(user.second.get_list_format())] << '\n';
+		}
+		else if (opt == user_option::list_segments)
+		{
+			pl() << option_name << ": " << LIST_SEGMENTS_NAMES[static_cast<int>(user.second.get_list_segments())] << '\n';
+		}
 		else
 		{
 			pl() << option_name << ": " << SYNC_SETTING_NAMES[static_cast<int>(user.second.get_sync_option(opt))] << '\n';
@@ -319,6 +519,25 @@ void print_stringptr(const std::string* toprint)
 		pl() << *toprint;
 }
 
+std::vector<std::string> queued_ids(const queue_options& opts)
+{
+	std::vector<std::string> ids = opts.queued;
+	if (opts.id_file.empty())
+		return ids;
+
+	if (opts.id_file == "-")
+	{
+		read_ids(std::cin, ids);
+		return ids;
+	}
+
+	std::ifstream id_file{ opts.id_file };
+	if (!id_file)
+		throw msync_exception("Could not open " + opts.id_file + " to read ids from.");
+	read_ids(id_file, ids);
+	return ids;
+}
+
 template <typename T>
 void print_iterable(const T& vec)
 {
@@ -50,6 +50,16 @@ clipp::group make_cli(parse_result& ret)
 						command("oldest").set(ret.sync_opts.mode, sync_settings::oldest_first),
 						command("off").set(ret.sync_opts.mode, sync_settings::dont_sync)))
 				.doc("Whether to synchronize an account's home timeline and notifications, and whether to do it newest first, oldest first, or not at all."),
+				in_sequence(command("list_format").set(ret.selected, mode::configformat).set(ret.toset, user_option::list_format),
+					one_of(command("text").set(ret.format, list_format::text),
+						command("jsonl").set(ret.format, list_format::jsonl),
+						command("binary").set(ret.format, list_format::binary)))
+				.doc("How to write an account's timelines: as text for reading (home.list), as JSON lines (home.jsonl), or as length-prefixed binary records (home.bin) for other programs to read."),
+				in_sequence(command("list_segments").set(ret.selected, mode::configsegments).set(ret.toset, user_option::list_segments),
+					one_of(command("off").set(ret.segments, list_segments::off),
+						command("monthly").set(ret.segments, list_segments::monthly),
+						command("size").set(ret.segments, list_segments::size)))
+				.doc("Whether to split an account's home timeline and notifications into a file per month (home.2020-06.list) or every 64 MB (home.0001.list), or keep each in one file."),
 /*				in_sequence(command("list").set(ret.selected, mode::configlist),
 					one_of(command("add").set(ret.listops, list_operations::add),
 						command("remove").set(ret.listops, list_operations::remove)),
@@ -61,8 +71,21 @@ clipp::group make_cli(parse_result& ret)
 	const auto syncMode = (command("sync", "s").set(ret.selected, mode::sync).doc("Synchronize your account[s] with their server[s]. Synchronizes all accounts unless one is specified with -a.") &
 			(
 			(option("-r", "--retries") & value("retries", ret.sync_opts.retries)) % "Retry failed requests n times. (default: 3)",
+			(option("--retry-delay") & value("ms", ret.sync_opts.retry_delay)) % "After a timeout or server error, wait up to this long before the first retry, doubling for each retry after that, up to 30 seconds. The actual wait is random. 0 retries right away. (default: 500)",
+			(option("--retry-deadline") & value("seconds", ret.sync_opts.retry_deadline)) % "Give up on a request that's still failing after this long, even if it has retries left. Rate limit waits don't count. 0 means no limit. (default: 120)",
 			(option("-p", "--posts") & value("count", ret.sync_opts.per_call)) % "When receiving, get this many posts or notifications per call. Decrease this if you have a flaky connection. (default: 40 for statuses, 30 for notifications)",
 			(option("-m", "--max-requests") & value("count", ret.sync_opts.max_requests)) % "When receiving, get at most this many pages of posts or notifications. (default: 5 on first run, unlimited afterwards)",
+			(option("--prefetch") & value("pages", ret.sync_opts.prefetch)) % "When receiving, request up to this many pages ahead while the current one is being read and written. Helps on high-latency connections. (default: 0, off)",
+			(option("-j", "--jobs") & value("count", ret.sync_opts.jobs)) % "Sync up to this many accounts at the same time. Each account's output is printed all at once when it finishes. (default: 1)",
+			(option("--per-instance") & value("count", ret.sync_opts.per_instance)) % "When syncing accounts at the same time, sync at most this many accounts on the same instance at once. (default: 2)",
+			(option("--send-jobs") & value("count", ret.sync_opts.send_jobs)) % "Send up to this many queued favs, boosts, posts, and so on for an account at the same time. Replies still wait for the posts they reply to, and calls on the same post still happen in order. (default: 1)",
+			(option("--upload-jobs") & value("count", ret.sync_opts.upload_jobs)) % "Upload up to this many of a post's attachments at the same time. (default: 1)",
+			option("--coalesce").set(ret.sync_opts.coalesce).doc("Before sending, skip queued calls that cancel each other out, like a fav that's unfaved later in the queue, and repeats of the same call. Posts are always sent as queued."),
+			option("--retry-failed").set(ret.sync_opts.retry_failed).doc("Send queued calls that failed recently right away instead of waiting, and put everything in sync.queue.failed back in the queue to be tried again."),
+			one_of(
+				option("--stats").set(ret.sync_opts.stats, stats_format::table).doc("When finished, print a table of where the time went for each account and timeline: waiting on the network, reading JSON, cleaning up HTML, and so on."),
+				option("--stats-json").set(ret.sync_opts.stats, stats_format::json).doc("Same as --stats, but print the numbers as JSON.")
+				),
 			one_of(
 				option("-s", "--send-only").set(ret.sync_opts.get, false).doc("Only send queued messages, don't download anything."),
 				option("-g", "--get-only", "--recv-only").set(ret.sync_opts.send, false).doc("Only download posts, don't send anything from queues.")
@@ -101,12 +124,29 @@ clipp::group make_cli(parse_result& ret)
 				command("context").set(ret.queue_opt.selected, api_route::context) & opt_values("post ids", ret.queue_opt.queued),
 				command("post").set(ret.queue_opt.selected, api_route::post) & opt_values("filenames", ret.queue_opt.queued),
 				command("print").set(ret.queue_opt.to_do, queue_action::print))
-			.doc("queue commands"));
+			.doc("queue commands"),
+			(option("-f", "--from") & value("file", ret.queue_opt.id_file)).doc("Also read post ids or filenames from this file, one per line. Use - to read them from standard input."));
+
+	const auto timelines = one_of(
+		command("home").set(ret.read_opt.which, timeline::home),
+		command("notifications").set(ret.read_opt.which, timeline::notifications),
+		command("bookmarks").set(ret.read_opt.which, timeline::bookmarks));
+
+	const auto showMode = (command("show").set(ret.selected, mode::show).doc("Print a downloaded post or notification by its id. Looks in the home timeline, notifications, and bookmarks unless one is given.") &
+			value("id", ret.read_opt.id) &
+			one_of(
+				option("home").set(ret.read_opt.which, timeline::home),
+				option("notifications").set(ret.read_opt.which, timeline::notifications),
+				option("bookmarks").set(ret.read_opt.which, timeline::bookmarks)));
+
+	const auto listMode = (command("list").set(ret.selected, mode::list).doc("Print the downloaded posts or notifications in a timeline, oldest first.") &
+			timelines &
+			(option("--since") & value("date", ret.read_opt.since)).doc("Only print ones posted or boosted on or after this date, like 2020-06-01. Leave off the end to be less specific, like 2020-06."));
 
 	const auto universalOptions = ((option("-a", "--account") & value("account", ret.account)).doc("The account name to operate on."),
 			option("-v", "--verbose").set(verbose_logs).doc("Verbose mode. Program will be more chatty."));
 
-	return (newaccount | configMode | syncMode | genMode | queueMode | 
+	return (newaccount | configMode | syncMode | genMode | queueMode | showMode | listMode | 
 		command("yeehaw").set(ret.selected, mode::yeehaw) | 
 		command("location").set(ret.selected, mode::location).doc("Print the location where msync stores user data.") | 
 		command("version", "--version").set(ret.selected, mode::version).doc("Print version and compile flags.") |
@@ -9,10 +9,14 @@ enum class mode
 	showallopt,
 	config,
 	configsync,
+	configformat,
+	configsegments,
 	configlist,
 	sync,
 	gen,
 	queue,
+	show,
+	list,
 	help,
 	version,
 	yeehaw,
@@ -27,8 +31,11 @@ struct parse_result
 	user_option toset;
 	// maybe later, do a union or variant for the mutually exclusive ones
 	list_operations listops;
+	list_format format = list_format::text;
+	list_segments segments = list_segments::off;
 	sync_options sync_opts;
 	queue_options queue_opt;
+	read_options read_opt;
 	gen_options gen_opt;
 	std::string optionval;
 	std::string account;
@@ -1,12 +1,24 @@
 #include "../../lib/options/user_options.hpp"
 #include "../../lib/queue/queues.hpp"
 #include "../../lib/postfile/outgoing_post.hpp"
+#include "../../lib/sync/sync_stats.hpp"
 
 struct sync_options
 {
 	unsigned int retries = 3;
+	// in milliseconds and seconds, respectively
+	unsigned int retry_delay = 500;
+	unsigned int retry_deadline = 120;
 	unsigned int max_requests = 0;
 	unsigned int per_call = 0;
+	unsigned int prefetch = 0;
+	unsigned int jobs = 1;
+	unsigned int per_instance = 2;
+	unsigned int send_jobs = 1;
+	unsigned int upload_jobs = 1;
+	bool coalesce = false;
+	bool retry_failed = false;
+	stats_format stats = stats_format::off;
 	bool send = true;
 	bool get = true;
 	sync_settings mode;
@@ -23,10 +35,29 @@ enum class queue_action
 struct queue_options
 {
 	std::vector<std::string> queued;
+	// read more of them from here, one per line. "-" means standard input.
+	std::string id_file;
 	queue_action to_do = queue_action::add;
 	api_route selected;
 };
 
+enum class timeline
+{
+	any,
+	home,
+	notifications,
+	bookmarks
+};
+
+struct read_options
+{
+	// for msync show
+	std::string id;
+	// for msync list
+	std::string since;
+	timeline which = timeline::any;
+};
+
 struct gen_options
 {
 	std::string filename = "new_post";
@@ -39,6 +39,20 @@ struct mastodon_account
 	bool is_bot = false;
 };
 
+// which optional parts of an account to read out of the JSON. whatever's left off is skipped by the parser
+// without being copied or cleaned up, and stays empty in the mastodon_account.
+// account_name, display_name, and is_bot are always read.
+struct account_projection
+{
+	bool id = true;
+	bool note = true;
+	bool url = true;
+	bool avatar = true;
+	bool fields = true;
+};
+
+constexpr account_projection full_account{};
+
 struct mastodon_attachment
 {
 	std::string url;
@@ -59,6 +73,7 @@ struct mastodon_status
 	std::string boosted_by; // if this is a boost of another post 
 	std::string boosted_by_display_name; // if this is a boost of another post 
 	bool boosted_by_bot = false; // if this is a boost of another post 
+	std::string boosted_at; // if this is a boost of another post. created_at is when the original was posted.
 	unsigned int favorites = 0;
 	unsigned int boosts = 0;
 	unsigned int replies = 0;
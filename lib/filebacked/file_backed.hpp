@@ -48,25 +48,23 @@ public:
 			// if they only wanted to look at the thing, don't save the changes
 		}
 
-		if (fs::exists(backing))
-		{
-			// either we got moved from, so the new version will save it, or just got told not to bother.
-			// however, we should always create a file if it doesn't exist.
-			if (!should_save_back)
-				return;
+		// either we got moved from, so the new version will save it, or just got told not to bother.
+		// however, we should always create a file if it doesn't exist.
+		if (!should_save_back && fs::exists(backing))
+			return;
 
-			// gotta make a copy here
-			const fs::path backup = fs::path{ backing }.concat(".bak");
-#ifdef _WIN32
-			// sometimes, Windows doesn't do the rename correctly and throws an "access denied" error when
-			// renaming over an existing file.
-			fs::remove(backup);
-#endif
-			fs::rename(backing, backup);
-		}
+		write_out(std::move(parsed));
+	}
 
-		std::ofstream of{ backing.c_str() };
-		Write(std::move(parsed), of);
+	// write the file now instead of waiting for the destructor.
+	// the destructor won't write it again unless should_save_back gets set again.
+	void save()
+	{
+		static_assert(!read_only, "Can't save a read-only file.");
+
+		// Write wants to consume what it's writing, and we still need it
+		write_out(Container{ parsed });
+		should_save_back = false;
 	}
 
 	// can be moved
@@ -90,6 +88,24 @@ public:
 
 private:
 	fs::path backing;
+
+	void write_out(Container&& contents)
+	{
+		if (fs::exists(backing))
+		{
+			// gotta make a copy here
+			const fs::path backup = fs::path{ backing }.concat(".bak");
+#ifdef _WIN32
+			// sometimes, Windows doesn't do the rename correctly and throws an "access denied" error when
+			// renaming over an existing file.
+			fs::remove(backup);
+#endif
+			fs::rename(backing, backup);
+		}
+
+		std::ofstream of{ backing.c_str() };
+		Write(std::move(contents), of);
+	}
 };
 
 #endif
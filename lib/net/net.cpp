@@ -3,6 +3,12 @@
 #include <cpr/cpr.h>
 #include <string>
 #include <utility>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <charconv>
 
 #include <filesystem.hpp>
 
@@ -22,6 +28,86 @@ std::string make_bearer(const std::string_view access_token)
 	return std::string{ "Bearer " }.append(access_token);
 }
 
+enum class request_kind : uint8_t
+{
+	get,
+	post,
+	del,
+	upload,
+	status
+};
+
+// curl keeps connections and TLS sessions alive per handle, so holding on to sessions per server
+// means a sync connects once instead of once per request. this also lets curl use HTTP/2 when the server offers it.
+// each kind of request gets its own sessions, so each one always sets the same options and nothing, like a multipart body, leaks between them.
+// a session can only be used by one thread at a time, but a lot of requests come from threads that only last for one timeline or one
+// trip through the queue, so the sessions go back in a pool everyone shares when a request's done instead of going away with the thread.
+class session_pool
+{
+public:
+	std::unique_ptr<cpr::Session> take(const std::string& key)
+	{
+		const std::lock_guard<std::mutex> guard(lock);
+		auto found = idle.find(key);
+		if (found == idle.end() || found->second.empty())
+			return std::make_unique<cpr::Session>();
+
+		auto session = std::move(found->second.back());
+		found->second.pop_back();
+		return session;
+	}
+
+	void give_back(std::string&& key, std::unique_ptr<cpr::Session>&& session)
+	{
+		const std::lock_guard<std::mutex> guard(lock);
+		auto& sessions = idle[std::move(key)];
+		// more than this would only be around if a lot of jobs were running at once, and they'll just connect again
+		if (sessions.size() < Max_Idle_Sessions)
+			sessions.push_back(std::move(session));
+	}
+
+private:
+	static constexpr size_t Max_Idle_Sessions = 8;
+	std::mutex lock;
+	std::unordered_map<std::string, std::vector<std::unique_ptr<cpr::Session>>> idle;
+};
+
+// a session out of the pool for one request, which goes back in when this goes away
+class pooled_session
+{
+public:
+	pooled_session(const std::string_view url, const request_kind kind)
+	{
+		// the key is the scheme and host, like https://crime.egg, plus the kind of request
+		const size_t scheme_end = url.find("://");
+		const size_t host_end = url.find('/', scheme_end == std::string_view::npos ? 0 : scheme_end + 3);
+		key = url.substr(0, host_end);
+		key += static_cast<char>('0' + static_cast<uint8_t>(kind));
+
+		session = pool().take(key);
+	}
+
+	~pooled_session()
+	{
+		pool().give_back(std::move(key), std::move(session));
+	}
+
+	pooled_session(const pooled_session&) = delete;
+	pooled_session& operator=(const pooled_session&) = delete;
+
+	cpr::Session* operator->() { return session.get(); }
+
+private:
+	std::string key;
+	std::unique_ptr<cpr::Session> session;
+
+	static session_pool& pool()
+	{
+		static session_pool sessions;
+		return sessions;
+	}
+};
+
 net_response handle_response(cpr::Response&& response)
 {
 	net_response to_return;
@@ -41,6 +127,18 @@ net_response handle_response(cpr::Response&& response)
 	to_return.okay = !response.error && response.status_code >= 200 && response.status_code < 300;
 
 	// https://docs.joinmastodon.org/api/rate-limits/
+	// these come with every response, not just 429s, so requests can be paced before the limit runs out
+	const auto limit = response.header.find("X-RateLimit-Limit");
+	const auto remaining = response.header.find("X-RateLimit-Remaining");
+	if (limit != response.header.end() && remaining != response.header.end())
+	{
+		std::from_chars(limit->second.data(), limit->second.data() + limit->second.size(), to_return.rate_limit);
+		std::from_chars(remaining->second.data(), remaining->second.data() + remaining->second.size(), to_return.rate_limit_remaining);
+		const auto reset = response.header.find("X-RateLimit-Reset");
+		if (reset != response.header.end())
+			to_return.rate_limit_reset = reset->second;
+	}
+
 	if (response.status_code == 429)
 	{
 		to_return.message = std::move(response.header["X-RateLimit-Reset"]);
@@ -68,32 +166,31 @@ constexpr auto idempotency_key_header{ "Idempotency-Key" };
 constexpr auto authorization_key_header{ "Authorization" };
 net_response simple_post(const std::string_view url, const std::string_view access_token)
 {
-	return handle_response(
-		cpr::Post(cpr::Url{ url },
-			cpr::Header{ { idempotency_key_header, std::string{ ensure_small_string(url) } } ,
-						 { authorization_key_header, make_bearer(access_token) } }
-		)
-	);
+	pooled_session session{ url, request_kind::post };
+	session->SetUrl(cpr::Url{ url });
+	session->SetHeader(cpr::Header{ { idempotency_key_header, std::string{ ensure_small_string(url) } } ,
+						 { authorization_key_header, make_bearer(access_token) } });
+	return handle_response(session->Post());
 }
 
 net_response simple_delete(const std::string_view url, const std::string_view access_token)
 {
-	return handle_response(
-		cpr::Delete(cpr::Url{ url },
-			cpr::Header{ {authorization_key_header, make_bearer(access_token) } })
-	);
+	pooled_session session{ url, request_kind::del };
+	session->SetUrl(cpr::Url{ url });
+	session->SetHeader(cpr::Header{ {authorization_key_header, make_bearer(access_token) } });
+	return handle_response(session->Delete());
 }
 
 net_response upload_media(std::string_view url, std::string_view access_token, const fs::path& file, const std::string& description)
 {
-	return handle_response(
-		cpr::Post(cpr::Url{ url },
-			cpr::Header{ {authorization_key_header, make_bearer(access_token) } },
-			cpr::Multipart{ { "description", description },
-							{ "file", cpr::File{file.string()} } }
-			// cpr::File won't take a wchar string on Windows or a fs::path, so I think my best bet is to hope that .string()
-			// does whatever it does, and then CPR passes that on to the underlying filesystem unchanged and things will work out.
-	));
+	pooled_session session{ url, request_kind::upload };
+	session->SetUrl(cpr::Url{ url });
+	session->SetHeader(cpr::Header{ {authorization_key_header, make_bearer(access_token) } });
+	// cpr::File won't take a wchar string on Windows or a fs::path, so I think my best bet is to hope that .string()
+	// does whatever it does, and then CPR passes that on to the underlying filesystem unchanged and things will work out.
+	session->SetMultipart(cpr::Multipart{ { "description", description },
+							{ "file", cpr::File{file.string()} } });
+	return handle_response(session->Post());
 }
 
 void add_if_value(cpr::Payload& params, const char* key, const std::string& value)
@@ -124,11 +221,12 @@ net_response new_status(std::string_view url, std::string_view access_token, con
 	add_array(post_params, "media_ids[]", params.attachment_ids);
 
 
-	return handle_response(
-		cpr::Post(cpr::Url{ url },
-			cpr::Header{ { idempotency_key_header, std::to_string(params.idempotency_key) },
-						 { authorization_key_header, make_bearer(access_token) } },
-			std::move(post_params)));
+	pooled_session session{ url, request_kind::status };
+	session->SetUrl(cpr::Url{ url });
+	session->SetHeader(cpr::Header{ { idempotency_key_header, std::to_string(params.idempotency_key) },
+						 { authorization_key_header, make_bearer(access_token) } });
+	session->SetPayload(std::move(post_params));
+	return handle_response(session->Post());
 }
 
 void add_if_value(cpr::Parameters& params, const char* key, const std::string_view value)
@@ -155,10 +253,9 @@ net_response get_timeline_and_notifs(std::string_view url, std::string_view acce
 
 	if (params.exclude_notifs != nullptr) { add_array(query_params, "exclude_types[]", *params.exclude_notifs); }
 
-	return handle_response(
-		cpr::Get(cpr::Url{ url },
-			cpr::Header{ {authorization_key_header, make_bearer(access_token) } },
-			std::move(query_params)
-		)
-	);
+	pooled_session session{ url, request_kind::get };
+	session->SetUrl(cpr::Url{ url });
+	session->SetHeader(cpr::Header{ {authorization_key_header, make_bearer(access_token) } });
+	session->SetParameters(std::move(query_params));
+	return handle_response(session->Get());
 }
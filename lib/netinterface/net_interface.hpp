@@ -13,6 +13,10 @@ struct net_response
 	bool retryable_error = false;
 	bool okay = true;
 	std::string message;
+	// from the X-RateLimit headers. rate_limit is 0 if the server didn't send them.
+	int rate_limit = 0;
+	int rate_limit_remaining = 0;
+	std::string rate_limit_reset;
 };
 
 struct status_params
@@ -35,4 +35,36 @@ sync_settings parse_enum<sync_settings>(const char first)
 	}
 
 	throw msync_exception("No sync_setting starting with "s + first);
-}
\ No newline at end of file
+}
+
+template <>
+list_format parse_enum<list_format>(const char first)
+{
+	switch (first)
+	{
+	case 't':
+		return list_format::text;
+	case 'j':
+		return list_format::jsonl;
+	case 'b':
+		return list_format::binary;
+	}
+
+	throw msync_exception("No list_format starting with "s + first);
+}
+
+template <>
+list_segments parse_enum<list_segments>(const char first)
+{
+	switch (first)
+	{
+	case 'o':
+		return list_segments::off;
+	case 'm':
+		return list_segments::monthly;
+	case 's':
+		return list_segments::size;
+	}
+
+	throw msync_exception("No list_segments starting with "s + first);
+}
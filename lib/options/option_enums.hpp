@@ -30,6 +30,32 @@ constexpr auto SYNC_SETTING_NAMES =
 			   static_cast<int>(sync_settings::oldest_first) + 1>(
 		{"dont_sync", "newest_first", "oldest_first"});
 
+// how post_list writes an account's timelines
+enum class list_format
+{
+	text,
+	jsonl,
+	binary
+};
+
+constexpr auto LIST_FORMAT_NAMES =
+	std::array<std::string_view,
+			   static_cast<int>(list_format::binary) + 1>(
+		{"text", "jsonl", "binary"});
+
+// whether post_list splits the home timeline and notifications into a file per month or per so many bytes
+enum class list_segments
+{
+	off,
+	monthly,
+	size
+};
+
+constexpr auto LIST_SEGMENTS_NAMES =
+	std::array<std::string_view,
+			   static_cast<int>(list_segments::size) + 1>(
+		{"off", "monthly", "size"});
+
 enum class user_option
 {
 	file_version,
@@ -53,14 +79,17 @@ enum class user_option
 	pull_dms,
 	pull_bookmarks,
 	pull_notifications,
+	list_format,
+	list_segments,
 };
 
 constexpr auto USER_OPTION_NAMES =
 	std::array<std::string_view,
-			   static_cast<int>(user_option::pull_notifications) + 1>(
+			   static_cast<int>(user_option::list_segments) + 1>(
 		{"file_version", "account_name", "instance_url", "auth_code", "access_token", "client_secret", "client_id",
 				   "last_home_id", "last_dm_id", "last_bookmark_id", "last_notification_id", 
 				   "is_default",
 				   "exclude_follows", "exclude_favs", "exclude_boosts", "exclude_mentions", "exclude_polls",
-		 "pull_home", "pull_dms", "pull_bookmarks", "pull_notifications"});
+		 "pull_home", "pull_dms", "pull_bookmarks", "pull_notifications",
+		 "list_format", "list_segments"});
 #endif
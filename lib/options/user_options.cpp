@@ -66,6 +66,22 @@ bool user_options::get_bool_option(user_option toget) const
 	return firstchar == 't' || firstchar == 'T' || firstchar == 'y' || firstchar == 'Y';
 }
 
+list_format user_options::get_list_format() const
+{
+	const auto val = backing.parsed.find(USER_OPTION_NAMES[static_cast<size_t>(user_option::list_format)]);
+	if (val == backing.parsed.end() || val->second.empty())
+		return list_format::text;
+	return parse_enum<list_format>(val->second[0]);
+}
+
+list_segments user_options::get_list_segments() const
+{
+	const auto val = backing.parsed.find(USER_OPTION_NAMES[static_cast<size_t>(user_option::list_segments)]);
+	if (val == backing.parsed.end() || val->second.empty())
+		return list_segments::off;
+	return parse_enum<list_segments>(val->second[0]);
+}
+
 const fs::path& user_options::get_user_directory() const
 {
 	return user_directory;
@@ -89,6 +105,17 @@ void user_options::set_option(user_option opt, sync_settings value)
 	backing.parsed.insert_or_assign(std::string{ USER_OPTION_NAMES[static_cast<size_t>(opt)] }, std::string{ SYNC_SETTING_NAMES[static_cast<size_t>(value)] });
 }
 
+void user_options::set_option(user_option opt, list_format value)
+{
+	backing.should_save_back = true;
+	backing.parsed.insert_or_assign(std::string{ USER_OPTION_NAMES[static_cast<size_t>(opt)] }, std::string{ LIST_FORMAT_NAMES[static_cast<size_t>(value)] });
+}
+
+void user_options::set_option(user_option opt, list_segments value)
+{
+	backing.should_save_back = true;
+	backing.parsed.insert_or_assign(std::string{ USER_OPTION_NAMES[static_cast<size_t>(opt)] }, std::string{ LIST_SEGMENTS_NAMES[static_cast<size_t>(value)] });
+}
 
 // I have to call it set_bool_option or else c++ will try to use this overload with char* string literals
 void user_options::set_bool_option(user_option opt, bool value)
@@ -100,4 +127,8 @@ void user_options::set_bool_option(user_option opt, bool value)
 	backing.parsed.insert_or_assign(std::string{ USER_OPTION_NAMES[static_cast<size_t>(opt)] }, std::string{ value ? true_sv : false_sv });
 }
 
-
+void user_options::save()
+{
+	if (backing.should_save_back)
+		backing.save();
+}
@@ -16,14 +16,21 @@ public:
 	const std::string& get_option(user_option toget) const;
 	sync_settings get_sync_option(user_option toget) const;
 	bool get_bool_option(user_option toget) const;
+	list_format get_list_format() const;
+	list_segments get_list_segments() const;
 
 	const fs::path& get_user_directory() const;
 
 	void set_option(user_option toset, std::string value);
 	void set_option(user_option toset, list_operations value);
 	void set_option(user_option toset, sync_settings value);
+	void set_option(user_option toset, list_format value);
+	void set_option(user_option toset, list_segments value);
 	void set_bool_option(user_option toset, bool value);
 
+	// write any changes out now instead of when this is destroyed
+	void save();
+
 
 private:
 	const fs::path user_directory;
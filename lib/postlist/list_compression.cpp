@@ -0,0 +1,185 @@
+#include "list_compression.hpp"
+
+#include "list_segments.hpp"
+#include "post_index.hpp"
+
+#include <msync_exception.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#if MSYNC_USE_ZLIB
+#include <zlib.h>
+#endif
+
+constexpr size_t Chunk_Size = 64 * 1024;
+
+bool can_compress()
+{
+#if MSYNC_USE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+fs::path compressed_file_for(const fs::path& segment)
+{
+	return fs::path(segment).concat(".gz");
+}
+
+#if MSYNC_USE_ZLIB
+bool gzip(std::istream& in, std::ostream& out)
+{
+	z_stream stream{};
+	// the +16 is what tells zlib to write a gzip header instead of a zlib one
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	std::vector<char> input(Chunk_Size);
+	std::vector<char> output(Chunk_Size);
+
+	int flush = Z_NO_FLUSH;
+	do
+	{
+		in.read(input.data(), input.size());
+		stream.next_in = reinterpret_cast<Bytef*>(input.data());
+		stream.avail_in = static_cast<uInt>(in.gcount());
+		flush = in ? Z_NO_FLUSH : Z_FINISH;
+
+		do
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(output.data());
+			stream.avail_out = static_cast<uInt>(output.size());
+			deflate(&stream, flush);
+			out.write(output.data(), output.size() - stream.avail_out);
+		} while (stream.avail_out == 0);
+	} while (flush != Z_FINISH);
+
+	deflateEnd(&stream);
+	return in.eof() && out.good();
+}
+
+bool gunzip(std::istream& in, std::string& out)
+{
+	z_stream stream{};
+	// +32 detects whether it's gzip or zlib from the header
+	if (inflateInit2(&stream, 15 + 32) != Z_OK)
+		return false;
+
+	std::vector<char> input(Chunk_Size);
+	std::vector<char> output(Chunk_Size);
+
+	int result = Z_OK;
+	while (in.read(input.data(), input.size()) || in.gcount() > 0)
+	{
+		stream.next_in = reinterpret_cast<Bytef*>(input.data());
+		stream.avail_in = static_cast<uInt>(in.gcount());
+
+		do
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(output.data());
+			stream.avail_out = static_cast<uInt>(output.size());
+			result = inflate(&stream, Z_NO_FLUSH);
+			if (result == Z_NEED_DICT || result == Z_DATA_ERROR || result == Z_MEM_ERROR || result == Z_STREAM_ERROR)
+			{
+				inflateEnd(&stream);
+				return false;
+			}
+			out.append(output.data(), output.size() - stream.avail_out);
+
+			// gzip files can be stuck together with cat, so keep going if there's more after the end of one
+			if (result == Z_STREAM_END && stream.avail_in > 0)
+				inflateReset(&stream);
+		} while (stream.avail_out == 0 || stream.avail_in > 0);
+	}
+
+	inflateEnd(&stream);
+	return result == Z_STREAM_END;
+}
+#else
+bool gzip(std::istream&, std::ostream&)
+{
+	return false;
+}
+
+bool gunzip(std::istream&, std::string&)
+{
+	return false;
+}
+#endif
+
+bool compress_segment(const fs::path& segment)
+{
+	const fs::path compressed = compressed_file_for(segment);
+	const fs::path partial = fs::path(compressed).concat(".partial");
+
+	{
+		std::ifstream in{ segment.c_str(), std::ios::binary };
+		std::ofstream out{ partial.c_str(), std::ios::binary | std::ios::trunc };
+		const bool compressed_all = in.is_open() && gzip(in, out);
+
+		// the last of it isn't written until the file's closed, and if that doesn't work (say, the disk is full),
+		// the .gz would be cut off and the original would be gone
+		out.close();
+		if (!compressed_all || out.fail())
+		{
+			fs::remove(partial);
+			return false;
+		}
+	}
+
+	fs::rename(partial, compressed);
+	fs::remove(segment);
+	return true;
+}
+
+void compress_finished_segments(const fs::path& list_file)
+{
+	if (!can_compress())
+		return;
+
+	const std::vector<fs::path> segments = read_segments(list_file);
+	for (auto segment = segments.begin(); segment + 1 < segments.end(); ++segment)
+	{
+		// already done
+		if (!fs::exists(*segment))
+			continue;
+
+		// the index points into the decompressed text, so it can't be caught up once it's compressed.
+		// only text lists have indexes, so don't make one if there isn't one already.
+		if (fs::exists(index_file_for(*segment)))
+		{
+			const post_index caught_up{ *segment };
+		}
+
+		compress_segment(*segment);
+	}
+}
+
+std::string read_segment(const fs::path& segment)
+{
+	std::string text;
+
+	std::ifstream plain{ segment.c_str(), std::ios::binary };
+	if (plain.is_open())
+	{
+		text.assign(std::istreambuf_iterator<char>(plain), std::istreambuf_iterator<char>());
+		return text;
+	}
+
+	const fs::path compressed_file = compressed_file_for(segment);
+	std::ifstream compressed{ compressed_file.c_str(), std::ios::binary };
+	if (!compressed.is_open())
+		return text;
+
+	// half a segment would have the index pointing past the end of it, so don't hand back anything
+	if (!can_compress())
+		throw msync_exception(to_utf8(compressed_file) + " is compressed, but this copy of msync was built without zlib, so it can't read it.");
+
+	if (!gunzip(compressed, text))
+		throw msync_exception(to_utf8(compressed_file) + " couldn't be decompressed. It might have been cut off or corrupted.");
+
+	return text;
+}
@@ -0,0 +1,36 @@
+#ifndef LIST_COMPRESSION_HPP
+#define LIST_COMPRESSION_HPP
+
+#include <filesystem.hpp>
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+// once a list's been split up (see list_segments.hpp), the segments before the newest one don't change anymore,
+// so they get gzipped: home.2026-09.list turns into home.2026-09.list.gz. the manifest still says home.2026-09.list,
+// and the index stays home.2026-09.list.idx, pointing into the text once it's decompressed.
+
+// false if msync was built without zlib, in which case nothing gets compressed and the functions below just fail
+bool can_compress();
+
+fs::path compressed_file_for(const fs::path& segment);
+
+// streams in through a gzip compressor to out, a chunk at a time
+bool gzip(std::istream& in, std::ostream& out);
+
+// decompresses all of in onto the end of out. false if in isn't gzipped or was cut off.
+bool gunzip(std::istream& in, std::string& out);
+
+// replaces segment with segment.gz. segment is only removed once the compressed copy is all written.
+bool compress_segment(const fs::path& segment);
+
+// compresses every segment of list_file except the newest, making sure their indexes are caught up first.
+// does nothing if list_file hasn't been split up.
+void compress_finished_segments(const fs::path& list_file);
+
+// what's in a segment, whether it's been compressed or not. empty if it isn't there either way.
+// throws msync_exception if it's compressed and can't be decompressed, or if msync was built without zlib.
+std::string read_segment(const fs::path& segment);
+
+#endif
@@ -0,0 +1,131 @@
+#include "list_segments.hpp"
+
+#include "post_index.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <fstream>
+
+fs::path manifest_for(const fs::path& list_file)
+{
+	return fs::path(list_file).concat(".segments");
+}
+
+fs::path segment_file(const fs::path& list_file, std::string_view key)
+{
+	fs::path name = list_file.stem();
+	name += ".";
+	name += std::string{ key };
+	name += list_file.extension();
+	return list_file.parent_path() / name;
+}
+
+std::string segment_key(const fs::path& list_file, const fs::path& segment)
+{
+	const std::string name = to_utf8(segment.filename());
+	const std::string prefix = to_utf8(list_file.stem()) + '.';
+	const std::string suffix = to_utf8(list_file.extension());
+
+	if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+		return {};
+
+	return name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+}
+
+std::vector<fs::path> read_segments(const fs::path& list_file)
+{
+	std::vector<fs::path> segments;
+
+	std::ifstream manifest{ manifest_for(list_file).c_str() };
+	std::string line;
+	while (std::getline(manifest, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (!line.empty())
+			segments.push_back(list_file.parent_path() / fs::path(line));
+	}
+
+	if (segments.empty())
+		segments.push_back(list_file);
+
+	return segments;
+}
+
+bool is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+std::string_view month_key(std::string_view created_at)
+{
+	if (created_at.size() < 7 || created_at[4] != '-')
+		return {};
+
+	const std::string_view month = created_at.substr(0, 7);
+	for (const size_t i : { 0, 1, 2, 3, 5, 6 })
+	{
+		if (!is_digit(month[i]))
+			return {};
+	}
+
+	return month;
+}
+
+std::string current_month_key()
+{
+	const std::time_t now = std::time(nullptr);
+	std::tm utc{};
+#ifdef _WIN32
+	gmtime_s(&utc, &now);
+#else
+	gmtime_r(&now, &utc);
+#endif
+
+	std::string key = std::to_string(utc.tm_year + 1900);
+	const std::string month = std::to_string(utc.tm_mon + 1);
+	key += month.size() < 2 ? "-0" : "-";
+	key += month;
+	return key;
+}
+
+std::string next_numbered_key(const fs::path& list_file)
+{
+	unsigned int highest = 0;
+	for (const fs::path& segment : read_segments(list_file))
+	{
+		const std::string key = segment_key(list_file, segment);
+		if (key.empty() || !std::all_of(key.begin(), key.end(), is_digit))
+			continue;
+
+		unsigned int number = 0;
+		std::from_chars(key.data(), key.data() + key.size(), number);
+		highest = std::max(highest, number);
+	}
+
+	// padded so they sort in order in a directory listing
+	std::string next = std::to_string(highest + 1);
+	if (next.size() < 4)
+		next.insert(0, 4 - next.size(), '0');
+	return next;
+}
+
+void add_segment(const fs::path& list_file, const fs::path& segment)
+{
+	const fs::path manifest_file = manifest_for(list_file);
+	const bool new_manifest = !fs::exists(manifest_file);
+
+	if (new_manifest && fs::exists(list_file) && fs::file_size(list_file) == 0)
+	{
+		fs::remove(list_file);
+		fs::remove(index_file_for(list_file));
+	}
+
+	std::ofstream manifest{ manifest_file.c_str(), std::ios::app };
+	if (new_manifest && fs::exists(list_file))
+		manifest << to_utf8(list_file.filename()) << '\n';
+
+	manifest << to_utf8(segment.filename()) << '\n';
+}
@@ -0,0 +1,50 @@
+#ifndef LIST_SEGMENTS_HPP
+#define LIST_SEGMENTS_HPP
+
+#include <filesystem.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../options/option_enums.hpp"
+
+// splitting a list up means home.list turns into home.2026-09.list, home.2026-10.list, and so on (or home.0001.list, home.0002.list by size),
+// plus a manifest called home.list.segments that lists them, one file name per line, oldest first.
+// only the last segment in the manifest is ever written to; the rest are done and don't change again.
+
+// how big a segment gets before the next one's started, when splitting by size
+constexpr uint64_t Default_Segment_Bytes = 64 * 1024 * 1024;
+
+struct segment_policy
+{
+	list_segments by = list_segments::off;
+	uint64_t max_bytes = Default_Segment_Bytes;
+};
+
+fs::path manifest_for(const fs::path& list_file);
+
+// home.list and 2026-10 make home.2026-10.list
+fs::path segment_file(const fs::path& list_file, std::string_view key);
+
+// the other way around: home.2026-10.list gives back 2026-10. list_file itself, from before it was split up, gives back an empty string.
+std::string segment_key(const fs::path& list_file, const fs::path& segment);
+
+// every segment of list_file, oldest first. if list_file has never been split up, that's just list_file.
+std::vector<fs::path> read_segments(const fs::path& list_file);
+
+// the 2026-10 from a created_at like 2026-10-18T04:25:29.000Z, or nothing if it doesn't start with a year and month
+std::string_view month_key(std::string_view created_at);
+
+// the month it is now in UTC, as a key like 2026-10
+std::string current_month_key();
+
+// the key for the segment after the highest numbered one so far, like 0001 if there aren't any
+std::string next_numbered_key(const fs::path& list_file);
+
+// puts segment on the end of list_file's manifest, making one if there isn't one yet.
+// when the manifest is made, whatever's already in list_file is kept as the first segment. if it's empty, it's removed instead.
+void add_segment(const fs::path& list_file, const fs::path& segment);
+
+#endif
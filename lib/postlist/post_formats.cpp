@@ -0,0 +1,463 @@
+#include "post_formats.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+using namespace std::string_view_literals;
+
+void append_json_string(std::string& out, std::string_view str)
+{
+	static constexpr char hex_digits[] = "0123456789abcdef";
+
+	out += '"';
+	for (const char c : str)
+	{
+		switch (c)
+		{
+		case '"': out += "\\\""sv; break;
+		case '\\': out += "\\\\"sv; break;
+		case '\n': out += "\\n"sv; break;
+		case '\r': out += "\\r"sv; break;
+		case '\t': out += "\\t"sv; break;
+		case '\b': out += "\\b"sv; break;
+		case '\f': out += "\\f"sv; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				out += "\\u00"sv;
+				out += hex_digits[c >> 4];
+				out += hex_digits[c & 0xF];
+			}
+			else
+			{
+				out += c;
+			}
+		}
+	}
+	out += '"';
+}
+
+// "key":
+void append_json_key(std::string& out, std::string_view key)
+{
+	out += '"';
+	out += key;
+	out += "\":"sv;
+}
+
+void append_json_field(std::string& out, std::string_view key, std::string_view value)
+{
+	append_json_key(out, key);
+	append_json_string(out, value);
+	out += ',';
+}
+
+void append_json_field(std::string& out, std::string_view key, bool value)
+{
+	append_json_key(out, key);
+	out += value ? "true,"sv : "false,"sv;
+}
+
+void append_json_field(std::string& out, std::string_view key, long long value)
+{
+	append_json_key(out, key);
+	out += std::to_string(value);
+	out += ',';
+}
+
+// the fields all end in a comma, which is easier than keeping track of whether each one is last
+void close_json_object(std::string& out)
+{
+	if (out.back() == ',')
+		out.back() = '}';
+	else
+		out += '}';
+}
+
+void append_json(std::string& out, const mastodon_account& account)
+{
+	out += '{';
+	append_json_field(out, "account_name"sv, account.account_name);
+	append_json_field(out, "display_name"sv, account.display_name);
+	append_json_field(out, "is_bot"sv, account.is_bot);
+	close_json_object(out);
+}
+
+void append_json(std::string& out, const mastodon_poll& poll)
+{
+	out += '{';
+	append_json_field(out, "id"sv, poll.id);
+	append_json_field(out, "expires_at"sv, poll.expires_at);
+	append_json_field(out, "expired"sv, poll.expired);
+	append_json_field(out, "total_votes"sv, static_cast<long long>(poll.total_votes));
+	append_json_field(out, "you_voted"sv, poll.you_voted);
+
+	append_json_key(out, "voted_for"sv);
+	out += '[';
+	for (const int voted : poll.voted_for)
+	{
+		out += std::to_string(voted);
+		out += ',';
+	}
+	if (out.back() == ',') { out.pop_back(); }
+	out += "],"sv;
+
+	append_json_key(out, "options"sv);
+	out += '[';
+	for (const auto& option : poll.options)
+	{
+		out += '{';
+		append_json_field(out, "title"sv, option.title);
+		append_json_field(out, "votes"sv, static_cast<long long>(option.votes));
+		close_json_object(out);
+		out += ',';
+	}
+	if (out.back() == ',') { out.pop_back(); }
+	out += ']';
+
+	out += '}';
+}
+
+void append_json(std::string& out, const mastodon_status& status)
+{
+	out += '{';
+	append_json_field(out, "id"sv, status.id);
+	append_json_field(out, "url"sv, status.url);
+	append_json_field(out, "created_at"sv, status.created_at);
+	append_json_field(out, "visibility"sv, status.visibility);
+	append_json_field(out, "content_warning"sv, status.content_warning);
+	append_json_field(out, "content"sv, status.content);
+	append_json_field(out, "reply_to_post_id"sv, status.reply_to_post_id);
+	append_json_field(out, "original_post_url"sv, status.original_post_url);
+	append_json_field(out, "original_post_id"sv, status.original_post_id);
+	append_json_field(out, "boosted_by"sv, status.boosted_by);
+	append_json_field(out, "boosted_by_display_name"sv, status.boosted_by_display_name);
+	append_json_field(out, "boosted_by_bot"sv, status.boosted_by_bot);
+	append_json_field(out, "boosted_at"sv, status.boosted_at);
+	append_json_field(out, "favorites"sv, static_cast<long long>(status.favorites));
+	append_json_field(out, "boosts"sv, static_cast<long long>(status.boosts));
+	append_json_field(out, "replies"sv, static_cast<long long>(status.replies));
+
+	append_json_key(out, "author"sv);
+	append_json(out, status.author);
+	out += ',';
+
+	append_json_key(out, "attachments"sv);
+	out += '[';
+	for (const auto& attachment : status.attachments)
+	{
+		out += '{';
+		append_json_field(out, "url"sv, attachment.url);
+		append_json_field(out, "description"sv, attachment.description);
+		close_json_object(out);
+		out += ',';
+	}
+	if (out.back() == ',') { out.pop_back(); }
+	out += "],"sv;
+
+	append_json_key(out, "poll"sv);
+	if (status.poll.has_value())
+		append_json(out, *status.poll);
+	else
+		out += "null"sv;
+
+	out += '}';
+}
+
+std::string_view api_name(notif_type type)
+{
+	switch (type)
+	{
+	case notif_type::follow:
+		return "follow"sv;
+	case notif_type::mention:
+		return "mention"sv;
+	case notif_type::boost:
+		return "reblog"sv;
+	case notif_type::favorite:
+		return "favourite"sv;
+	case notif_type::poll:
+		return "poll"sv;
+	default:
+		return "unknown"sv;
+	}
+}
+
+void append_jsonl(std::string& out, const mastodon_status& status)
+{
+	append_json(out, status);
+	out += '\n';
+}
+
+void append_jsonl(std::string& out, const mastodon_notification& notification)
+{
+	out += '{';
+	append_json_field(out, "id"sv, notification.id);
+	append_json_field(out, "type"sv, api_name(notification.type));
+	append_json_field(out, "created_at"sv, notification.created_at);
+
+	append_json_key(out, "account"sv);
+	append_json(out, notification.account);
+	out += ',';
+
+	append_json_key(out, "status"sv);
+	if (notification.status.has_value())
+		append_json(out, *notification.status);
+	else
+		out += "null"sv;
+
+	out += "}\n"sv;
+}
+
+void append_uint32(std::string& out, uint32_t value)
+{
+	// always little endian, no matter what this is running on
+	out += static_cast<char>(value & 0xFF);
+	out += static_cast<char>((value >> 8) & 0xFF);
+	out += static_cast<char>((value >> 16) & 0xFF);
+	out += static_cast<char>((value >> 24) & 0xFF);
+}
+
+void append_binary_string(std::string& out, std::string_view str)
+{
+	append_uint32(out, static_cast<uint32_t>(str.size()));
+	out += str;
+}
+
+void append_binary(std::string& out, const mastodon_account& account)
+{
+	append_binary_string(out, account.account_name);
+	append_binary_string(out, account.display_name);
+	out += static_cast<char>(account.is_bot);
+}
+
+void append_status_fields(std::string& out, const mastodon_status& status)
+{
+	append_binary_string(out, status.id);
+	append_binary_string(out, status.url);
+	append_binary_string(out, status.created_at);
+	append_binary_string(out, status.visibility);
+	append_binary_string(out, status.content_warning);
+	append_binary_string(out, status.content);
+	append_binary_string(out, status.reply_to_post_id);
+	append_binary_string(out, status.original_post_url);
+	append_binary_string(out, status.original_post_id);
+	append_binary_string(out, status.boosted_by);
+	append_binary_string(out, status.boosted_by_display_name);
+	out += static_cast<char>(status.boosted_by_bot);
+	append_binary_string(out, status.boosted_at);
+	append_uint32(out, status.favorites);
+	append_uint32(out, status.boosts);
+	append_uint32(out, status.replies);
+	append_binary(out, status.author);
+
+	append_uint32(out, static_cast<uint32_t>(status.attachments.size()));
+	for (const auto& attachment : status.attachments)
+	{
+		append_binary_string(out, attachment.url);
+		append_binary_string(out, attachment.description);
+	}
+
+	out += static_cast<char>(status.poll.has_value());
+	if (status.poll.has_value())
+	{
+		const mastodon_poll& poll = *status.poll;
+		append_binary_string(out, poll.id);
+		append_binary_string(out, poll.expires_at);
+		out += static_cast<char>(poll.expired);
+		append_uint32(out, static_cast<uint32_t>(poll.total_votes));
+		out += static_cast<char>(poll.you_voted);
+		append_uint32(out, static_cast<uint32_t>(poll.voted_for.size()));
+		for (const int voted : poll.voted_for)
+			append_uint32(out, static_cast<uint32_t>(voted));
+		append_uint32(out, static_cast<uint32_t>(poll.options.size()));
+		for (const auto& option : poll.options)
+		{
+			append_binary_string(out, option.title);
+			append_uint32(out, static_cast<uint32_t>(option.votes));
+		}
+	}
+}
+
+// leaves room for the length at the front and fills it in once the record's done
+template <typename Fields>
+void append_record(std::string& out, unsigned char kind, Fields fields)
+{
+	const size_t length_at = out.size();
+	append_uint32(out, 0);
+	out += static_cast<char>(kind);
+	fields();
+
+	const auto length = static_cast<uint32_t>(out.size() - length_at - 4);
+	std::string length_bytes;
+	append_uint32(length_bytes, length);
+	out.replace(length_at, 4, length_bytes);
+}
+
+void append_binary(std::string& out, const mastodon_status& status)
+{
+	append_record(out, Binary_Status_Record, [&]() { append_status_fields(out, status); });
+}
+
+void append_binary(std::string& out, const mastodon_notification& notification)
+{
+	append_record(out, Binary_Notification_Record, [&]()
+	{
+		append_binary_string(out, notification.id);
+		out += static_cast<char>(notification.type);
+		append_binary_string(out, notification.created_at);
+		append_binary(out, notification.account);
+		out += static_cast<char>(notification.status.has_value());
+		if (notification.status.has_value())
+			append_status_fields(out, *notification.status);
+	});
+}
+
+// reads fields back out of one record. if the record's too short for what's being read, everything after that comes back empty and okay is false.
+struct binary_reader
+{
+	std::string_view record;
+	bool okay = true;
+
+	std::string_view take(size_t count)
+	{
+		if (record.size() < count)
+		{
+			okay = false;
+			record = {};
+			return {};
+		}
+		const auto taken = record.substr(0, count);
+		record.remove_prefix(count);
+		return taken;
+	}
+
+	uint32_t number()
+	{
+		const auto bytes = take(4);
+		if (bytes.size() != 4) { return 0; }
+		return static_cast<uint32_t>(static_cast<unsigned char>(bytes[0])) |
+			(static_cast<uint32_t>(static_cast<unsigned char>(bytes[1])) << 8) |
+			(static_cast<uint32_t>(static_cast<unsigned char>(bytes[2])) << 16) |
+			(static_cast<uint32_t>(static_cast<unsigned char>(bytes[3])) << 24);
+	}
+
+	bool flag()
+	{
+		const auto byte = take(1);
+		return !byte.empty() && byte[0] != 0;
+	}
+
+	std::string string()
+	{
+		return std::string{ take(number()) };
+	}
+};
+
+void read_account(binary_reader& in, mastodon_account& account)
+{
+	account.account_name = in.string();
+	account.display_name = in.string();
+	account.is_bot = in.flag();
+}
+
+void read_status_fields(binary_reader& in, mastodon_status& status)
+{
+	status.id = in.string();
+	status.url = in.string();
+	status.created_at = in.string();
+	status.visibility = in.string();
+	status.content_warning = in.string();
+	status.content = in.string();
+	status.reply_to_post_id = in.string();
+	status.original_post_url = in.string();
+	status.original_post_id = in.string();
+	status.boosted_by = in.string();
+	status.boosted_by_display_name = in.string();
+	status.boosted_by_bot = in.flag();
+	status.boosted_at = in.string();
+	status.favorites = in.number();
+	status.boosts = in.number();
+	status.replies = in.number();
+	read_account(in, status.author);
+
+	// these stop as soon as the record runs out, so a bad count can't run away
+	const uint32_t attachments = in.number();
+	for (uint32_t i = 0; i < attachments && in.okay; i++)
+	{
+		auto& attachment = status.attachments.emplace_back();
+		attachment.url = in.string();
+		attachment.description = in.string();
+	}
+
+	if (in.flag())
+	{
+		mastodon_poll& poll = status.poll.emplace();
+		poll.id = in.string();
+		poll.expires_at = in.string();
+		poll.expired = in.flag();
+		poll.total_votes = static_cast<int>(in.number());
+		poll.you_voted = in.flag();
+		const uint32_t voted_for = in.number();
+		for (uint32_t i = 0; i < voted_for && in.okay; i++)
+			poll.voted_for.push_back(static_cast<int>(in.number()));
+		const uint32_t options = in.number();
+		for (uint32_t i = 0; i < options && in.okay; i++)
+		{
+			auto& option = poll.options.emplace_back();
+			option.title = in.string();
+			option.votes = static_cast<int>(in.number());
+		}
+	}
+}
+
+// the next record of this kind, or an empty string at the end of the stream
+std::string next_record(std::istream& in, unsigned char kind)
+{
+	while (true)
+	{
+		std::string length_bytes(4, '\0');
+		if (!in.read(length_bytes.data(), 4))
+			return {};
+
+		const uint32_t length = binary_reader{ length_bytes }.number();
+		std::string record(length, '\0');
+		if (length == 0 || !in.read(record.data(), length))
+			return {};
+
+		if (static_cast<unsigned char>(record[0]) == kind)
+			return record;
+	}
+}
+
+bool read_binary(std::istream& in, mastodon_status& read_into)
+{
+	const std::string record = next_record(in, Binary_Status_Record);
+	if (record.empty())
+		return false;
+
+	binary_reader reader{ record };
+	reader.take(1);
+	read_into = mastodon_status{};
+	read_status_fields(reader, read_into);
+	return reader.okay;
+}
+
+bool read_binary(std::istream& in, mastodon_notification& read_into)
+{
+	const std::string record = next_record(in, Binary_Notification_Record);
+	if (record.empty())
+		return false;
+
+	binary_reader reader{ record };
+	reader.take(1);
+	read_into = mastodon_notification{};
+	read_into.id = reader.string();
+	const auto type = reader.take(1);
+	read_into.type = type.empty() ? notif_type::unknown : static_cast<notif_type>(type[0]);
+	read_into.created_at = reader.string();
+	read_account(reader, read_into.account);
+	if (reader.flag())
+		read_status_fields(reader, read_into.status.emplace());
+	return reader.okay;
+}
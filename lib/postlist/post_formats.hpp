@@ -0,0 +1,41 @@
+#ifndef POST_FORMATS_HPP
+#define POST_FORMATS_HPP
+
+#include <istream>
+#include <string>
+
+#include "../entities/entities.hpp"
+
+// the other ways post_list can write posts, for when something other than a person is going to read them.
+// these build the whole record up in a string so post_list can write it in one go.
+
+// JSON lines: one JSON object per post, ending with a newline. the keys are named after the fields in entities.hpp,
+// except a notification's type, which uses the same names the Mastodon API does (favourite, reblog, and so on).
+// every key is always there, so a missing poll or notification status is null and an empty string is "".
+void append_jsonl(std::string& out, const mastodon_status& status);
+void append_jsonl(std::string& out, const mastodon_notification& notification);
+
+// a length-prefixed binary format that can be read back without any parsing to speak of.
+// every number is a little endian uint32, and every string is its length as a uint32 followed by that many bytes of UTF-8.
+// each record is its length as a uint32 (not counting the length itself), then a byte saying what it is, then the fields:
+//
+// status (1): id, url, created_at, visibility, content_warning, content, reply_to_post_id, original_post_url, original_post_id,
+//   boosted_by, boosted_by_display_name, boosted_by_bot (byte), boosted_at, favorites, boosts, replies, author (account),
+//   attachment count, then url and description for each, then whether there's a poll (byte), then if there is:
+//   id, expires_at, expired (byte), total_votes, you_voted (byte), voted_for count and each index, option count and each title and votes
+// notification (2): id, type (byte, same order as notif_type), created_at, account, whether there's a status (byte), then the status fields from id onwards
+// account: account_name, display_name, is_bot (byte)
+//
+// a reader that doesn't know about a kind of record can skip it using its length.
+constexpr unsigned char Binary_Status_Record = 1;
+constexpr unsigned char Binary_Notification_Record = 2;
+
+void append_binary(std::string& out, const mastodon_status& status);
+void append_binary(std::string& out, const mastodon_notification& notification);
+
+// reads the next record into read_into, skipping records of the wrong kind.
+// returns false at the end of the stream or if the last record was cut off.
+bool read_binary(std::istream& in, mastodon_status& read_into);
+bool read_binary(std::istream& in, mastodon_notification& read_into);
+
+#endif
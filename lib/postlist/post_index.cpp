@@ -0,0 +1,423 @@
+#include "post_index.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <sstream>
+
+using namespace std::string_view_literals;
+
+// each entry is one line: the id (right aligned, so numeric ids line up), the date, where the post starts, how long it is, and who posted it
+constexpr size_t Id_Width = 40;
+constexpr size_t Created_At_Width = 32;
+constexpr size_t Offset_Width = 20;
+constexpr size_t Length_Width = 12;
+constexpr size_t Author_Width = 96;
+
+constexpr size_t Created_At_Column = Id_Width + 1;
+constexpr size_t Offset_Column = Created_At_Column + Created_At_Width + 1;
+constexpr size_t Length_Column = Offset_Column + Offset_Width + 1;
+constexpr size_t Author_Column = Length_Column + Length_Width + 1;
+constexpr size_t Record_Width = Author_Column + Author_Width + 1;
+
+// the header is the same width as everything else, so entry n starts at Record_Width * (n + 1)
+constexpr std::string_view Header_Prefix = "msync post index 1 "sv;
+constexpr size_t Ids_Sorted_Column = Header_Prefix.size();
+constexpr size_t Times_Sorted_Column = Ids_Sorted_Column + 2;
+
+constexpr std::string_view Separator_Line = "--------------"sv;
+
+uint64_t size_on_disk(std::string_view text)
+{
+	if constexpr (Newline_Bytes == 1)
+		return text.size();
+	return text.size() + std::count(text.begin(), text.end(), '\n') * (Newline_Bytes - 1);
+}
+
+std::string_view listed_at(const mastodon_status& status)
+{
+	return status.boosted_at.empty() ? status.created_at : status.boosted_at;
+}
+
+std::string_view listed_at(const mastodon_notification& notification)
+{
+	return notification.created_at;
+}
+
+index_entry make_index_entry(const mastodon_status& status)
+{
+	return index_entry{ status.id, std::string{ listed_at(status) }, status.author.account_name };
+}
+
+index_entry make_index_entry(const mastodon_notification& notification)
+{
+	return index_entry{ notification.id, std::string{ listed_at(notification) }, notification.account.account_name };
+}
+
+bool id_less(std::string_view a, std::string_view b)
+{
+	if (a.size() != b.size())
+		return a.size() < b.size();
+	return a < b;
+}
+
+std::string_view trim_spaces(std::string_view str)
+{
+	const auto first = str.find_first_not_of(' ');
+	if (first == std::string_view::npos)
+		return {};
+	return str.substr(first, str.find_last_not_of(' ') - first + 1);
+}
+
+uint64_t parse_number(std::string_view str)
+{
+	uint64_t value = 0;
+	std::from_chars(str.data(), str.data() + str.size(), value);
+	return value;
+}
+
+void place_number(std::string& record, size_t column, size_t width, uint64_t value)
+{
+	const auto digits = std::to_string(value);
+	std::fill_n(record.begin() + column, width - digits.size(), '0');
+	std::copy(digits.begin(), digits.end(), record.begin() + column + width - digits.size());
+}
+
+index_entry parse_record(std::string_view record)
+{
+	index_entry entry;
+	entry.id = trim_spaces(record.substr(0, Id_Width));
+	entry.created_at = trim_spaces(record.substr(Created_At_Column, Created_At_Width));
+	entry.offset = parse_number(record.substr(Offset_Column, Offset_Width));
+	entry.length = parse_number(record.substr(Length_Column, Length_Width));
+	entry.author = trim_spaces(record.substr(Author_Column, Author_Width));
+	return entry;
+}
+
+bool starts_with(std::string_view str, std::string_view prefix)
+{
+	return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+// "Display Name (@account@instance.egg) [bot]" -> account@instance.egg
+// display names can have just about anything in them, but account names can't, so work backwards from the end
+std::string_view account_in(std::string_view line)
+{
+	const auto close = line.rfind(')');
+	if (close == std::string_view::npos)
+		return {};
+	const auto open = line.rfind(" (@", close);
+	if (open == std::string_view::npos)
+		return {};
+	return line.substr(open + 3, close - open - 3);
+}
+
+// pulls the id, date, and author back out of a post written by post_list, for catching up with posts that weren't indexed as they were written.
+// see the operator<<s in post_list.cpp for what this is reading.
+void read_fields(std::string_view line, bool first_line, bool& is_notification, index_entry& entry)
+{
+	if (first_line)
+	{
+		if (starts_with(line, "status id: "sv))
+			entry.id = line.substr("status id: "sv.size());
+		else if (starts_with(line, "notification id: "sv))
+		{
+			entry.id = line.substr("notification id: "sv.size());
+			is_notification = true;
+		}
+		return;
+	}
+
+	if (is_notification)
+	{
+		// at 2019-11-14T10:54:00.000Z, Display Name (@account) favorited your post:
+		if (entry.created_at.empty() && starts_with(line, "at "sv))
+		{
+			const auto comma = line.find(", ");
+			entry.created_at = line.substr(3, comma == std::string_view::npos ? std::string_view::npos : comma - 3);
+			if (comma != std::string_view::npos)
+				entry.author = account_in(line.substr(comma));
+		}
+		return;
+	}
+
+	// the author comes before the body, so the first one is the real one.
+	// the date comes after, so the last one is. a boost's comes after the original's, and it's the one the list is in order of.
+	if (entry.author.empty() && starts_with(line, "author: "sv))
+		entry.author = account_in(line);
+	else if (starts_with(line, "posted on: "sv))
+		entry.created_at = line.substr("posted on: "sv.size());
+	else if (starts_with(line, "boosted on: "sv))
+		entry.created_at = line.substr("boosted on: "sv.size());
+}
+
+fs::path index_file_for(const fs::path& list_file)
+{
+	return fs::path(list_file).concat(".idx");
+}
+
+post_index::post_index(const fs::path& list_file)
+{
+	const uint64_t list_size = fs::exists(list_file) ? fs::file_size(list_file) : 0;
+	open(index_file_for(list_file), list_size);
+
+	if (end_of_indexed < list_size)
+	{
+		std::ifstream list{ list_file.c_str(), std::ios::binary };
+		list.seekg(end_of_indexed);
+		add_all(list, end_of_indexed);
+	}
+}
+
+post_index::post_index(const fs::path& list_file, std::string_view list_text)
+{
+	open(index_file_for(list_file), list_text.size());
+
+	if (end_of_indexed < list_text.size())
+	{
+		std::istringstream list{ std::string{ list_text.substr(end_of_indexed) } };
+		add_all(list, end_of_indexed);
+	}
+}
+
+post_index::post_index(const fs::path& list_file, index_as_is)
+{
+	// there's no list size to check it against, so anything it covers is fine
+	open(index_file_for(list_file), std::numeric_limits<uint64_t>::max());
+}
+
+void post_index::open(const fs::path& index_file, uint64_t list_size)
+{
+	bool usable = false;
+	if (fs::exists(index_file))
+	{
+		// a partly written entry at the end from msync being stopped partway through gets dropped, then redone below
+		const uint64_t index_size = fs::file_size(index_file);
+		if (index_size >= Record_Width && index_size % Record_Width != 0)
+			fs::resize_file(index_file, index_size - index_size % Record_Width);
+
+		file.open(index_file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		std::string header(Record_Width, '\0');
+		if (index_size >= Record_Width && file.read(header.data(), Record_Width) && starts_with(header, Header_Prefix))
+		{
+			ids_sorted = header[Ids_Sorted_Column] == '1';
+			times_sorted = header[Times_Sorted_Column] == '1';
+			entries = (index_size / Record_Width) - 1;
+			usable = true;
+
+			if (entries > 0)
+			{
+				const index_entry last = at(entries - 1);
+				end_of_indexed = last.offset + last.length;
+				last_id = last.id;
+				last_created_at = last.created_at;
+			}
+
+			// the list was replaced with something shorter, so none of this is right anymore
+			usable = end_of_indexed <= list_size;
+		}
+		file.close();
+	}
+
+	if (usable)
+	{
+		file.open(index_file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	}
+	else
+	{
+		file.open(index_file.c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+		entries = 0;
+		end_of_indexed = 0;
+		ids_sorted = times_sorted = true;
+		last_id.clear();
+		last_created_at.clear();
+		write_header();
+	}
+}
+
+void post_index::write_header()
+{
+	std::string header(Record_Width, ' ');
+	std::copy(Header_Prefix.begin(), Header_Prefix.end(), header.begin());
+	header[Ids_Sorted_Column] = ids_sorted ? '1' : '0';
+	header[Times_Sorted_Column] = times_sorted ? '1' : '0';
+	header.back() = '\n';
+
+	file.seekp(0);
+	file.write(header.data(), header.size());
+	file.flush();
+}
+
+void post_index::add(const index_entry& entry)
+{
+	end_of_indexed = std::max(end_of_indexed, entry.offset + entry.length);
+
+	if (entry.id.empty() || entry.id.size() > Id_Width || entry.created_at.size() > Created_At_Width)
+		return;
+
+	if (entries > 0 && (ids_sorted || times_sorted))
+	{
+		const bool ids_still_sorted = ids_sorted && !id_less(entry.id, last_id);
+		const bool times_still_sorted = times_sorted && entry.created_at >= last_created_at;
+		if (ids_still_sorted != ids_sorted || times_still_sorted != times_sorted)
+		{
+			ids_sorted = ids_still_sorted;
+			times_sorted = times_still_sorted;
+			write_header();
+		}
+	}
+
+	std::string record(Record_Width, ' ');
+	std::copy(entry.id.begin(), entry.id.end(), record.begin() + Id_Width - entry.id.size());
+	std::copy(entry.created_at.begin(), entry.created_at.end(), record.begin() + Created_At_Column);
+	place_number(record, Offset_Column, Offset_Width, entry.offset);
+	place_number(record, Length_Column, Length_Width, entry.length);
+	if (entry.author.size() <= Author_Width)
+		std::copy(entry.author.begin(), entry.author.end(), record.begin() + Author_Column);
+	record.back() = '\n';
+
+	file.seekp(Record_Width * (entries + 1));
+	file.write(record.data(), record.size());
+	entries++;
+
+	last_id = entry.id;
+	last_created_at = entry.created_at;
+}
+
+void post_index::add_all(std::istream& list_text, uint64_t base)
+{
+	index_entry entry;
+	entry.offset = base;
+	bool first_line = true;
+	bool is_notification = false;
+
+	std::string line;
+	uint64_t position = base;
+	while (std::getline(list_text, line))
+	{
+		// a line at the very end without a newline is a post that's still being written, so leave it for next time
+		if (list_text.eof())
+			break;
+
+		// this is reading in binary mode so the positions come out right, so on Windows, the \r is still there
+		position += line.size() + 1;
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (line == Separator_Line)
+		{
+			entry.length = position - entry.offset;
+			add(entry);
+
+			entry = index_entry{};
+			entry.offset = position;
+			first_line = true;
+			is_notification = false;
+			continue;
+		}
+
+		read_fields(line, first_line, is_notification, entry);
+		first_line = false;
+	}
+
+	file.flush();
+}
+
+index_entry post_index::at(size_t n)
+{
+	std::string record(Record_Width, '\0');
+	file.clear();
+	file.seekg(Record_Width * (n + 1));
+	file.read(record.data(), Record_Width);
+	return parse_record(record);
+}
+
+std::optional<index_entry> post_index::find(std::string_view id)
+{
+	if (ids_sorted)
+	{
+		// binary search right in the file, so this only reads a handful of entries no matter how big it gets
+		size_t low = 0;
+		size_t high = entries;
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (id_less(at(middle).id, id))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		if (low < entries)
+		{
+			index_entry found = at(low);
+			if (found.id == id)
+				return found;
+		}
+		return std::nullopt;
+	}
+
+	for (size_t i = 0; i < entries; i++)
+	{
+		index_entry entry = at(i);
+		if (entry.id == id)
+			return entry;
+	}
+	return std::nullopt;
+}
+
+std::vector<index_entry> post_index::since(std::string_view created_at)
+{
+	std::vector<index_entry> found;
+
+	if (times_sorted)
+	{
+		size_t low = 0;
+		size_t high = entries;
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (at(middle).created_at < created_at)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		for (size_t i = low; i < entries; i++)
+			found.push_back(at(i));
+		return found;
+	}
+
+	for (size_t i = 0; i < entries; i++)
+	{
+		index_entry entry = at(i);
+		if (entry.created_at >= created_at)
+			found.push_back(std::move(entry));
+	}
+	return found;
+}
+
+std::string read_post(const fs::path& list_file, const index_entry& entry)
+{
+	std::ifstream list{ list_file.c_str(), std::ios::binary };
+	return read_post(list, entry);
+}
+
+std::string read_post(std::istream& list, const index_entry& entry)
+{
+	// the separator is a newline, the dashes, and another newline
+	constexpr uint64_t separator_size = Separator_Line.size() + 2 * Newline_Bytes;
+	const uint64_t length = entry.length > separator_size ? entry.length - separator_size : 0;
+
+	list.clear();
+	list.seekg(entry.offset);
+	std::string post(length, '\0');
+	list.read(post.data(), length);
+	post.resize(list.gcount());
+
+	// so it doesn't come out as \r\r\n when it's printed
+	if constexpr (Newline_Bytes == 2)
+		post.erase(std::remove(post.begin(), post.end(), '\r'), post.end());
+
+	return post;
+}
@@ -0,0 +1,114 @@
+#ifndef POST_INDEX_HPP
+#define POST_INDEX_HPP
+
+#include <filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../entities/entities.hpp"
+
+// where one post is in a .list file, and enough about it to find it without reading the file.
+struct index_entry
+{
+	std::string id;
+	std::string created_at;
+	// the account name of whoever posted it, or who the notification is from
+	std::string author;
+	uint64_t offset = 0;
+	// including the separator after it
+	uint64_t length = 0;
+};
+
+// lists are written in text mode, so on Windows, every newline takes up two bytes on disk
+#ifdef _WIN32
+constexpr uint64_t Newline_Bytes = 2;
+#else
+constexpr uint64_t Newline_Bytes = 1;
+#endif
+
+// how much room text takes up once it's written to a list
+uint64_t size_on_disk(std::string_view text);
+
+// when a post showed up in the timeline, which is what lists are in order of. for a boost, that's when it was boosted.
+std::string_view listed_at(const mastodon_status& status);
+std::string_view listed_at(const mastodon_notification& notification);
+
+index_entry make_index_entry(const mastodon_status& status);
+index_entry make_index_entry(const mastodon_notification& notification);
+
+// true if a comes before b. numeric ids sort by length first, so 99 comes before 100.
+bool id_less(std::string_view a, std::string_view b);
+
+// home.list's index is home.list.idx
+fs::path index_file_for(const fs::path& list_file);
+
+// pass this to post_index to open an index without reading the list to catch it up
+struct index_as_is {};
+
+// a sidecar to a .list file with .idx on the end of its name, so msync show and msync list can find posts without reading the whole list.
+// every line in it is the same width, so entry n is always at the same place in the file and lookups can binary search the file itself.
+// the first line says whether the ids and dates have only ever gone up so far, which is what makes binary searching them okay.
+// if they haven't, lookups read the whole index instead, which is still a lot less than reading the whole list.
+class post_index
+{
+public:
+	// opens or makes the index for list_file, then catches it up with anything at the end of list_file it doesn't cover yet,
+	// like posts written by an older msync. if list_file got shorter, the index is rebuilt from scratch.
+	post_index(const fs::path& list_file);
+
+	// the same, for a list that's been compressed, where list_text is what's in it once it's decompressed
+	post_index(const fs::path& list_file, std::string_view list_text);
+
+	// opens list_file's index the way it is, without looking at list_file at all. this is for compressed lists,
+	// which had their indexes caught up before they were compressed. if there's no index, this one comes out empty.
+	post_index(const fs::path& list_file, index_as_is);
+
+	// entry.offset and entry.length should already be filled in.
+	// ids or dates that don't fit in the index's columns are left out, and so is an author name that doesn't fit.
+	void add(const index_entry& entry);
+
+	// adds an entry for each post in list_text, which starts at base in the list file
+	void add_all(std::istream& list_text, uint64_t base);
+
+	// how far into the list file the index goes
+	uint64_t covered() const { return end_of_indexed; }
+
+	size_t size() const { return entries; }
+
+	index_entry at(size_t n);
+
+	// the first post with this id, if there is one
+	std::optional<index_entry> find(std::string_view id);
+
+	// every post made at or after created_at, in the order they're in the list.
+	// created_at is compared as text, which works for Mastodon's ISO 8601 dates, so a prefix like 2020-06 works too.
+	std::vector<index_entry> since(std::string_view created_at);
+
+	post_index(const post_index&) = delete;
+	post_index& operator=(const post_index&) = delete;
+
+private:
+	std::fstream file;
+	size_t entries = 0;
+	uint64_t end_of_indexed = 0;
+	bool ids_sorted = true;
+	bool times_sorted = true;
+	std::string last_id;
+	std::string last_created_at;
+
+	void open(const fs::path& index_file, uint64_t list_size);
+	void write_header();
+};
+
+// the text of the post entry points to, without the separator after it.
+// list should be opened in binary mode.
+std::string read_post(std::istream& list, const index_entry& entry);
+std::string read_post(const fs::path& list_file, const index_entry& entry);
+
+#endif
@@ -1,121 +1,186 @@
 #include "post_list.hpp"
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
 
-void print(std::ostream& out, const char* key, const std::string& val, bool newline = true)
+using namespace std::string_view_literals;
+
+template <typename number>
+void append_number(std::string& out, number n)
+{
+	// apple's stdlib is missing to_chars
+#if __APPLE__ && !defined(__cpp_lib_to_chars)
+	out += std::to_string(n);
+#else
+	std::array<char, 24> buf;
+	const auto [end, err] = std::to_chars(buf.data(), buf.data() + buf.size(), n);
+	out.append(buf.data(), end);
+#endif
+}
+
+// this has to come out exactly the way an ostream with the default settings writes a double, which is printf's %g with six digits
+void append_percent(std::string& out, double percent)
+{
+	std::array<char, 32> buf;
+#if defined(__cpp_lib_to_chars)
+	const auto [end, err] = std::to_chars(buf.data(), buf.data() + buf.size(), percent, std::chars_format::general, 6);
+	out.append(buf.data(), end);
+#else
+	const int written = std::snprintf(buf.data(), buf.size(), "%.6g", percent);
+	out.append(buf.data(), std::min(static_cast<size_t>(written), buf.size() - 1));
+#endif
+}
+
+void print(std::string& out, std::string_view key, const std::string& val, bool newline = true)
 {
 	if (!val.empty())
 	{
-		out << key << val;
+		out += key;
+		out += val;
 		if (newline)
-			out << '\n';
+			out += '\n';
 	}
 }
 
-void print_author(std::ostream& out, const char* key, const std::string& display_name, const std::string& account, bool bot, bool newline = true)
-{ 
+void print_author(std::string& out, std::string_view key, const std::string& display_name, const std::string& account, bool bot, bool newline = true)
+{
 	// this is so that posts that aren't boosts don't print that boosted_by section
 	if (account.empty()) { return; }
 
-	out << key << display_name << " (@" << account << ')';
+	out += key;
+	out += display_name;
+	out += " (@"sv;
+	out += account;
+	out += ')';
 
-	if (bot) out << " [bot]";
+	if (bot) out += " [bot]"sv;
 
-	if (newline) out << '\n';
+	if (newline) out += '\n';
 }
 
-void print(std::ostream& out, const char* key, bool val, bool newline = true)
+void append_text(std::string& out, const mastodon_poll& poll)
 {
-	if (val)
-	{
-		out << key;
-		if (newline)
-			out << '\n';
-	}
-}
-
-std::ostream& operator<<(std::ostream& out, const mastodon_poll& poll)
-{
-	print(out, "poll id: ", poll.id);
-	print(out, poll.expired ? "expired at: " : "expires at: ", poll.expires_at);
+	print(out, "poll id: "sv, poll.id);
+	print(out, poll.expired ? "expired at: "sv : "expires at: "sv, poll.expires_at);
 	for (size_t i = 0; i < poll.options.size(); ++i)
 	{
-		out << " - " << poll.options[i].title << ' ' << 
-			poll.options[i].votes << '/' << poll.total_votes << " votes (" << (poll.total_votes == 0 ? 0 : ((double)poll.options[i].votes / poll.total_votes) * 100) << "%)";
+		out += " - "sv;
+		out += poll.options[i].title;
+		out += ' ';
+		append_number(out, poll.options[i].votes);
+		out += '/';
+		append_number(out, poll.total_votes);
+		out += " votes ("sv;
+		append_percent(out, poll.total_votes == 0 ? 0 : ((double)poll.options[i].votes / poll.total_votes) * 100);
+		out += "%)"sv;
 		if (std::find(poll.voted_for.begin(), poll.voted_for.end(), i) != poll.voted_for.end())
 		{
-			out << " [your vote]";
+			out += " [your vote]"sv;
 		}
-		out << '\n';
+		out += '\n';
 	}
-
-	return out;
 }
 
-std::ostream& operator<<(std::ostream& out, const mastodon_status& status)
+void append_text(std::string& out, const mastodon_status& status)
 {
-	print(out, "status id: ", status.id);
-	print(out, "url: ", status.url);
-	print_author(out, "author: ", status.author.display_name, status.author.account_name, status.author.is_bot);
-	print_author(out, "boosted by: ", status.boosted_by_display_name, status.boosted_by, status.boosted_by_bot);
-	print(out, "reply to: ", status.reply_to_post_id);
-	print(out, "boost of: ", status.original_post_url);
-	print(out, "original id: ", status.original_post_id);
-	print(out, "cw: ", status.content_warning);
-	print(out, "body: ", status.content);
+	print(out, "status id: "sv, status.id);
+	print(out, "url: "sv, status.url);
+	print_author(out, "author: "sv, status.author.display_name, status.author.account_name, status.author.is_bot);
+	print_author(out, "boosted by: "sv, status.boosted_by_display_name, status.boosted_by, status.boosted_by_bot);
+	print(out, "reply to: "sv, status.reply_to_post_id);
+	print(out, "boost of: "sv, status.original_post_url);
+	print(out, "original id: "sv, status.original_post_id);
+	print(out, "cw: "sv, status.content_warning);
+	print(out, "body: "sv, status.content);
 
 	for (const auto& attachment : status.attachments)
 	{
-		out << "attached: " << attachment.url << '\n';
+		out += "attached: "sv;
+		out += attachment.url;
+		out += '\n';
 		if (!attachment.description.empty())
 		{
-			out << "description: " << attachment.description << '\n';
+			out += "description: "sv;
+			out += attachment.description;
+			out += '\n';
 		}
 	}
 
 	if (status.poll.has_value())
 	{
-		out << *status.poll;
+		append_text(out, *status.poll);
 	}
 
-	print(out, "visibility: ", status.visibility);
-	print(out, "posted on: ", status.created_at);
-	out << status.favorites << " favs | " << status.boosts << " boosts | " << status.replies << " replies";
-
-	return out;
+	print(out, "visibility: "sv, status.visibility);
+	print(out, "posted on: "sv, status.created_at);
+	print(out, "boosted on: "sv, status.boosted_at);
+	append_number(out, status.favorites);
+	out += " favs | "sv;
+	append_number(out, status.boosts);
+	out += " boosts | "sv;
+	append_number(out, status.replies);
+	out += " replies"sv;
 }
 
-const char* notification_verb(notif_type t)
+std::string_view notification_verb(notif_type t)
 {
 	switch (t)
 	{
 	case notif_type::favorite:
-		return " favorited your post:";
+		return " favorited your post:"sv;
 	case notif_type::boost:
-		return " boosted your post:";
+		return " boosted your post:"sv;
 	case notif_type::mention:
-		return " mentioned you:";
+		return " mentioned you:"sv;
 	case notif_type::follow:
-		return " followed you.";
+		return " followed you."sv;
 	case notif_type::poll:
-		return "'s poll ended:";
+		return "'s poll ended:"sv;
 	default:
-		return " ??? ";
+		return " ??? "sv;
 	}
 }
 
-std::ostream& operator<<(std::ostream& out, const mastodon_notification& notification)
+void append_text(std::string& out, const mastodon_notification& notification)
 {
-	out << "notification id: " << notification.id << '\n';
-	out << "at " << notification.created_at << ", ";
-	print_author(out, "", notification.account.display_name, notification.account.account_name, notification.account.is_bot, false);
-	out << notification_verb(notification.type);
+	out += "notification id: "sv;
+	out += notification.id;
+	out += '\n';
+	out += "at "sv;
+	out += notification.created_at;
+	out += ", "sv;
+	print_author(out, ""sv, notification.account.display_name, notification.account.account_name, notification.account.is_bot, false);
+	out += notification_verb(notification.type);
 
 	if (notification.status.has_value())
 	{
-		out << '\n';
-		out << *notification.status;
+		out += '\n';
+		append_text(out, *notification.status);
 	}
+}
+
+template <typename post_type>
+std::ostream& write_text(std::ostream& out, const post_type& post)
+{
+	std::string text;
+	append_text(text, post);
+	return out.write(text.data(), text.size());
+}
+
+std::ostream& operator<<(std::ostream& out, const mastodon_poll& poll)
+{
+	return write_text(out, poll);
+}
+
+std::ostream& operator<<(std::ostream& out, const mastodon_status& status)
+{
+	return write_text(out, status);
+}
 
-	return out;
+std::ostream& operator<<(std::ostream& out, const mastodon_notification& notification)
+{
+	return write_text(out, notification);
 }
@@ -4,32 +4,277 @@
 #include <filesystem.hpp>
 
 #include <fstream>
+#include <optional>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "../entities/entities.hpp"
+#include "../options/option_enums.hpp"
+#include "post_index.hpp"
+#include "post_formats.hpp"
+#include "list_segments.hpp"
 
 std::ostream& operator<<(std::ostream& out, const mastodon_status& status);
 std::ostream& operator<<(std::ostream& out, const mastodon_notification& notification);
 std::ostream& operator<<(std::ostream& out, const mastodon_poll& poll);
 
+// the same as the operator<<s, but appended straight onto the end of out
+void append_text(std::string& out, const mastodon_status& status);
+void append_text(std::string& out, const mastodon_notification& notification);
+void append_text(std::string& out, const mastodon_poll& poll);
+
+// the operator<<s above and the other formats in post_formats.hpp only write an account's name, display name, and bot flag, so don't bother reading anything else.
+// if those ever start writing more, this has to change with them.
+constexpr account_projection post_list_account{ false, false, false, false, false };
+
+// home.list is called home.jsonl or home.bin in the other formats
+inline fs::path list_file_for(fs::path text_file, list_format format)
+{
+	switch (format)
+	{
+	case list_format::jsonl:
+		return text_file.replace_extension(".jsonl");
+	case list_format::binary:
+		return text_file.replace_extension(".bin");
+	default:
+		return text_file;
+	}
+}
+
+// what a post_list keeps track of for each post it writes, if it's asked to, so another post_list can copy them out of that list one at a time.
+// entry.offset is from the start of the list it was written to.
+struct written_post
+{
+	index_entry entry;
+	// how much of the page it took up, before text mode did anything to its newlines
+	size_t size = 0;
+};
+
 template <typename post_type>
 class post_list
 {
 public:
 
-	// ofstream doesn't know what to do with Boost's filesystem paths, so call c_str()
-	// this is harmless with non-Boost filesystems because those just turn around and call .c_str() on the path anyway
-	post_list(const fs::path& filename) : outfile(filename.c_str(), std::ios::app | std::ios::ate | std::ios::out)
+	// if indexed is set, a post_index is kept next to the file as it's written. the index has to be caught up before anything's written, so it's opened first.
+	// only the text format can be indexed; msync show and msync list don't read the others.
+	// if segments says to split the list up, posts go in segments next to filename instead (see list_segments.hpp), each with its own index.
+	// a list that's already been split up keeps going in its newest segment even if splitting's been turned off since.
+	post_list(const fs::path& filename, bool indexed = false, list_format format = list_format::text, segment_policy segments = {}) :
+		format(format), indexed(indexed && format == list_format::text), segments(segments), base(filename)
 	{
+		// splitting by month doesn't know which segment to open until it sees a post
+		if (fs::exists(manifest_for(base)))
+			open(read_segments(base).back());
+		else if (segments.by != list_segments::monthly)
+			open(base);
 	}
 
 	void write(const post_type& post)
 	{
-		// this assumes that the operator<< for post doesn't add a newline at the end
-		outfile << post;
-		outfile << "\n--------------\n";
+		add_to_page(post);
+		write_page();
+	}
+
+	// formats everything from first to last into one buffer and writes it all at once, instead of one post at a time
+	template <typename iterator>
+	void write(iterator first, iterator last)
+	{
+		for (; first != last; ++first)
+			add_to_page(*first);
+		write_page();
+	}
+
+	list_format output_format() const { return format; }
+
+	// start remembering what's written, for append. see take_layout.
+	void keep_layout() { keeping_layout = true; }
+
+	// everything that's been written since keep_layout was called, in order
+	std::vector<written_post> take_layout()
+	{
+		write_page();
+		return std::move(layout);
+	}
+
+	// copy the contents of another list in the same format onto the end of this one.
+	// other_layout is the take_layout from the post_list that wrote other_list, so that if this list is split up,
+	// other_list's posts can go in whichever segment they would have if they were written here one at a time.
+	void append(const fs::path& other_list, const std::vector<written_post>& other_layout)
+	{
+		std::ifstream infile(other_list.c_str(), format == list_format::text ? std::ios::in : std::ios::in | std::ios::binary);
+
+		if (segments.by == list_segments::off)
+		{
+			// nothing to split, so it can all go in at once
+			write_page();
+			if (infile.peek() != std::ifstream::traits_type::eof())
+				outfile << infile.rdbuf();
+
+			if (index.has_value())
+			{
+				std::ifstream copied(other_list.c_str(), std::ios::binary);
+				index->add_all(copied, position);
+				position += fs::file_size(other_list);
+			}
+			segment_size += fs::file_size(other_list);
+			return;
+		}
+
+		for (const written_post& post : other_layout)
+		{
+			roll_over_for(post.entry.created_at);
+
+			const size_t start = page.size();
+			page.resize(start + post.size);
+			infile.read(page.data() + start, post.size);
+
+			if (index.has_value())
+			{
+				index_entry entry = post.entry;
+				entry.offset = position;
+				position += entry.length;
+				page_entries.push_back(std::move(entry));
+			}
+
+			// other_list could be a lot of posts, so don't hold all of it at once
+			if (page.size() >= Append_Page_Bytes)
+				write_page();
+		}
+		write_page();
 	}
 
 private:
+	const list_format format;
+	const bool indexed;
+	const segment_policy segments;
+	const fs::path base;
+	std::optional<post_index> index;
 	std::ofstream outfile;
+	// the key of the segment being written to, like 2026-10. empty if the list isn't split up, or this is what was there from before it was.
+	std::string current_key;
+	uint64_t segment_size = 0;
+	// kept around between pages so it doesn't have to be allocated again every time
+	std::string page;
+	std::vector<index_entry> page_entries;
+	uint64_t position = 0;
+	bool keeping_layout = false;
+	std::vector<written_post> layout;
+
+	static constexpr size_t Append_Page_Bytes = 1024 * 1024;
+
+	void add_to_page(const post_type& post)
+	{
+		roll_over_for(listed_at(post));
+
+		const size_t start = page.size();
+
+		// these go straight from the post to the bytes in the file, no ostream formatting
+		switch (format)
+		{
+		case list_format::jsonl:
+			append_jsonl(page, post);
+			break;
+		case list_format::binary:
+			append_binary(page, post);
+			break;
+		default:
+			append_text(page, post);
+			page += "\n--------------\n";
+			break;
+		}
+
+		if (!index.has_value() && !keeping_layout)
+			return;
+
+		// the index needs to know exactly how long each post came out
+		const std::string_view written = std::string_view{ page }.substr(start);
+		index_entry entry = make_index_entry(post);
+		entry.length = format == list_format::text ? size_on_disk(written) : written.size();
+		entry.offset = position;
+		position += entry.length;
+
+		if (keeping_layout)
+			layout.push_back(written_post{ entry, written.size() });
+		if (index.has_value())
+			page_entries.push_back(std::move(entry));
+	}
+
+	void write_page()
+	{
+		if (page.empty())
+			return;
+
+		outfile.write(page.data(), page.size());
+		segment_size += page.size();
+		page.clear();
+
+		// the posts go in the list before they go in the index, so the index never points past the end of the list
+		for (const auto& entry : page_entries)
+			index->add(entry);
+		page_entries.clear();
+	}
+
+	static std::ios::openmode open_mode(list_format format)
+	{
+		// the text format is text, so Windows gets its \r\ns. the others have to come out exactly as they were built.
+		const auto mode = std::ios::app | std::ios::ate | std::ios::out;
+		return format == list_format::text ? mode : mode | std::ios::binary;
+	}
+
+	// ofstream doesn't know what to do with Boost's filesystem paths, so call c_str()
+	// this is harmless with non-Boost filesystems because those just turn around and call .c_str() on the path anyway
+	void open(const fs::path& filename)
+	{
+		outfile.close();
+		index.reset();
+
+		if (indexed)
+			index.emplace(filename);
+		outfile.clear();
+		outfile.open(filename.c_str(), open_mode(format));
+
+		segment_size = static_cast<uint64_t>(outfile.tellp());
+		position = segment_size;
+		current_key = segment_key(base, filename);
+	}
+
+	void start_segment(std::string_view key)
+	{
+		// whatever's been formatted so far belongs in the segment before this one
+		write_page();
+		outfile.close();
+		index.reset();
+
+		const fs::path next = segment_file(base, key);
+		add_segment(base, next);
+		open(next);
+	}
+
+	void roll_over_for(std::string_view created_at)
+	{
+		switch (segments.by)
+		{
+		case list_segments::monthly:
+		{
+			// posts without a date, or from before the current segment's month, go in the current segment. finished segments aren't touched again.
+			// if there isn't one yet, a post without a date goes in this month's.
+			const std::string_view month = month_key(created_at);
+			if (!month.empty() && (!outfile.is_open() || current_key.empty() || month > current_key))
+				start_segment(month);
+			else if (!outfile.is_open())
+				start_segment(current_month_key());
+			return;
+		}
+		case list_segments::size:
+			// a segment can go over by one post
+			if (segment_size + page.size() >= segments.max_bytes && segment_size + page.size() > 0)
+				start_segment(next_numbered_key(base));
+			return;
+		default:
+			return;
+		}
+	}
 };
 #endif
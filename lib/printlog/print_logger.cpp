@@ -1,9 +1,13 @@
 #include "print_logger.hpp"
 #include <constants.hpp>
 
+#include <mutex>
+
 bool verbose_logs = false;
 bool logs_off = false;
 
+thread_local log_buffer* captured_logs = nullptr;
+
 #ifdef MSYNC_FILE_LOG
 std::ofstream logfile("msync.log", std::ios::out | std::ios::app);
 #else
@@ -28,3 +32,15 @@ print_logger<logtype::fileonly>& plfile()
 	static print_logger<logtype::fileonly> pl(logfile);
 	return pl;
 }
+
+void flush_log_buffer(log_buffer& buffer)
+{
+	static std::mutex output_lock;
+
+	const std::lock_guard<std::mutex> guard(output_lock);
+	std::cout << buffer.console.str() << std::flush;
+	logfile << buffer.file.str();
+
+	buffer.console.str({});
+	buffer.file.str({});
+}
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 enum class logtype
 {
@@ -13,6 +14,52 @@ enum class logtype
 extern bool verbose_logs;
 extern bool logs_off;
 
+// if a thread has one of these installed, everything it logs goes in here instead of straight to the console and log file.
+// this is how concurrent syncs keep each account's output in one piece.
+struct log_buffer
+{
+	std::ostringstream console;
+	std::ostringstream file;
+};
+
+extern thread_local log_buffer* captured_logs;
+
+// write out everything in the buffer at once. safe to call from multiple threads.
+void flush_log_buffer(log_buffer& buffer);
+
+// write the buffer to wherever this thread's logs are going: the buffer it's capturing into, if there is one,
+// otherwise the console and log file.
+inline void pass_along_log_buffer(log_buffer& buffer)
+{
+	if (captured_logs == nullptr)
+	{
+		flush_log_buffer(buffer);
+	}
+	else
+	{
+		captured_logs->console << buffer.console.str();
+		captured_logs->file << buffer.file.str();
+	}
+}
+
+// captures everything this thread logs until it goes out of scope, then writes it all out together
+struct capture_logs
+{
+	capture_logs() : previous(captured_logs) { captured_logs = &buffer; }
+	~capture_logs()
+	{
+		captured_logs = previous;
+		pass_along_log_buffer(buffer);
+	}
+
+	capture_logs(const capture_logs&) = delete;
+	capture_logs& operator=(const capture_logs&) = delete;
+
+private:
+	log_buffer buffer;
+	log_buffer* const previous;
+};
+
 template <logtype isverbose = logtype::normal>
 struct print_logger
 {
@@ -24,27 +71,39 @@ struct print_logger
 		if (logs_off)
 			return *this;
 
-		if constexpr (isverbose == logtype::verbose)
-		{
-			if (verbose_logs)
-				std::cout << towrite;
-		}
-		else if constexpr (isverbose != logtype::fileonly)
-		{
-			std::cout << towrite;
-		}
+		if (captured_logs == nullptr)
+			write(std::cout, logfile, towrite);
+		else
+			write(captured_logs->console, captured_logs->file, towrite);
 
-		logfile << towrite;
 		return *this;
 	}
 
 	void flush()
 	{
-		std::cout << std::flush;
+		// captured output shows up all at once anyway
+		if (captured_logs == nullptr)
+			std::cout << std::flush;
 	}
 
 private:
 	std::ofstream& logfile;
+
+	template <typename T>
+	static void write(std::ostream& console, std::ostream& file, const T& towrite)
+	{
+		if constexpr (isverbose == logtype::verbose)
+		{
+			if (verbose_logs)
+				console << towrite;
+		}
+		else if constexpr (isverbose != logtype::fileonly)
+		{
+			console << towrite;
+		}
+
+		file << towrite;
+	}
 };
 
 print_logger<logtype::normal>& pl();
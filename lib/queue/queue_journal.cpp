@@ -0,0 +1,62 @@
+#include "queue_journal.hpp"
+
+#include <unordered_map>
+#include <utility>
+
+queue_journal::queue_journal(fs::path file)
+{
+	// count what's already there so it's known when it's time to compact
+	entries = readonly_queue_list{ file }.parsed.size();
+	out.open(file.c_str(), std::ios::out | std::ios::app);
+}
+
+void queue_journal::record(const api_call& sent)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+
+	// retry state doesn't matter once it's gone through
+	write_call(api_call{ sent.queued_call, sent.argument }, out);
+
+	// the whole point is that it's on disk if msync gets stopped right after this
+	out.flush();
+	entries++;
+}
+
+size_t queue_journal::size()
+{
+	const std::lock_guard<std::mutex> guard(lock);
+	return entries;
+}
+
+size_t replay_journal(std::deque<api_call>& queue, const fs::path& journal)
+{
+	if (!fs::exists(journal))
+		return 0;
+
+	const readonly_queue_list sent{ journal };
+
+	// how many times each call was sent, so one pass through the queue can take out that many of each, first ones first
+	std::unordered_map<call_key, size_t, call_key_hash> to_take_out;
+	to_take_out.reserve(sent.parsed.size());
+	for (const api_call& call : sent.parsed)
+		to_take_out[key_of(call)]++;
+
+	std::deque<api_call> kept;
+	for (api_call& call : queue)
+	{
+		const auto found = to_take_out.find(key_of(call));
+		if (found != to_take_out.end() && found->second > 0)
+			found->second--;
+		else
+			kept.push_back(std::move(call));
+	}
+	queue = std::move(kept);
+
+	return sent.parsed.size();
+}
+
+void compact_journal(queue_list& queue, const fs::path& journal)
+{
+	queue.save();
+	fs::remove(journal);
+}
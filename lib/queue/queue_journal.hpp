@@ -0,0 +1,48 @@
+#ifndef QUEUE_JOURNAL_HPP
+#define QUEUE_JOURNAL_HPP
+
+#include "queue_list.hpp"
+
+#include <filesystem.hpp>
+
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+// sending a queue only rewrites sync.queue at the end, so if msync got stopped partway through a long queue,
+// everything that already went through would be sent again next time. so, as each call goes through, it's added to
+// the end of this journal, which is cheap and survives msync being killed. the next time the queue is opened, the journal's
+// calls are taken back out of it, and every so often the queue is rewritten without them and the journal starts over.
+// as long as the journal exists, everything in it is still in sync.queue.
+class queue_journal
+{
+public:
+	queue_journal(fs::path file);
+
+	// safe to call from multiple threads
+	void record(const api_call& sent);
+
+	// how many calls are in the journal, counting the ones that were there before it was opened
+	size_t size();
+
+	queue_journal(const queue_journal&) = delete;
+	queue_journal& operator=(const queue_journal&) = delete;
+
+private:
+	std::mutex lock;
+	std::ofstream out;
+	size_t entries = 0;
+};
+
+// once the journal has this many calls in it, rewriting sync.queue without them is worth it
+constexpr size_t Journal_Compaction_Threshold = 256;
+
+// takes each call in the journal out of the queue, the first one that matches for each.
+// returns how many calls were in the journal.
+size_t replay_journal(std::deque<api_call>& queue, const fs::path& journal);
+
+// writes out the queue, which should already have the journal replayed into it, then gets rid of the journal.
+// like file_backed::save(), the queue won't be written again when it's destroyed unless should_save_back is set.
+void compact_journal(queue_list& queue, const fs::path& journal);
+
+#endif
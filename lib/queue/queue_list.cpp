@@ -2,6 +2,7 @@
 
 #include <array>
 #include <string_view>
+#include <charconv>
 
 // not +1 because unknown doesn't get a string
 constexpr std::array<std::string_view, static_cast<uint8_t>(api_route::unknown)> ROUTE_NAMES = {
@@ -36,23 +37,47 @@ bool Read(std::deque<api_call>& queued, std::string&& line)
 	else
 		line.clear();
 
-	queued.push_back(api_call{ parsed_route, std::move(line) });
+	// calls that have failed before have their retry state after a tab: attempts, last status code, and when to try next
+	retry_state retry;
+	const auto tab = line.rfind('\t');
+	if (tab != std::string::npos)
+	{
+		const char* const end = line.data() + line.size();
+		auto parsed = std::from_chars(line.data() + tab + 1, end, retry.attempts);
+		if (parsed.ec == std::errc{} && parsed.ptr != end)
+			parsed = std::from_chars(parsed.ptr + 1, end, retry.last_status_code);
+		if (parsed.ec == std::errc{} && parsed.ptr != end)
+			parsed = std::from_chars(parsed.ptr + 1, end, retry.next_attempt);
+
+		if (parsed.ec == std::errc{} && parsed.ptr == end)
+			line.erase(tab);
+		else
+			retry = retry_state{};
+	}
+
+	queued.push_back(api_call{ parsed_route, std::move(line), retry });
 	return false;
 }
 
-void Write(std::deque<api_call>&& que, std::ofstream& of)
+void write_call(const api_call& call, std::ostream& out)
 {
-	for (const auto& call : que)
-	{
-		if (call.queued_call == api_route::unknown) continue;
+	if (call.queued_call == api_route::unknown) return;
 
-		of << print_route(call.queued_call);
+	out << print_route(call.queued_call);
 
-		if (!call.argument.empty())
-			of << ' ' << call.argument;
+	if (!call.argument.empty())
+		out << ' ' << call.argument;
 
-		of << '\n';
-	}
+	if (call.retry.attempts > 0)
+		out << '\t' << call.retry.attempts << ' ' << call.retry.last_status_code << ' ' << call.retry.next_attempt;
+
+	out << '\n';
+}
+
+void Write(std::deque<api_call>&& que, std::ofstream& of)
+{
+	for (const auto& call : que)
+		write_call(call, of);
 }
 
 bool operator== (const api_call& rhs, const api_call& lhs)
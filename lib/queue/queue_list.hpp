@@ -3,6 +3,11 @@
 
 #include <deque>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <functional>
+#include <ostream>
+#include <cstdint>
 
 #include "../filebacked/file_backed.hpp"
 
@@ -20,16 +25,47 @@ enum class api_route : uint8_t
 	unknown,
 };
 
+// how it's gone so far for a call that's failed before. a call that's never been tried, or never failed, has all zeroes.
+struct retry_state
+{
+	unsigned int attempts = 0;
+	int last_status_code = 0;
+	// seconds since the epoch. the call won't be tried again until then.
+	int64_t next_attempt = 0;
+};
+
 struct api_call
 {
 	api_route queued_call;
 	std::string argument;
+	// defaulted so calls made with just a route and an argument start out never having failed
+	retry_state retry{};
 };
 
 bool operator== (const api_call& rhs, const api_call& lhs);
 
+// a call's route and argument, without copying the argument.
+// only good for as long as the call it came from stays put and isn't changed.
+using call_key = std::pair<api_route, std::string_view>;
+
+struct call_key_hash
+{
+	size_t operator()(const call_key& key) const noexcept
+	{
+		return std::hash<std::string_view>{}(key.second) * 31 + static_cast<size_t>(key.first);
+	}
+};
+
+inline call_key key_of(const api_call& call)
+{
+	return { call.queued_call, call.argument };
+}
+
 std::string_view print_route(api_route route);
 
+// writes one line of a queue file, newline included
+void write_call(const api_call& call, std::ostream& out);
+
 bool Read(std::deque<api_call>&, std::string&&);
 void Write(std::deque<api_call>&&, std::ofstream&);
 
@@ -1,4 +1,5 @@
 #include "queues.hpp"
+#include "queue_journal.hpp"
 
 #include <constants.hpp>
 #include <system_error>
@@ -8,6 +9,10 @@
 #include <algorithm>
 #include <functional>
 #include <array>
+#include <unordered_set>
+#include <unordered_map>
+#include <utility>
+#include <type_traits>
 #include <msync_exception.hpp>
 
 fs::path get_file_queue_directory(const fs::path& user_account_dir)
@@ -199,7 +204,28 @@ std::string queue_post(const fs::path& queuedir, const fs::path& postfile)
 template <typename queue_t = queue_list>
 queue_t open_queue(const fs::path& user_account_dir)
 {
-	return queue_t{ user_account_dir / Queue_Filename };
+	queue_t opened{ user_account_dir / Queue_Filename };
+
+	// anything a sync already sent but didn't get around to taking out of the queue file
+	const fs::path journal = user_account_dir / Queue_Journal_Filename;
+	if (replay_journal(opened.parsed, journal) > 0)
+	{
+		if constexpr (std::is_same_v<queue_t, queue_list>)
+		{
+			compact_journal(opened, journal);
+			// whoever opened it is probably about to change it
+			opened.should_save_back = true;
+		}
+	}
+
+	return opened;
+}
+
+using call_index = std::unordered_set<call_key, call_key_hash>;
+
+bool is_undo(const api_route route)
+{
+	return route == api_route::unfav || route == api_route::unboost || route == api_route::unbookmark;
 }
 
 std::vector<api_call> to_api_calls(std::vector<std::string>&& add, api_route target_route)
@@ -235,24 +261,29 @@ void enqueue(const api_route toenqueue, const fs::path& user_account_dir, std::v
 	}
 	else
 	{
-		// hm, this is (add.size() * toaddto.size()) string compares, which isn't great, performance-wise
-		// but I think it's worth it to eliminate duplicates from the queue, since that saves network requests down the line.
-		// I do it like this because std::unique only works on adjacent duplicates, and sorting the list would destroy the order
-		// I might be able to get a speedup by copying toaddto into a std::unordered_set, but I'm not sure adding a bunch of
-		// allocations to the mix really helps for the small input sizes msync deals with. 
-		// similar to the dequeue situation
+		// it's worth eliminating duplicates from the queue, since that saves network requests down the line.
+		// std::unique only works on adjacent duplicates, and sorting the list would destroy the order, so keep
+		// an index of what's already in there on the side. scripts can enqueue thousands of ids at once, and
+		// searching the whole queue for each one of those adds up fast.
 
 		// you could argue that order doesn't matter for favs and boosts, and I think that, too, but 
 		// - it absolutely matters for posts, especially since posts can be replies to others
 		// - if this part of the program is called 'queue', it should implement a queue
 
+		// pushing onto the end of a deque doesn't move what's already in it, so the keys stay good
+		call_index already_queued;
+		already_queued.reserve(toaddto.parsed.size() + add.size());
+		for (const api_call& call : toaddto.parsed)
+			already_queued.insert(key_of(call));
+
 		int queued, skipped;
 		queued = skipped = 0;
 		for (api_call& incoming_call : to_api_calls(std::move(add), toenqueue))
 		{
-			if (std::find(toaddto.parsed.begin(), toaddto.parsed.end(), incoming_call) == toaddto.parsed.end())
+			if (already_queued.count(key_of(incoming_call)) == 0)
 			{
 				toaddto.parsed.push_back(std::move(incoming_call));
+				already_queued.insert(key_of(toaddto.parsed.back()));
 				queued++;
 			}
 			else
@@ -264,8 +295,8 @@ void enqueue(const api_route toenqueue, const fs::path& user_account_dir, std::v
 		plverb() << "Enqueued " << queued << pluralize(queued, " item", " items") << " and skipped " << skipped << pluralize(skipped, " duplicate", " duplicates") << " for account " << user_account_dir.filename() << ".\n";
 	}
 
-	// consider looking for those "delete" guys, the ones with the - at the end, and having this cancel them out, 
-	// but "unboost and reboost", for example, is a valid thing to want to do.
+	// cancelling out the "delete" guys happens in coalesce(), right before sending,
+	// since "unboost and reboost", for example, is a valid thing to want to do.
 }
 
 void dequeue_post(const fs::path& queuedir, const fs::path& filename)
@@ -295,36 +326,47 @@ void dequeue(api_route todequeue, const fs::path& user_account_dir, std::vector<
 
 	auto toremove = to_api_calls(std::move(remove), todequeue);
 
-	// stable_partition is O(n) (assuming it can allocate a temporary buffer)
-	// but doing a O(n) find call for each one makes it O(n^2)
-	// sorting toremove and doing a binary search on it might be faster, 
-	// but that's an O(n lg n) sort and then an O(n lg n) partition-with-find.
-	// if the problem gets big enough, an unordered_set made from the elements of toremove would help
-	// but I think that's overkill for the small lists this program will likely deal with.
-
-	// what we really want is the set difference between these two, but:
-	// - it would require making a sorted or std::unordered_set copy of toremovefrom and same for toremove
-	// - it'd still be an O(n) operation to remove existing entries from toremovefrom because toremovefrom has to stay in order
-	// - you'd have have to do two set differences- one for the things to be removed from toremovefrom and one
-	//   for the things in toremove that get enqueued with the minus sign
-
-	// put the ones to keep first, and the ones to remove last
+	// what we really want is the set difference between these two, but toremovefrom has to stay in order, and
+	// the things in toremove that aren't in the queue get enqueued with the minus sign. so, index toremove, and
+	// note which of those actually show up in the queue on the way through. that keeps the whole thing linear,
+	// which matters when a script dequeues thousands of ids at once.
+	call_index removing;
+	removing.reserve(toremove.size());
+	for (const api_call& call : toremove)
+		removing.insert(key_of(call));
+
+	// put the ones to keep first, and the ones to remove last.
+	// stable_partition moves things around as it goes, so remember which keys were found by pointing into toremove instead.
+	call_index found;
 	const auto removefrom_pivot = std::stable_partition(toremovefrom.parsed.begin(), toremovefrom.parsed.end(),
-		[&toremove](const auto& id) {
-			return std::find(toremove.begin(), toremove.end(), id) == toremove.end();
+		[&removing, &found](const auto& id) {
+			const auto match = removing.find(key_of(id));
+			if (match == removing.end())
+				return true;
+			found.insert(*match);
+			return false;
 		});
 
-
 	// put the ones that'll be removed from the queue first and the rest after 
+	// same deal as above, the keys point into toremove, which is about to be shuffled, so decide everything first
+	std::vector<bool> in_queue(toremove.size());
+	std::transform(toremove.begin(), toremove.end(), in_queue.begin(), [&found](const auto& id) { return found.count(key_of(id)) > 0; });
 
-	// all the ones in toremovefrom that are also in toremove are at the end, so we only have to check those.
-	// again, partitioning is O(n) and std::find is O(n), so this is another n^2 algorithm.
-	// but these should be relatively small and so I highly doubt it's going to matter. If it does,
-	// I could copy the things that'll be removed from the queue to an unordered set. Again, overkill for this.
-	const auto toremove_pivot = std::stable_partition(toremove.begin(), toremove.end(),
-		[&toremovefrom, removefrom_pivot](const auto& id) {
-			return std::find(removefrom_pivot, toremovefrom.parsed.end(), id) != toremovefrom.parsed.end();
-		});
+	std::vector<api_call> partitioned;
+	partitioned.reserve(toremove.size());
+	for (size_t i = 0; i < toremove.size(); i++)
+	{
+		if (in_queue[i])
+			partitioned.push_back(std::move(toremove[i]));
+	}
+	const auto removed_ids = partitioned.size();
+	for (size_t i = 0; i < toremove.size(); i++)
+	{
+		if (!in_queue[i])
+			partitioned.push_back(std::move(toremove[i]));
+	}
+	toremove = std::move(partitioned);
+	const auto toremove_pivot = toremove.begin() + removed_ids;
 
 	if (todequeue == api_route::post)
 	{
@@ -355,6 +397,19 @@ void dequeue(api_route todequeue, const fs::path& user_account_dir, std::vector<
 	plverb() << "Enqueued " << enqueued_deletes << pluralize(enqueued_deletes, " deletion", " deletions") << " for account " << user_account_dir.filename() << ".\n";
 }
 
+void read_ids(std::istream& in, std::vector<std::string>& ids)
+{
+	for (std::string line; std::getline(in, line);)
+	{
+		// filenames can have spaces in the middle, so only trim the ends
+		const auto first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos)
+			continue;
+		const auto last = line.find_last_not_of(" \t\r");
+		ids.push_back(line.substr(first, last - first + 1));
+	}
+}
+
 void clear(api_route toclear, const fs::path& user_account_dir)
 {
 	queue_list clearthis = open_queue(user_account_dir);
@@ -373,6 +428,59 @@ void clear(api_route toclear, const fs::path& user_account_dir)
 	}
 }
 
+size_t coalesce(std::deque<api_call>& calls)
+{
+	// for each (route, id), the calls that are being kept, by index. because a call followed by its undo cancels out and
+	// repeats get dropped, there's only ever an undo, a call, or an undo and then a call in here.
+	// keyed by the undo route, so a fav and its unfav end up in the same spot.
+	std::unordered_map<call_key, std::vector<size_t>, call_key_hash> kept;
+	std::vector<bool> drop(calls.size(), false);
+
+	for (size_t i = 0; i < calls.size(); i++)
+	{
+		const api_call& call = calls[i];
+
+		// posts can be replied to and deleted posts are gone for good, so their order always matters
+		if (call.queued_call == api_route::post || call.queued_call == api_route::unpost || call.queued_call == api_route::unknown)
+			continue;
+
+		const api_route family = is_undo(call.queued_call) || call.queued_call == api_route::context ? call.queued_call : undo_route(call.queued_call);
+		auto& same = kept[call_key{ family, call.argument }];
+
+		if (!same.empty() && calls[same.back()].queued_call == call.queued_call)
+		{
+			// already going to happen
+			drop[i] = true;
+		}
+		else if (!same.empty() && is_undo(call.queued_call))
+		{
+			// the call before this one is the thing it undoes, so neither one needs to happen
+			drop[i] = true;
+			drop[same.back()] = true;
+			same.pop_back();
+		}
+		else
+		{
+			same.push_back(i);
+		}
+	}
+
+	// remove_if doesn't promise to go in order, so do it by hand
+	size_t kept_count = 0;
+	for (size_t i = 0; i < calls.size(); i++)
+	{
+		if (drop[i])
+			continue;
+		if (kept_count != i)
+			calls[kept_count] = std::move(calls[i]);
+		kept_count++;
+	}
+
+	const auto removed = calls.size() - kept_count;
+	calls.erase(calls.begin() + kept_count, calls.end());
+	return removed;
+}
+
 queue_list get(const fs::path& user_account_dir)
 {
 	return open_queue(user_account_dir);
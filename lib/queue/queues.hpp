@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <istream>
 
 #include "queue_list.hpp"
 #include <filesystem.hpp>
@@ -12,10 +14,19 @@
 void enqueue(api_route toenqueue, const fs::path& user_account_dir, std::vector<std::string> add);
 void dequeue(api_route todequeue, const fs::path& user_account_dir, std::vector<std::string> remove);
 
+// adds the ids or filenames in a file, or piped in, to ids. one per line, blank lines are skipped.
+void read_ids(std::istream& in, std::vector<std::string>& ids);
+
 void clear(api_route toclear, const fs::path& user_account_dir);
 
 queue_list get(const fs::path& user_account_dir);
 
+// takes out calls that don't need to be made: a fav, boost, or bookmark that's undone later in the queue goes away along with the undo,
+// and repeats of a call that's already queued go away, too. an undo followed by a redo stays, since that's
+// somebody asking to unboost and reboost something. posts and deletes are never touched.
+// returns how many calls were taken out.
+size_t coalesce(std::deque<api_call>& calls);
+
 std::vector<std::string> print(const fs::path& user_account_dir);
 
 #endif
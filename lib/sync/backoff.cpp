@@ -0,0 +1,29 @@
+#include "backoff.hpp"
+
+#include <algorithm>
+#include <random>
+
+std::chrono::milliseconds backoff_ceiling(const backoff_policy& policy, unsigned int retry)
+{
+	if (policy.base.count() <= 0 || retry == 0)
+		return std::chrono::milliseconds{ 0 };
+
+	// double until it's past the cap, without letting it overflow
+	auto ceiling = policy.base;
+	for (unsigned int i = 1; i < retry && ceiling < policy.max_delay; i++)
+		ceiling *= 2;
+
+	return std::min(ceiling, std::max(policy.max_delay, policy.base));
+}
+
+std::chrono::milliseconds backoff_delay(const backoff_policy& policy, unsigned int retry)
+{
+	const auto ceiling = backoff_ceiling(policy, retry);
+	if (ceiling.count() <= 0)
+		return ceiling;
+
+	// one per thread so concurrent syncs don't have to fight over it. this doesn't need to be anything special.
+	thread_local std::minstd_rand engine{ std::random_device{}() };
+	std::uniform_int_distribution<std::chrono::milliseconds::rep> pick(0, ceiling.count());
+	return std::chrono::milliseconds{ pick(engine) };
+}
@@ -0,0 +1,25 @@
+#ifndef BACKOFF_HPP
+#define BACKOFF_HPP
+
+#include <chrono>
+
+// how long to wait between tries after a timeout or a server error.
+// each wait is picked at random between zero and base, doubled for each retry before it, up to max_delay.
+// that's "full jitter", so a bunch of requests that failed at the same time don't all come back at the same time, either.
+// once a request has spent deadline retrying, it gives up, even if it has tries left. time spent waiting on a rate limit doesn't count.
+// the defaults don't wait at all; msync sync sets these from the command line.
+struct backoff_policy
+{
+	std::chrono::milliseconds base{ 0 };
+	std::chrono::milliseconds max_delay{ 30000 };
+	// zero means no deadline
+	std::chrono::milliseconds deadline{ 0 };
+};
+
+// the longest it could wait before retry number retry, counting from 1
+std::chrono::milliseconds backoff_ceiling(const backoff_policy& policy, unsigned int retry);
+
+// how long to actually wait before retry number retry, somewhere between zero and backoff_ceiling
+std::chrono::milliseconds backoff_delay(const backoff_policy& policy, unsigned int retry);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <utility>
+#include <algorithm>
+
+// a queue for handing things from one thread to another that makes the producer wait when it gets too far ahead.
+// once closed, pushes are refused and pops drain whatever's left, then come back empty.
+template <typename T>
+struct bounded_queue
+{
+public:
+	bounded_queue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+	// returns false if the queue was closed and the item wasn't added
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		not_full.wait(guard, [this]() { return closed || items.size() < capacity; });
+		if (closed)
+			return false;
+
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+		return true;
+	}
+
+	std::optional<T> pop()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		not_empty.wait(guard, [this]() { return closed || !items.empty(); });
+		if (items.empty())
+			return std::nullopt;
+
+		std::optional<T> toreturn{ std::move(items.front()) };
+		items.pop_front();
+		not_full.notify_one();
+		return toreturn;
+	}
+
+	void close()
+	{
+		const std::lock_guard<std::mutex> guard(lock);
+		closed = true;
+		not_full.notify_all();
+		not_empty.notify_all();
+	}
+
+private:
+	const size_t capacity;
+	bool closed = false;
+	std::deque<T> items;
+	std::mutex lock;
+	std::condition_variable not_full;
+	std::condition_variable not_empty;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef DEPENDENCY_RUNNER_HPP
+#define DEPENDENCY_RUNNER_HPP
+
+#include <print_logger.hpp>
+
+#include "sync_stats.hpp"
+#include "rate_limit_pacer.hpp"
+
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+// calls run_one(i) for every i in [0, depends_on.size()), up to jobs at a time, but never before everything in depends_on[i] has finished.
+// depends_on[i] can only name things that come before i, so running them in order always works, and that's what happens with one job.
+// when there's a choice, the earliest one that's ready goes next.
+// each one's log output is held and written out in order, as soon as everything before it has finished, so it reads the same as running them one at a time.
+// returns whether each one succeeded. something that depends on a failure still runs; it's up to run_one to decide what that means.
+// if any of them throw, the rest still run, then the first exception (in order) is rethrown.
+template <typename RunOne>
+std::vector<bool> run_in_dependency_order(const std::vector<std::vector<size_t>>& depends_on, unsigned int jobs, RunOne run_one)
+{
+	const size_t count = depends_on.size();
+	std::vector<bool> succeeded(count, false);
+
+	// nothing to gain from spinning up threads, and this keeps the live output, like the rate limit countdown, working
+	if (jobs <= 1 || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			succeeded[i] = run_one(i);
+		return succeeded;
+	}
+
+	std::vector<std::vector<size_t>> dependents(count);
+	std::vector<size_t> waiting_on(count, 0);
+	std::set<size_t> ready;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (const size_t dependency : depends_on[i])
+		{
+			dependents[dependency].push_back(i);
+			waiting_on[i]++;
+		}
+		if (waiting_on[i] == 0)
+			ready.insert(i);
+	}
+
+	std::mutex lock;
+	std::condition_variable changed;
+	size_t not_started = count;
+	std::vector<bool> finished(count, false);
+	std::vector<log_buffer> logs(count);
+	std::vector<std::exception_ptr> errors(count);
+
+	// the workers get their own stats so they aren't all writing to the same ones, and they're combined at the end
+	sync_stats* const caller_stats = current_stats;
+	std::vector<sync_stats> worker_stats(count);
+	// everyone's using the same account, so they share the caller's rate limit
+	rate_limit_pacer* const pacer = current_pacer;
+	const bool deferring = defer_rate_limits;
+
+	const auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		while (true)
+		{
+			changed.wait(guard, [&]() { return not_started == 0 || !ready.empty(); });
+			if (ready.empty())
+				return;
+
+			const size_t next = *ready.begin();
+			ready.erase(ready.begin());
+			not_started--;
+
+			guard.unlock();
+			// each worker only ever touches its own slot in logs, worker_stats, and errors.
+			// succeeded is a vector<bool>, so neighbors share bytes and it has to wait for the lock.
+			bool result = false;
+			captured_logs = &logs[next];
+			current_stats = caller_stats == nullptr ? nullptr : &worker_stats[next];
+			current_pacer = pacer;
+			defer_rate_limits = deferring;
+			try
+			{
+				result = run_one(next);
+			}
+			catch (...)
+			{
+				errors[next] = std::current_exception();
+			}
+			captured_logs = nullptr;
+			current_stats = nullptr;
+			current_pacer = nullptr;
+			defer_rate_limits = false;
+			guard.lock();
+
+			succeeded[next] = result;
+			finished[next] = true;
+			for (const size_t dependent : dependents[next])
+			{
+				if (--waiting_on[dependent] == 0)
+					ready.insert(dependent);
+			}
+			changed.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	const auto worker_count = std::min<size_t>(jobs, count);
+	workers.reserve(worker_count);
+	for (size_t i = 0; i < worker_count; i++)
+		workers.emplace_back(worker);
+
+	// meanwhile, write out the logs in order as they become available
+	for (size_t written = 0; written < count; written++)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			changed.wait(guard, [&]() { return finished[written]; });
+		}
+		pass_along_log_buffer(logs[written]);
+	}
+
+	std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+
+	if (caller_stats != nullptr)
+		std::for_each(worker_stats.begin(), worker_stats.end(), [caller_stats](const sync_stats& stats) { *caller_stats += stats; });
+
+	const auto first_error = std::find_if(errors.begin(), errors.end(), [](const std::exception_ptr& ex) { return ex != nullptr; });
+	if (first_error != errors.end())
+		std::rethrow_exception(*first_error);
+
+	return succeeded;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "media_cache.hpp"
+
+#include "../util/util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// FNV-1a. this isn't guarding against anything malicious, it just has to tell apart the files one person attaches.
+constexpr uint64_t fnv_offset = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+uint64_t hash_bytes(const char* bytes, size_t size, uint64_t hash = fnv_offset)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<unsigned char>(bytes[i]);
+		hash *= fnv_prime;
+	}
+	return hash;
+}
+
+bool Read(media_map& parsed, std::string&& line)
+{
+	// key expires id
+	const auto first_space = line.find(' ');
+	const auto second_space = line.find(' ', first_space + 1);
+	if (first_space == std::string::npos || second_space == std::string::npos)
+		return false;
+
+	int64_t expires = 0;
+	const auto [end, error] = std::from_chars(line.data() + first_space + 1, line.data() + second_space, expires);
+	if (error != std::errc{} || expires <= seconds_since_epoch())
+		return false;
+
+	parsed.insert_or_assign(line.substr(0, first_space), cached_media{ line.substr(second_space + 1), expires });
+	return false;
+}
+
+void Write(media_map&& cache, std::ofstream& of)
+{
+	for (const auto& entry : cache)
+		of << entry.first << ' ' << entry.second.expires << ' ' << entry.second.id << '\n';
+}
+
+std::string media_cache::key_for(const fs::path& file, std::string_view description)
+{
+	std::ifstream in(file.c_str(), std::ios::binary);
+
+	uint64_t size = 0;
+	uint64_t content_hash = fnv_offset;
+	std::array<char, 64 * 1024> buffer;
+	while (in)
+	{
+		in.read(buffer.data(), buffer.size());
+		const auto read = static_cast<size_t>(in.gcount());
+		content_hash = hash_bytes(buffer.data(), read, content_hash);
+		size += read;
+	}
+
+	std::ostringstream key;
+	key << size << '-' << std::hex << std::setfill('0') << std::setw(16) << content_hash
+		<< '-' << std::setw(16) << hash_bytes(description.data(), description.size());
+	return key.str();
+}
+
+media_map* media_cache::entries(const bool create)
+{
+	if (!backing.has_value())
+	{
+		if (!create && !fs::exists(file))
+			return nullptr;
+
+		backing.emplace(file);
+		backing->should_save_back = false;
+	}
+
+	return &backing->parsed;
+}
+
+std::string media_cache::find(std::string_view key)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+	const media_map* cached = entries(false);
+	if (cached == nullptr)
+		return {};
+
+	const auto found = cached->find(key);
+	if (found == cached->end() || found->second.expires <= seconds_since_epoch())
+		return {};
+	return found->second.id;
+}
+
+void media_cache::remember(std::string key, std::string media_id)
+{
+	const auto expires = seconds_since_epoch() + std::chrono::duration_cast<std::chrono::seconds>(Media_Cache_Lifetime).count();
+
+	const std::lock_guard<std::mutex> guard(lock);
+	entries(true)->insert_or_assign(std::move(key), cached_media{ std::move(media_id), expires });
+	backing->should_save_back = true;
+}
+
+void media_cache::forget(const std::vector<std::string>& media_ids)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+	media_map* cached = entries(false);
+	if (cached == nullptr)
+		return;
+
+	for (auto entry = cached->begin(); entry != cached->end();)
+	{
+		if (std::find(media_ids.begin(), media_ids.end(), entry->second.id) != media_ids.end())
+		{
+			entry = cached->erase(entry);
+			backing->should_save_back = true;
+		}
+		else
+		{
+			++entry;
+		}
+	}
+}
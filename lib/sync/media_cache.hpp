@@ -0,0 +1,61 @@
+#ifndef MEDIA_CACHE_HPP
+#define MEDIA_CACHE_HPP
+
+#include <filesystem.hpp>
+
+#include "../filebacked/file_backed.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// remembers what was uploaded for each attachment, so if a post fails after its attachments were uploaded,
+// the next sync can attach the same media instead of uploading it all over again.
+// media belongs to the account that uploaded it and can only be attached to one post, so this is per account,
+// and entries are forgotten once the post they were for goes through.
+// servers delete media that never gets attached after a while (a day, by default, on Mastodon), so entries expire well before that.
+constexpr std::chrono::hours Media_Cache_Lifetime{ 12 };
+
+struct cached_media
+{
+	std::string id;
+	int64_t expires; // seconds since the epoch
+};
+
+using media_map = std::map<std::string, cached_media, std::less<>>;
+
+bool Read(media_map&, std::string&&);
+void Write(media_map&&, std::ofstream&);
+
+class media_cache
+{
+public:
+	// the file isn't read until something asks for it, and isn't written unless something's remembered or forgotten,
+	// so a sync that doesn't upload anything doesn't leave a cache file behind
+	media_cache(fs::path file) : file(std::move(file)) { }
+
+	// an attachment's key is its size, a hash of what's in it, and a hash of its description,
+	// so changing either the file or the description means it gets uploaded again.
+	static std::string key_for(const fs::path& file, std::string_view description);
+
+	// the media id uploaded for this key, or the empty string if there isn't one or it expired
+	std::string find(std::string_view key);
+	void remember(std::string key, std::string media_id);
+	// once media is attached to a post, it can't be used again
+	void forget(const std::vector<std::string>& media_ids);
+
+private:
+	std::mutex lock;
+	const fs::path file;
+	std::optional<file_backed<media_map, Read, Write>> backing;
+
+	// nullptr if there's no cache file and nothing's been remembered yet
+	media_map* entries(bool create);
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "rate_limit_pacer.hpp"
+
+#include "../util/util.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+thread_local rate_limit_pacer* current_pacer = nullptr;
+thread_local bool defer_rate_limits = false;
+
+template <typename Number>
+Number read_number(const option_file& file, std::string_view key)
+{
+	Number value{};
+	const auto found = file.parsed.find(key);
+	if (found != file.parsed.end())
+		std::from_chars(found->second.data(), found->second.data() + found->second.size(), value);
+	return value;
+}
+
+rate_limit_pacer::rate_limit_pacer(fs::path file) : backing(std::move(file))
+{
+	limit = read_number<int>(backing, "limit");
+	remaining = read_number<int>(backing, "remaining");
+	resets_at = clock::time_point{ std::chrono::seconds{ read_number<int64_t>(backing, "resets_at") } };
+}
+
+rate_limit_pacer::~rate_limit_pacer()
+{
+	backing.parsed["limit"] = std::to_string(limit);
+	backing.parsed["remaining"] = std::to_string(remaining);
+	backing.parsed["resets_at"] = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(resets_at.time_since_epoch()).count());
+}
+
+std::chrono::milliseconds rate_limit_pacer::reserve(const clock::time_point now)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+
+	// never heard from the server, so there's nothing to go on
+	if (limit <= 0)
+		return std::chrono::milliseconds{ 0 };
+
+	// a fresh window. the server will say when this one resets.
+	if (now >= resets_at && remaining < limit)
+	{
+		remaining = std::max(limit - borrowed, 0);
+		borrowed = 0;
+		next_slot = now;
+	}
+
+	if (remaining > limit / Pacing_Starts_Below_Fraction)
+	{
+		remaining--;
+		return std::chrono::milliseconds{ 0 };
+	}
+
+	const auto slot = std::max(now, next_slot);
+
+	// all used up, so wait for the reset, behind everything else that's already waiting for it.
+	// nothing's left until then no matter how many come along, so what they take comes out of the new window.
+	if (remaining <= 0)
+	{
+		const auto after_reset = std::max(resets_at, slot);
+		next_slot = after_reset;
+		borrowed++;
+		return std::chrono::duration_cast<std::chrono::milliseconds>(after_reset - now);
+	}
+
+	// spread out what's left evenly over what's left of the window
+	const auto interval = std::max(resets_at - slot, clock::duration{ 0 }) / remaining;
+	next_slot = slot + interval;
+	remaining--;
+	return std::chrono::duration_cast<std::chrono::milliseconds>(slot - now);
+}
+
+void rate_limit_pacer::update(const net_response& response, const clock::time_point now)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+
+	if (response.status_code == 429)
+	{
+		// 429s don't always come with the other headers, but they always mean there's nothing left
+		remaining = 0;
+		resets_at = parse_ISO8601_timestamp(response.message);
+		return;
+	}
+
+	if (response.rate_limit <= 0)
+		return;
+
+	limit = response.rate_limit;
+	if (response.rate_limit_reset.empty())
+	{
+		remaining = response.rate_limit_remaining;
+		return;
+	}
+
+	// other requests might be in flight, and what they took isn't in this count yet, so don't let it go up mid-window
+	const auto resets = parse_ISO8601_timestamp(response.rate_limit_reset);
+	if (resets > resets_at || now >= resets_at)
+	{
+		resets_at = resets;
+		remaining = response.rate_limit_remaining;
+		// the server's count is all there is to go on now
+		borrowed = 0;
+	}
+	else
+	{
+		remaining = std::min(remaining, response.rate_limit_remaining);
+	}
+}
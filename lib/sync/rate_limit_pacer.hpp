@@ -0,0 +1,98 @@
+#ifndef RATE_LIMIT_PACER_HPP
+#define RATE_LIMIT_PACER_HPP
+
+#include <filesystem.hpp>
+#include <msync_exception.hpp>
+
+#include "../netinterface/net_interface.hpp"
+#include "../options/option_file.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Mastodon says how many requests are left (X-RateLimit-Remaining) out of how many (X-RateLimit-Limit) until the
+// limit resets (X-RateLimit-Reset) with every response. https://docs.joinmastodon.org/api/rate-limits/
+// instead of running until a 429 and then stalling for the whole rest of the window, this starts spreading out the
+// requests that are left over the time until it resets once they run low, so they never quite run out.
+// the limit counts requests made with an account's access token, so this is per account, and saved between syncs,
+// since a window can outlast a sync.
+class rate_limit_pacer
+{
+public:
+	using clock = std::chrono::system_clock;
+
+	rate_limit_pacer(fs::path file);
+	~rate_limit_pacer();
+
+	// how long to wait before making the next request, which is counted against what's left.
+	// safe to call from multiple threads; each caller gets its own turn.
+	std::chrono::milliseconds reserve(clock::time_point now = clock::now());
+
+	// what the server said in its response, if it said anything
+	void update(const net_response& response, clock::time_point now = clock::now());
+
+	rate_limit_pacer(const rate_limit_pacer&) = delete;
+	rate_limit_pacer& operator=(const rate_limit_pacer&) = delete;
+
+private:
+	std::mutex lock;
+	option_file backing;
+
+	// 0 until a server says what it is
+	int limit = 0;
+	int remaining = 0;
+	clock::time_point resets_at;
+	// when the next paced request gets to go
+	clock::time_point next_slot;
+	// requests that ran out of this window and are waiting for the next one, which they'll count against
+	int borrowed = 0;
+};
+
+// requests aren't paced until there's less than this fraction of the limit left
+constexpr int Pacing_Starts_Below_Fraction = 5;
+
+// whatever's pacing requests made on this thread, or nullptr if nothing is
+extern thread_local rate_limit_pacer* current_pacer;
+
+// when this is set, getting rate limited throws rate_limit_deferred instead of waiting it out,
+// so whoever's running this account can get other things done until the limit resets
+extern thread_local bool defer_rate_limits;
+
+class rate_limit_deferred : public msync_exception
+{
+public:
+	rate_limit_deferred(rate_limit_pacer::clock::time_point resets_at) noexcept : msync_exception("Rate limited."), resets_at(resets_at) {}
+
+	const rate_limit_pacer::clock::time_point resets_at;
+};
+
+// sets defer_rate_limits for as long as it's around
+class deferral_scope
+{
+public:
+	deferral_scope(bool defer) : previous(defer_rate_limits) { defer_rate_limits = defer; }
+	~deferral_scope() { defer_rate_limits = previous; }
+
+	deferral_scope(const deferral_scope&) = delete;
+	deferral_scope& operator=(const deferral_scope&) = delete;
+
+private:
+	const bool previous;
+};
+
+// sets current_pacer for as long as it's around
+class pacing_scope
+{
+public:
+	pacing_scope(rate_limit_pacer* pacer) : previous(current_pacer) { current_pacer = pacer; }
+	~pacing_scope() { current_pacer = previous; }
+
+	pacing_scope(const pacing_scope&) = delete;
+	pacing_scope& operator=(const pacing_scope&) = delete;
+
+private:
+	rate_limit_pacer* const previous;
+};
+
+#endif
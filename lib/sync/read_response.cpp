@@ -2,13 +2,21 @@
 
 #include <nlohmann/json.hpp>
 #include <print_logger.hpp>
+#include <msync_exception.hpp>
+
+#include <cstdint>
+#include <utility>
 
 #include "../util/util.hpp"
 
+#include "sync_stats.hpp"
+
 using json = nlohmann::json;
 
 using namespace std::string_view_literals;
 
+static constexpr const char* unexpected_root_message = "The server returned JSON that msync didn't expect.";
+
 template <typename T>
 T get_if_set(const json& parsed, const std::string_view key)
 {
@@ -32,173 +40,581 @@ std::string read_error(const std::string_view response_json)
 	return get_if_set<std::string>(parsed, "error"sv);
 }
 
-void from_json(const json& j, mastodon_poll_option& option)
+// Everything below here reads statuses and notifications straight out of the response text with nlohmann's SAX interface.
+// Building the whole DOM first and then picking through it with j["key"] lookups was most of the time and memory spent on each page.
+
+// what kind of JSON object or array the parser is currently inside of
+enum class json_frame : uint8_t
+{
+	status_array,
+	notification_array,
+	context,
+	status,
+	reblog,
+	notification,
+	account,
+	fields,
+	field,
+	attachments,
+	attachment,
+	mentions,
+	mention,
+	poll,
+	poll_options,
+	poll_option,
+	own_votes,
+	skipped // something we don't care about, along with everything inside it
+};
+
+// the fields that come from the boosted post if this status is a boost, and from the status itself otherwise
+struct post_fields
+{
+	std::string id;
+	std::string uri;
+	std::string in_reply_to_id;
+	std::string created_at;
+	unsigned int favorites = 0;
+	unsigned int boosts = 0;
+	unsigned int replies = 0;
+	std::vector<mastodon_attachment> attachments;
+	std::vector<std::pair<std::string, std::string>> mentions;
+	mastodon_account account;
+};
+
+// the JSON doesn't promise that "reblog" comes before or after anything else, so hang onto both halves until the status is done
+struct status_in_progress
+{
+	post_fields post;
+	post_fields reblog;
+	bool is_reblog = false;
+	std::string content_warning;
+	std::string content;
+	std::string visibility;
+	std::optional<mastodon_poll> poll;
+
+	mastodon_status finish()
+	{
+		mastodon_status status;
+		status.id = std::move(post.id);
+		status.url = std::move(post.uri);
+		status.content_warning = std::move(content_warning);
+		status.content = std::move(content);
+		status.visibility = std::move(visibility);
+		status.poll = std::move(poll);
+
+		// basically, if this post is a reblog, we want to get the rest of the stuff out of the nested reblog object.
+		post_fields& source = is_reblog ? reblog : post;
+		if (is_reblog)
+		{
+			status.boosted_by = std::move(post.account.account_name);
+			status.boosted_by_bot = post.account.is_bot;
+			status.boosted_by_display_name = std::move(post.account.display_name);
+			status.original_post_url = std::move(reblog.uri);
+			status.original_post_id = std::move(reblog.id);
+			status.boosted_at = std::move(post.created_at);
+		}
+
+		std::vector<std::pair<std::string_view, std::string_view>> mentions;
+		mentions.reserve(source.mentions.size());
+		for (const auto& mention : source.mentions)
+			mentions.emplace_back(mention.first, mention.second);
+		{
+			const timed_phase replacing{ sync_phase::mentions };
+			bulk_replace_mentions(status.content, mentions);
+		}
+
+		status.reply_to_post_id = std::move(source.in_reply_to_id);
+		status.created_at = std::move(source.created_at);
+		status.favorites = source.favorites;
+		status.boosts = source.boosts;
+		status.replies = source.replies;
+		status.attachments = std::move(source.attachments);
+		status.author = std::move(source.account);
+
+		return status;
+	}
+};
+
+std::string timed_clean_up_html(const std::string_view html)
+{
+	const timed_phase cleaning{ sync_phase::html_cleanup };
+	return clean_up_html(html);
+}
+
+notif_type parse_notif_type(const std::string_view type)
 {
-	j["title"].get_to(option.title);
-	j["votes_count"].get_to(option.votes);
+	if (type == "follow"sv) { return notif_type::follow; }
+	if (type == "mention"sv) { return notif_type::mention; }
+	if (type == "reblog"sv) { return notif_type::boost; }
+	if (type == "poll"sv) { return notif_type::poll; }
+	if (type == "favourite"sv) { return notif_type::favorite; }
+	return notif_type::unknown;
 }
 
-void from_json(const json& j, mastodon_poll& poll)
+class entity_reader
 {
-	j["id"].get_to(poll.id);
-	
-	const auto& expiry = j["expires_at"];
-	if (!expiry.is_null())
-		expiry.get_to(poll.expires_at);
-	j["expired"].get_to(poll.expired);
-	j["votes_count"].get_to(poll.total_votes);
-	j["options"].get_to(poll.options);
+public:
+	// root is what the whole document should be: a status, a notification, an array of either, or a context
+	entity_reader(json_frame root, account_projection accounts) : root(root), accounts(accounts) {}
 
-	const auto voted = j.find("voted"sv);
-	if (voted != j.end() && voted->is_boolean())
+	std::vector<mastodon_status> statuses;
+	std::vector<mastodon_notification> notifications;
+	mastodon_context context;
+
+	bool null()
 	{
-		voted->get_to(poll.you_voted);
+		check_scalar_allowed();
+		return true;
 	}
 
-	// this ones can be missing on your own polls
-	const auto own_votes = j.find("own_votes"sv);
-	if (own_votes != j.end() && own_votes->is_array())
+	bool number_float(json::number_float_t, const std::string&)
 	{
-		own_votes->get_to(poll.voted_for);
+		check_scalar_allowed();
+		return true;
 	}
-}
+	bool binary(json::binary_t&) { return true; }
 
-void from_json(const json& j, mastodon_account_field& field)
-{
-	j["name"].get_to(field.name);
-	field.value = clean_up_html(j["value"].get<std::string_view>()); // these can be HTML if they're links
-}
+	bool boolean(bool val)
+	{
+		check_scalar_allowed();
+		switch (frames.back())
+		{
+		case json_frame::account:
+			if (last_key == "bot"sv) { account->is_bot = val; }
+			break;
+		case json_frame::poll:
+			if (last_key == "expired"sv) { building.poll->expired = val; }
+			else if (last_key == "voted"sv) { building.poll->you_voted = val; }
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
 
-void from_json(const json& j, mastodon_account& account)
-{
-	j["id"].get_to(account.id);
-	j["acct"].get_to(account.account_name);
-	j["display_name"].get_to(account.display_name);
-	account.note = clean_up_html(j["note"].get<std::string_view>());
-	j["url"].get_to(account.url);
-	j["avatar"].get_to(account.avatar);
-	account.fields = get_if_set<std::vector<mastodon_account_field>>(j, "fields"sv);
-	j["bot"].get_to(account.is_bot);
-}
+	bool number_integer(json::number_integer_t val)
+	{
+		check_scalar_allowed();
+		// negative counts don't make any sense, so treat them as zero
+		return number(val < 0 ? 0 : static_cast<json::number_unsigned_t>(val));
+	}
 
-void from_json(const json& j, mastodon_attachment& attachment)
-{
-	j["url"].get_to(attachment.url);
-	attachment.description = get_if_set<std::string>(j, "description"sv);
-}
+	bool number_unsigned(json::number_unsigned_t val)
+	{
+		check_scalar_allowed();
+		return number(val);
+	}
 
-std::vector<std::pair<std::string_view, std::string_view>> get_mentions(const json& j)
-{
-	std::vector<std::pair<std::string_view, std::string_view>> to_return;
+	bool string(std::string& val)
+	{
+		check_scalar_allowed();
+		switch (frames.back())
+		{
+		case json_frame::status:
+			// the mastodon API says these will always be here, but do this to be safe.
+			// it also says that spoiler_text won't have html, but I'm not sure how correct that is
+			// i suspect it might at least have HTML entities that have to be cleaned up
+			if (last_key == "spoiler_text"sv) { building.content_warning = timed_clean_up_html(val); break; }
+			if (last_key == "content"sv) { building.content = timed_clean_up_html(val); break; }
+			if (last_key == "visibility"sv) { building.visibility = std::move(val); break; }
+			[[fallthrough]];
+		case json_frame::reblog:
+			if (last_key == "id"sv) { post->id = std::move(val); }
+			else if (last_key == "uri"sv) { post->uri = std::move(val); }
+			else if (last_key == "in_reply_to_id"sv) { post->in_reply_to_id = std::move(val); }
+			else if (last_key == "created_at"sv) { post->created_at = std::move(val); }
+			break;
+		case json_frame::account:
+			if (last_key == "acct"sv) { account->account_name = std::move(val); }
+			else if (last_key == "display_name"sv) { account->display_name = std::move(val); }
+			else if (last_key == "id"sv) { if (accounts.id) account->id = std::move(val); }
+			else if (last_key == "note"sv) { if (accounts.note) account->note = timed_clean_up_html(val); }
+			else if (last_key == "url"sv) { if (accounts.url) account->url = std::move(val); }
+			else if (last_key == "avatar"sv) { if (accounts.avatar) account->avatar = std::move(val); }
+			break;
+		case json_frame::field:
+			if (last_key == "name"sv) { account->fields.back().name = std::move(val); }
+			else if (last_key == "value"sv) { account->fields.back().value = timed_clean_up_html(val); } // these can be HTML if they're links
+			break;
+		case json_frame::attachment:
+			if (last_key == "url"sv) { post->attachments.back().url = std::move(val); }
+			else if (last_key == "description"sv) { post->attachments.back().description = std::move(val); }
+			break;
+		case json_frame::mention:
+			if (last_key == "username"sv) { post->mentions.back().first = std::move(val); }
+			else if (last_key == "acct"sv) { post->mentions.back().second = std::move(val); }
+			break;
+		case json_frame::poll:
+			if (last_key == "id"sv) { building.poll->id = std::move(val); }
+			else if (last_key == "expires_at"sv) { building.poll->expires_at = std::move(val); }
+			break;
+		case json_frame::poll_option:
+			if (last_key == "title"sv) { building.poll->options.back().title = std::move(val); }
+			break;
+		case json_frame::notification:
+			if (last_key == "id"sv) { notifications.back().id = std::move(val); }
+			else if (last_key == "type"sv) { notifications.back().type = parse_notif_type(val); }
+			else if (last_key == "created_at"sv) { notifications.back().created_at = std::move(val); }
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
 
-	const auto& mentions = j["mentions"];
+	bool key(std::string& val)
+	{
+		// swap so the old key's buffer gets reused
+		last_key.swap(val);
+		return true;
+	}
 
-	if (mentions.is_null() || !mentions.is_array()) { return to_return; }
+	bool start_object(std::size_t)
+	{
+		if (frames.empty())
+		{
+			if (root != json_frame::status && root != json_frame::notification && root != json_frame::context)
+				throw msync_exception(unexpected_root_message);
+
+			if (root == json_frame::status)
+				start_status();
+			else if (root == json_frame::notification)
+				notifications.emplace_back();
+
+			frames.push_back(root);
+			return true;
+		}
+
+		frames.push_back(object_frame());
+		return true;
+	}
 
-	for (const auto& mention : mentions)
+	bool end_object()
 	{
-		to_return.emplace_back(mention["username"].get<std::string_view>(), mention["acct"].get<std::string_view>());
+		const json_frame ending = frames.back();
+		frames.pop_back();
+
+		if (ending == json_frame::status)
+		{
+			if (building.post.id.empty())
+				throw msync_exception(unexpected_root_message);
+
+			if (!frames.empty() && frames.back() == json_frame::notification)
+				notifications.back().status = building.finish();
+			else
+				status_target->push_back(building.finish());
+		}
+		else if (ending == json_frame::notification)
+		{
+			if (notifications.back().id.empty())
+				throw msync_exception(unexpected_root_message);
+		}
+		else if (ending == json_frame::reblog)
+		{
+			post = &building.post;
+		}
+
+		return true;
 	}
 
-	return to_return;
-}
+	bool start_array(std::size_t)
+	{
+		if (frames.empty())
+		{
+			if (root != json_frame::status_array && root != json_frame::notification_array)
+				throw msync_exception(unexpected_root_message);
 
-void from_json(const json& j, mastodon_status& status)
-{
-	j["id"].get_to(status.id);
-	j["uri"].get_to(status.url);
+			frames.push_back(root);
+			return true;
+		}
+
+		frames.push_back(array_frame());
+		return true;
+	}
+
+	bool end_array()
+	{
+		frames.pop_back();
+		return true;
+	}
 
-	// the mastodon API says these will always be here, but do this to be safe.
-	// it also says that spoiler_text won't have html, but I'm not sure how correct that is
-	// i suspect it might at least have HTML entities that have to be cleaned up
-	status.content_warning = clean_up_html(get_if_set<std::string_view>(j, "spoiler_text"sv));
-	status.content = clean_up_html(get_if_set<std::string_view>(j, "content"sv));
+	template <typename Exception>
+	bool parse_error(std::size_t, const std::string&, const Exception& ex)
+	{
+		// same as what json::parse would do
+		throw ex;
+	}
 
-	j["visibility"].get_to(status.visibility);
+private:
+	const json_frame root;
+	const account_projection accounts;
+	std::vector<json_frame> frames;
+	std::string last_key;
 
-	// basically, if this post is a reblog, we want to get the rest of the stuff out of the nested reblog object.
+	status_in_progress building;
+	post_fields* post = &building.post;
+	mastodon_account* account = nullptr;
+	std::vector<mastodon_status>* status_target = &statuses;
 
-	const auto is_reblog = j.find("reblog"sv);
-	const json* post = &j;
-	if (is_reblog != j.end() && is_reblog->is_object())
+	// a bare value at the top level or in place of a status or notification in a list means this isn't what we asked for
+	void check_scalar_allowed() const
 	{
-		post = &*is_reblog;
-		j["account"]["acct"].get_to(status.boosted_by);
-		j["account"]["bot"].get_to(status.boosted_by_bot);
-		j["account"]["display_name"].get_to(status.boosted_by_display_name);
-		post->at("uri").get_to(status.original_post_url);
-		post->at("id").get_to(status.original_post_id);
+		if (frames.empty() || frames.back() == json_frame::status_array || frames.back() == json_frame::notification_array)
+			throw msync_exception(unexpected_root_message);
 	}
 
-	bulk_replace_mentions(status.content, get_mentions(*post));
-	status.reply_to_post_id = get_if_set<std::string>(*post, "in_reply_to_id"sv);
+	void start_status()
+	{
+		building = status_in_progress{};
+		post = &building.post;
+	}
 
-	post->at("created_at").get_to(status.created_at);
-	post->at("favourites_count").get_to(status.favorites);
-	post->at("reblogs_count").get_to(status.boosts);
-	post->at("replies_count").get_to(status.replies);
+	bool number(json::number_unsigned_t val)
+	{
+		switch (frames.back())
+		{
+		case json_frame::status:
+		case json_frame::reblog:
+			if (last_key == "favourites_count"sv) { post->favorites = static_cast<unsigned int>(val); }
+			else if (last_key == "reblogs_count"sv) { post->boosts = static_cast<unsigned int>(val); }
+			else if (last_key == "replies_count"sv) { post->replies = static_cast<unsigned int>(val); }
+			break;
+		case json_frame::poll:
+			if (last_key == "votes_count"sv) { building.poll->total_votes = static_cast<int>(val); }
+			break;
+		case json_frame::poll_option:
+			if (last_key == "votes_count"sv) { building.poll->options.back().votes = static_cast<int>(val); }
+			break;
+		case json_frame::own_votes:
+			building.poll->voted_for.push_back(static_cast<int>(val));
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
 
-	post->at("media_attachments").get_to(status.attachments);
-	post->at("account").get_to(status.author);
+	// figure out what an object we're about to step into is, based on where we are and what key it's under
+	json_frame object_frame()
+	{
+		switch (frames.back())
+		{
+		case json_frame::status_array:
+			start_status();
+			return json_frame::status;
+		case json_frame::notification_array:
+			notifications.emplace_back();
+			return json_frame::notification;
+		case json_frame::status:
+			if (last_key == "reblog"sv)
+			{
+				building.is_reblog = true;
+				post = &building.reblog;
+				return json_frame::reblog;
+			}
+			if (last_key == "poll"sv)
+			{
+				building.poll.emplace();
+				return json_frame::poll;
+			}
+			[[fallthrough]];
+		case json_frame::reblog:
+			if (last_key == "account"sv)
+			{
+				account = &post->account;
+				return json_frame::account;
+			}
+			return json_frame::skipped;
+		case json_frame::notification:
+			if (last_key == "account"sv)
+			{
+				account = &notifications.back().account;
+				return json_frame::account;
+			}
+			if (last_key == "status"sv)
+			{
+				start_status();
+				return json_frame::status;
+			}
+			return json_frame::skipped;
+		case json_frame::fields:
+			account->fields.emplace_back();
+			return json_frame::field;
+		case json_frame::attachments:
+			post->attachments.emplace_back();
+			return json_frame::attachment;
+		case json_frame::mentions:
+			post->mentions.emplace_back();
+			return json_frame::mention;
+		case json_frame::poll_options:
+			building.poll->options.emplace_back();
+			return json_frame::poll_option;
+		default:
+			return json_frame::skipped;
+		}
+	}
 
-	const auto poll = j.find("poll"sv);
-	if (poll != j.end() && poll->is_object())
+	json_frame array_frame()
 	{
-		status.poll = poll->get<mastodon_poll>();
+		switch (frames.back())
+		{
+		case json_frame::context:
+			if (last_key == "ancestors"sv)
+			{
+				status_target = &context.ancestors;
+				return json_frame::status_array;
+			}
+			if (last_key == "descendants"sv)
+			{
+				status_target = &context.descendants;
+				return json_frame::status_array;
+			}
+			return json_frame::skipped;
+		case json_frame::status:
+		case json_frame::reblog:
+			if (last_key == "media_attachments"sv) { return json_frame::attachments; }
+			if (last_key == "mentions"sv) { return json_frame::mentions; }
+			return json_frame::skipped;
+		case json_frame::account:
+			if (accounts.fields && last_key == "fields"sv) { return json_frame::fields; }
+			return json_frame::skipped;
+		case json_frame::poll:
+			if (last_key == "options"sv) { return json_frame::poll_options; }
+			// this one can be missing on your own polls
+			if (last_key == "own_votes"sv) { return json_frame::own_votes; }
+			return json_frame::skipped;
+		default:
+			return json_frame::skipped;
+		}
 	}
-}
+};
 
-void from_json(const json& j, mastodon_context& context)
+// only looks at the top level ids, so it's much cheaper than reading the whole page
+class page_summary_reader
 {
-	j["ancestors"].get_to(context.ancestors);
-	j["descendants"].get_to(context.descendants);
-}
+public:
+	page_summary summary;
 
-NLOHMANN_JSON_SERIALIZE_ENUM(notif_type, {
-		{ notif_type::unknown, "???" }, //nlohmann json will pick the first one in the list if it can't parse
-		{ notif_type::follow, "follow" },
-		{ notif_type::mention, "mention" },
-		{ notif_type::boost, "reblog" },
-		{ notif_type::poll, "poll" },
-		{ notif_type::favorite, "favourite" },
-	})
+	bool null() { return true; }
+	bool boolean(bool) { return check_not_root(); }
+	bool number_integer(json::number_integer_t) { return check_not_root(); }
+	bool number_unsigned(json::number_unsigned_t) { return check_not_root(); }
+	bool number_float(json::number_float_t, const std::string&) { return check_not_root(); }
+	bool binary(json::binary_t&) { return check_not_root(); }
 
-void from_json(const json& j, mastodon_notification& notif)
-{
-	j["id"].get_to(notif.id);
-	j["type"].get_to(notif.type);
-	j["created_at"].get_to(notif.created_at);
-	j["account"].get_to(notif.account);
-	const auto status = j.find("status"sv);
-	if (status != j.end() && status->is_object())
+	bool string(std::string& val)
+	{
+		check_not_root();
+		if (depth == 2 && is_id)
+		{
+			if (summary.count == 1 && summary.first_id.empty())
+				summary.first_id = val;
+			summary.last_id = std::move(val);
+		}
+		return true;
+	}
+
+	bool key(std::string& val)
+	{
+		is_id = val == "id"sv;
+		return true;
+	}
+
+	bool start_object(std::size_t)
+	{
+		check_not_root();
+		if (depth == 1)
+			summary.count++;
+		depth++;
+		return true;
+	}
+
+	bool end_object()
+	{
+		depth--;
+		return true;
+	}
+
+	bool start_array(std::size_t)
+	{
+		depth++;
+		return true;
+	}
+
+	bool end_array()
+	{
+		depth--;
+		return true;
+	}
+
+	template <typename Exception>
+	bool parse_error(std::size_t, const std::string&, const Exception& ex)
+	{
+		throw ex;
+	}
+
+private:
+	unsigned int depth = 0;
+	bool is_id = false;
+
+	bool check_not_root() const
 	{
-		notif.status = status->get<mastodon_status>();
+		if (depth == 0)
+			throw msync_exception(unexpected_root_message);
+		return true;
 	}
+};
+
+page_summary read_page_summary(const std::string_view page_json)
+{
+	page_summary_reader reader;
+	json::sax_parse(page_json, &reader);
+	return std::move(reader.summary);
+}
+
+void read_entities(const std::string_view json_text, entity_reader& reader)
+{
+	const timed_phase parsing{ sync_phase::parse };
+	json::sax_parse(json_text, &reader);
 }
 
-mastodon_status read_status(const std::string_view status_json)
+mastodon_status read_status(const std::string_view status_json, const account_projection accounts)
 {
-	return json::parse(status_json).get<mastodon_status>();
+	entity_reader reader{ json_frame::status, accounts };
+	read_entities(status_json, reader);
+	if (reader.statuses.empty())
+		throw msync_exception("Expected a status from the server and didn't get one.");
+	return std::move(reader.statuses.front());
 }
 
-std::vector<mastodon_status> read_statuses(const std::string_view timeline_json)
+std::vector<mastodon_status> read_statuses(const std::string_view timeline_json, const account_projection accounts)
 {
-	return json::parse(timeline_json).get<std::vector<mastodon_status>>();
+	entity_reader reader{ json_frame::status_array, accounts };
+	read_entities(timeline_json, reader);
+	return std::move(reader.statuses);
 }
 
-mastodon_notification read_notification(const std::string_view notification_json)
+mastodon_notification read_notification(const std::string_view notification_json, const account_projection accounts)
 {
-	return json::parse(notification_json).get<mastodon_notification>();
+	entity_reader reader{ json_frame::notification, accounts };
+	read_entities(notification_json, reader);
+	if (reader.notifications.empty())
+		throw msync_exception("Expected a notification from the server and didn't get one.");
+	return std::move(reader.notifications.front());
 }
 
-std::vector<mastodon_notification> read_notifications(const std::string_view notifications_json)
+std::vector<mastodon_notification> read_notifications(const std::string_view notifications_json, const account_projection accounts)
 {
-	return json::parse(notifications_json).get<std::vector<mastodon_notification>>();
+	entity_reader reader{ json_frame::notification_array, accounts };
+	read_entities(notifications_json, reader);
+	return std::move(reader.notifications);
 }
 
-mastodon_context read_context(const std::string_view context_json)
+mastodon_context read_context(const std::string_view context_json, const account_projection accounts)
 {
-	return json::parse(context_json).get<mastodon_context>();
+	entity_reader reader{ json_frame::context, accounts };
+	read_entities(context_json, reader);
+	return std::move(reader.context);
 }
 
 std::string read_upload_id(const std::string_view attachment_json)
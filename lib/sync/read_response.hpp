@@ -9,11 +9,23 @@
 
 std::string read_error(std::string_view response_json);
 
-mastodon_status read_status(std::string_view status_json);
-std::vector<mastodon_status> read_statuses(std::string_view timeline_json);
-mastodon_notification read_notification(std::string_view notification_json);
-std::vector<mastodon_notification> read_notifications(std::string_view notifications_json);
-mastodon_context read_context(std::string_view context_json);
+// the account projection says which parts of each account (authors, boosters, notification senders) to actually read
+mastodon_status read_status(std::string_view status_json, account_projection accounts = full_account);
+std::vector<mastodon_status> read_statuses(std::string_view timeline_json, account_projection accounts = full_account);
+mastodon_notification read_notification(std::string_view notification_json, account_projection accounts = full_account);
+std::vector<mastodon_notification> read_notifications(std::string_view notifications_json, account_projection accounts = full_account);
+mastodon_context read_context(std::string_view context_json, account_projection accounts = full_account);
+
 std::string read_upload_id(std::string_view attachment_json);
 
+// just enough about a page of statuses or notifications to ask for the next one
+struct page_summary
+{
+	size_t count = 0;
+	std::string first_id;
+	std::string last_id;
+};
+
+page_summary read_page_summary(std::string_view page_json);
+
 #endif
@@ -9,10 +9,13 @@
 #include "../options/user_options.hpp"
 
 #include "../postlist/post_list.hpp"
+#include "../postlist/list_compression.hpp"
 #include "../util/util.hpp"
 
 #include "sync_helpers.hpp"
 #include "recv_helpers.hpp"
+#include "bounded_queue.hpp"
+#include "sync_stats.hpp"
 
 #include <filesystem.hpp>
 #include <string_view>
@@ -21,14 +24,27 @@
 #include <limits>
 #include <array>
 #include <utility>
+#include <thread>
+#include <sstream>
+#include <exception>
 
 template <typename get_posts>
 struct recv_posts
 {
 public:
 	unsigned int retries = 3;
+	// how long to wait between retries after timeouts and server errors
+	backoff_policy backoff;
 	unsigned int max_requests = 0;
 	unsigned int per_call = 0;
+	// if nonzero, request up to this many pages ahead on another thread while the current one is being read and written
+	unsigned int prefetch = 0;
+	// when syncing newest first, write downloaded posts out to a temporary file once this many are being held. 0 means never.
+	unsigned int max_buffered_posts = 1000;
+	// if set, time spent on each timeline gets broken down and added to this
+	stats_report* stats = nullptr;
+	// when an account splits its timelines up by size, how big each piece gets
+	uint64_t segment_bytes = Default_Segment_Bytes;
 
 	recv_posts(get_posts& post_downloader) : download(post_downloader) {};
 
@@ -46,14 +62,23 @@ public:
 		// otherwise, .filename() would get nothing.
 		const std::string account_name = to_utf8(account.get_user_directory().filename());
 
-		pl() << "Downloading notifications for " << account_name << '\n';
-		update_timeline<to_get::notifications, mastodon_notification, true>(account, account.get_user_directory(), clamp_or_default(per_call, 30));
+		{
+			const stats_section section{ stats, account_name, "notifications" };
+			pl() << "Downloading notifications for " << account_name << '\n';
+			update_timeline<to_get::notifications, mastodon_notification, true>(account, account.get_user_directory(), clamp_or_default(per_call, 30));
+		}
 
-		pl() << "Downloading the home timeline for " << account_name << '\n';
-		update_timeline<to_get::home, mastodon_status>(account, account.get_user_directory(), clamp_or_default(per_call, 40));
+		{
+			const stats_section section{ stats, account_name, "home" };
+			pl() << "Downloading the home timeline for " << account_name << '\n';
+			update_timeline<to_get::home, mastodon_status>(account, account.get_user_directory(), clamp_or_default(per_call, 40));
+		}
 
-		pl() << "Downloading bookmarks for " << account_name << '\n';
-		update_timeline<to_get::bookmarks, mastodon_status>(account, account.get_user_directory(), clamp_or_default(per_call, 40));
+		{
+			const stats_section section{ stats, account_name, "bookmarks" };
+			pl() << "Downloading bookmarks for " << account_name << '\n';
+			update_timeline<to_get::bookmarks, mastodon_status>(account, account.get_user_directory(), clamp_or_default(per_call, 40));
+		}
 	}
 
 private:
@@ -88,33 +113,58 @@ private:
 		// the other thing to keep in mind is that the newest posts are first back from the API (that is, the highest ID is at position 0)
 		// but should be written to the file so that the newest post is at the bottom of the file, and so the lowest ID should be written first
 
-		const fs::path target_file = user_folder / params.filename;
+		const list_format format = account.get_list_format();
+		const fs::path target_file = list_file_for(user_folder / params.filename, format);
 		plverb() << "Writing to " << target_file << '\n';
 
-		post_list<mastodon_entity> writer{ target_file };
+		// the timelines get an index so msync show and msync list can find things in them quickly
+		const segment_policy segments{ params.segmented ? account.get_list_segments() : list_segments::off, segment_bytes };
+		post_list<mastodon_entity> writer{ target_file, true, format, segments };
 		std::string highest_id;
 
-		if (last_recorded_id.empty() || sync_method == sync_settings::newest_first)
+		try
 		{
-			highest_id = newest_first<mastodon_entity, use_excludes>(writer, url, access_token, last_recorded_id, limit);
+			if (last_recorded_id.empty() || sync_method == sync_settings::newest_first)
+			{
+				highest_id = newest_first<mastodon_entity, use_excludes>(writer, target_file, url, access_token, last_recorded_id, limit);
+			}
+			else if (sync_method == sync_settings::oldest_first) //else if because dont_sync is an option (not that a dont_sync should get here) and to save a comparison
+			{
+				oldest_first<mastodon_entity, use_excludes>(writer, url, access_token, last_recorded_id, limit, highest_id);
+			}
 		}
-		else if (sync_method == sync_settings::oldest_first) //else if because dont_sync is an option (not that a dont_sync should get here) and to save a comparison
+		catch (const rate_limit_deferred&)
 		{
-			highest_id = oldest_first<mastodon_entity, use_excludes>(writer, url, access_token, last_recorded_id, limit);
+			// this timeline gets picked back up once the rate limit resets.
+			// oldest first already wrote out everything it got, so save how far it got.
+			// newest first hasn't written anything yet, and has to start over from the top, since there might be new posts by then.
+			if (!highest_id.empty())
+				account.set_option(params.last_id_setting, std::move(highest_id));
+			throw;
 		}
 
 		if (!highest_id.empty())
 		{
 			account.set_option(params.last_id_setting, std::move(highest_id));
 		}
+
+		// any segments this finished off won't change again, so they can be compressed now
+		const timed_phase compressing{ sync_phase::file_write };
+		compress_finished_segments(target_file);
 	}
 
 	template <typename mastodon_entity, bool use_excludes>
-	std::string newest_first(post_list<mastodon_entity>& writer, const std::string_view url, const std::string_view access_token, const std::string_view last_recorded_id, unsigned int limit)
+	std::string newest_first(post_list<mastodon_entity>& writer, const fs::path& target_file, const std::string_view url, const std::string_view access_token, const std::string_view last_recorded_id, unsigned int limit)
 	{
-		std::string max_id;
+		std::string newest_id;
+
+		std::vector<mastodon_entity> total;
 
-		std::vector<mastodon_entity> total, incoming;
+		// the newest posts come in first, but have to be written last.
+		// if too many pile up, write what we have out to a temporary file and put them all together at the end
+		spill_segments spilled{ target_file };
+		// so writer can still split the spilled posts up by month or size when it copies them in
+		std::vector<std::vector<written_post>> spilled_layouts;
 
 		timeline_params query_parameters;
 		query_parameters.since_id = last_recorded_id;
@@ -128,63 +178,54 @@ private:
 		if (loop_iterations == 0)
 			loop_iterations = last_recorded_id.empty() ? 5 : std::numeric_limits<unsigned int>::max();
 
-		do
+		size_t total_downloaded = 0;
+		fetch_pages<mastodon_entity, paging::older>(url, access_token, query_parameters, limit, loop_iterations, [&](std::vector<mastodon_entity>&& incoming)
 		{
-			query_parameters.max_id = max_id;
-
-			print_api_call(url, limit, query_parameters, pl());
-
-			auto response = request_with_retries([&]() { return download(url, access_token, query_parameters, limit); }, retries, pl());
-
-			print_statistics(pl(), response.time_ms, response.tries);
+			plverb() << "Downloaded " << incoming.size() << pluralize(incoming.size(), " post, ", " posts, ");
 
-			if (!response.success)
-			{
-				break;
-			}
+			if (newest_id.empty() && !incoming.empty())
+				newest_id = highest_id(incoming);
 
-			incoming = deserialize<mastodon_entity>(response.message);
+			total_downloaded += incoming.size();
+			total.insert(total.end(), std::make_move_iterator(incoming.begin()), std::make_move_iterator(incoming.end()));
 
-			plverb() << "Downloaded " << incoming.size() << pluralize(incoming.size(), " post, ", " posts, ");
+			plverb() << total_downloaded << pluralize(total_downloaded, " post", " posts") << " buffered.\n";
 
-			if (!incoming.empty())
+			if (max_buffered_posts != 0 && total.size() >= max_buffered_posts)
 			{
-				// can only call lowest_id on a non-empty vector
-				max_id = lowest_id(incoming);
-				total.insert(total.end(), std::make_move_iterator(incoming.begin()), std::make_move_iterator(incoming.end()));
+				const fs::path& segment = spilled.next();
+				plverb() << "Holding " << total.size() << pluralize(total.size(), " post", " posts") << " in " << segment << ".\n";
+
+				const timed_phase writing{ sync_phase::file_write };
+				post_list<mastodon_entity> segment_writer{ segment, false, writer.output_format() };
+				segment_writer.keep_layout();
+				segment_writer.write(total.rbegin(), total.rend());
+				spilled_layouts.push_back(segment_writer.take_layout());
+				total.clear();
 			}
+		});
 
-			plverb() << total.size() << pluralize(total.size(), " post", " posts") << " buffered.\n";
+		plverb() << "Writing " << total_downloaded << pluralize(total_downloaded, " post.", " posts.") << '\n';
 
-			loop_iterations--;
+		// we want the latest post (highest ID) to be last, but it's in position 0, so iterate backwards
+		// the oldest posts are the ones still in memory, then each segment is newer than the one written after it
+		const timed_phase writing{ sync_phase::file_write };
+		writer.write(total.rbegin(), total.rend());
+		for (size_t i = spilled.paths.size(); i > 0; i--)
+			writer.append(spilled.paths[i - 1], spilled_layouts[i - 1]);
 
-			// if you get less than you asked for, you're done
-		} while (loop_iterations > 0 && (incoming.size() == limit));
-
-		plverb() << "Writing " << total.size() << pluralize(total.size(), " post.", " posts.") << '\n';
-
-		if (!total.empty())
-		{
-			// we want the latest post (highest ID) to be last, but it's in position 0, so iterate backwards
-			std::for_each(total.rbegin(), total.rend(), [&writer](const auto& elem) { writer.write(elem); });
-			return total.front().id;
-		}
-
-		return "";
+		return newest_id;
 	}
 
+	// highest_id_seen is kept up to date as each page is written, so it's still right if this throws
 	template <typename mastodon_entity, bool use_excludes>
-	std::string oldest_first(post_list<mastodon_entity>& writer, const std::string_view url, const std::string_view access_token, const std::string_view last_recorded_id, unsigned int limit)
+	void oldest_first(post_list<mastodon_entity>& writer, const std::string_view url, const std::string_view access_token, const std::string_view last_recorded_id, unsigned int limit, std::string& highest_id_seen)
 	{
-		std::vector<mastodon_entity> incoming;
-
 		timeline_params query_parameters;
 		query_parameters.min_id = last_recorded_id;
 
 		if constexpr (use_excludes) { query_parameters.exclude_notifs = &exclude_notif_types; }
 
-		std::string highest_id_seen;
-
 		// max_requests being zero means "request until caught up".
 		// oldest_first doesn't have to worry about that "first time" weirdness, the first download will always use newest_first
 		unsigned int loop_iterations = max_requests;
@@ -192,39 +233,184 @@ private:
 			loop_iterations = std::numeric_limits<unsigned int>::max();
 
 		size_t total_posts_written = 0;
+		fetch_pages<mastodon_entity, paging::newer>(url, access_token, query_parameters, limit, loop_iterations, [&](std::vector<mastodon_entity>&& incoming)
+		{
+			plverb() << "Writing " << incoming.size() << pluralize(incoming.size(), " post.", " posts.") << '\n';
+			total_posts_written += incoming.size();
+
+			if (!incoming.empty())
+			{
+				highest_id_seen = highest_id(incoming);
+
+				// we want the latest post (highest ID) to be last, but it's in position 0, so iterate backwards
+				// the whole page goes out in one write
+				const timed_phase writing{ sync_phase::file_write };
+				writer.write(incoming.rbegin(), incoming.rend());
+			}
+		});
+
+		plverb() << "Wrote a total of " << total_posts_written << pluralize(total_posts_written, " post.", " posts.") << '\n';
+	}
+
+	// makes requests until caught up (a page comes back with fewer posts than asked for), a request fails, or loop_iterations requests have been made,
+	// handing each page to on_page in order. older pages backwards from the newest with max_id, newer pages forwards with min_id.
+	template <typename mastodon_entity, paging direction, typename page_callback>
+	void fetch_pages(const std::string_view url, const std::string_view access_token, timeline_params query_parameters, unsigned int limit, unsigned int loop_iterations, page_callback on_page)
+	{
+		if (prefetch > 0)
+		{
+			prefetch_pages<mastodon_entity, direction>(url, access_token, query_parameters, limit, loop_iterations, on_page);
+			return;
+		}
+
+		std::string cursor;
+		bool full_page = false;
 		do
 		{
 			print_api_call(url, limit, query_parameters, pl());
 
-			const auto response = request_with_retries([&]() { return download(url, access_token, query_parameters, limit); }, retries, pl());
+			const auto response = request_with_retries([&]() { return download(url, access_token, query_parameters, limit); }, retries, pl(), backoff);
 
-			print_statistics(pl(), response.time_ms, response.tries);
+			print_statistics(pl(), response.time_ms, response.tries, response.backoff_ms);
 
 			if (!response.success)
 			{
 				break;
 			}
 
-			incoming = deserialize<mastodon_entity>(response.message);
+			auto incoming = read_page<mastodon_entity>(response.message);
 
-			plverb() << "Writing " << incoming.size() << pluralize(incoming.size(), " post.", " posts.") << '\n';
-			total_posts_written += incoming.size();
+			// if you get less than you asked for, you're done
+			full_page = incoming.size() == limit;
 
 			if (!incoming.empty())
 			{
-				query_parameters.min_id = highest_id_seen = highest_id(incoming);
-
-				// we want the latest post (highest ID) to be last, but it's in position 0, so iterate backwards
-				std::for_each(incoming.rbegin(), incoming.rend(), [&writer](const auto& elem) { writer.write(elem); });
+				// can only call lowest_id or highest_id on a non-empty vector
+				cursor = direction == paging::older ? lowest_id(incoming) : highest_id(incoming);
+				move_cursor<direction>(query_parameters, cursor);
 			}
 
+			on_page(std::move(incoming));
+
 			--loop_iterations;
+		} while (loop_iterations > 0 && full_page);
+	}
 
-			// if you get less than you asked for, you're done
-		} while (loop_iterations > 0 && (incoming.size() == limit));
+	// same as the loop above, but requests happen on another thread and get up to prefetch pages ahead of on_page.
+	// the ids needed for the next request are picked out of each page without reading the whole thing,
+	// and what would have been logged for each request is held and logged here, in order, when its page comes up.
+	template <typename mastodon_entity, paging direction, typename page_callback>
+	void prefetch_pages(const std::string_view url, const std::string_view access_token, timeline_params query_parameters, unsigned int limit, unsigned int loop_iterations, page_callback& on_page)
+	{
+		struct fetched_page
+		{
+			request_response response;
+			std::string log;
+		};
 
-		plverb() << "Wrote a total of " << total_posts_written << pluralize(total_posts_written, " post.", " posts.") << '\n';
-		return highest_id_seen;
+		bounded_queue<fetched_page> pages{ prefetch };
+		std::exception_ptr fetch_error;
+
+		// the fetcher gets its own stats so the two threads aren't writing to the same ones, and they're combined at the end
+		sync_stats* const page_stats = current_stats;
+		sync_stats fetcher_stats;
+		// the pacer, on the other hand, has to be shared, since it's the same limit
+		rate_limit_pacer* const pacer = current_pacer;
+		const bool deferring = defer_rate_limits;
+
+		std::thread fetcher([&]()
+		{
+			current_stats = page_stats == nullptr ? nullptr : &fetcher_stats;
+			current_pacer = pacer;
+			defer_rate_limits = deferring;
+			try
+			{
+				std::string cursor;
+				bool full_page = false;
+				do
+				{
+					std::ostringstream log;
+					print_api_call(url, limit, query_parameters, log);
+
+					auto response = request_with_retries([&]() { return download(url, access_token, query_parameters, limit); }, retries, log, backoff);
+
+					print_statistics(log, response.time_ms, response.tries, response.backoff_ms);
+
+					if (!response.success)
+					{
+						pages.push(fetched_page{ std::move(response), log.str() });
+						break;
+					}
+
+					const page_summary summary = read_page_summary(response.message);
+
+					full_page = summary.count == limit;
+
+					if (summary.count > 0)
+					{
+						cursor = direction == paging::older ? summary.last_id : summary.first_id;
+						move_cursor<direction>(query_parameters, cursor);
+					}
+
+					// this only fails if on_page threw and nobody's listening anymore
+					if (!pages.push(fetched_page{ std::move(response), log.str() }))
+						break;
+
+					--loop_iterations;
+				} while (loop_iterations > 0 && full_page);
+			}
+			catch (...)
+			{
+				fetch_error = std::current_exception();
+			}
+			pages.close();
+		});
+
+		try
+		{
+			while (auto page = pages.pop())
+			{
+				pl() << page->log;
+
+				if (!page->response.success)
+					break;
+
+				on_page(read_page<mastodon_entity>(page->response.message));
+			}
+		}
+		catch (...)
+		{
+			pages.close();
+			fetcher.join();
+			throw;
+		}
+
+		pages.close();
+		fetcher.join();
+
+		if (page_stats != nullptr)
+			*page_stats += fetcher_stats;
+
+		if (fetch_error != nullptr)
+			std::rethrow_exception(fetch_error);
+	}
+
+	template <typename mastodon_entity>
+	std::vector<mastodon_entity> read_page(const std::string& json)
+	{
+		auto page = deserialize<mastodon_entity>(json);
+		if (current_stats != nullptr)
+			current_stats->posts += page.size();
+		return page;
+	}
+
+	template <paging direction>
+	static void move_cursor(timeline_params& query_parameters, const std::string& cursor)
+	{
+		if constexpr (direction == paging::older)
+			query_parameters.max_id = cursor;
+		else
+			query_parameters.min_id = cursor;
 	}
 };
 
@@ -3,16 +3,25 @@
 
 #include <string_view>
 #include <string>
+#include <vector>
+
+#include <filesystem.hpp>
 
 #include "../options/user_options.hpp"
 
 #include "../constants/constants.hpp"
 
+#include "../postlist/post_list.hpp"
+
 #include "read_response.hpp"
 
 enum class to_get { notifications, home, dms, lists, bookmarks };
 
-struct recv_parameters { user_option last_id_setting; user_option sync_setting; std::string_view route; const CONSTANT_PATH_TYPE& filename; };
+// whether to page backwards from the newest posts (newest_first) or forwards from the last one we saw (oldest_first)
+enum class paging { older, newer };
+
+// segmented is whether the timeline can be split up into segments. bookmarks aren't in order by date, so they can't be split up by month.
+struct recv_parameters { user_option last_id_setting; user_option sync_setting; std::string_view route; const CONSTANT_PATH_TYPE& filename; bool segmented; };
 
 constexpr std::string_view home_route{ "/api/v1/timelines/home" };
 constexpr std::string_view notifications_route{ "/api/v1/notifications" };
@@ -23,20 +32,56 @@ CONSTEXPR_IF_NOT_BOOST recv_parameters get_parameters()
 {
 	if CONSTEXPR_IF_NOT_BOOST (timeline == to_get::notifications)
 	{
-		return { user_option::last_notification_id, user_option::pull_notifications, notifications_route, Notifications_Filename };
+		return { user_option::last_notification_id, user_option::pull_notifications, notifications_route, Notifications_Filename, true };
 	}
 
 	if CONSTEXPR_IF_NOT_BOOST (timeline == to_get::home)
 	{
-		return { user_option::last_home_id, user_option::pull_home, home_route, Home_Timeline_Filename };
+		return { user_option::last_home_id, user_option::pull_home, home_route, Home_Timeline_Filename, true };
 	}
 
 	if CONSTEXPR_IF_NOT_BOOST (timeline == to_get::bookmarks)
 	{
-		return { user_option::last_bookmark_id, user_option::pull_bookmarks, bookmarks_route, Bookmarks_Filename };
+		return { user_option::last_bookmark_id, user_option::pull_bookmarks, bookmarks_route, Bookmarks_Filename, false };
 	}
 }
 
+// temporary files named after the target file with .spill0, .spill1, and so on tacked on.
+// cleaned up when this goes out of scope.
+struct spill_segments
+{
+	spill_segments(const fs::path& target) : prefix(fs::path(target).concat(".spill")) {}
+
+	spill_segments(const spill_segments&) = delete;
+	spill_segments& operator=(const spill_segments&) = delete;
+
+	~spill_segments()
+	{
+#if MSYNC_USE_BOOST
+		boost::system::error_code err;
+#else
+		std::error_code err;
+#endif
+		for (const auto& segment : paths)
+			fs::remove(segment, err);
+	}
+
+	// the path to a new, empty segment
+	const fs::path& next()
+	{
+		paths.push_back(fs::path(prefix).concat(std::to_string(paths.size())));
+		// in case one got left behind last time
+		if (fs::exists(paths.back()))
+			fs::remove(paths.back());
+		return paths.back();
+	}
+
+	std::vector<fs::path> paths;
+
+private:
+	const fs::path prefix;
+};
+
 template <typename entity>
 std::string highest_id(const std::vector<entity>& chunk)
 {
@@ -62,13 +107,13 @@ std::vector<entity> deserialize(const std::string& json);
 template <>
 std::vector<mastodon_notification> deserialize(const std::string& json)
 {
-	return read_notifications(json);
+	return read_notifications(json, post_list_account);
 }
 
 template <>
 std::vector<mastodon_status> deserialize(const std::string& json)
 {
-	return read_statuses(json);
+	return read_statuses(json, post_list_account);
 }
 
 std::string_view get_or_empty(const std::string* str)
@@ -8,9 +8,13 @@
 #include <algorithm>
 #include <utility>
 #include <deque>
+#include <vector>
+#include <atomic>
+#include <iterator>
 
 #include "../netinterface/net_interface.hpp"
 #include "../queue/queues.hpp"
+#include "../queue/queue_journal.hpp"
 #include "../postfile/outgoing_post.hpp"
 #include "../constants/constants.hpp"
 
@@ -18,12 +22,27 @@
 #include "sync_helpers.hpp"
 #include "send_helpers.hpp"
 #include "deferred_url_builder.hpp"
+#include "sync_stats.hpp"
+#include "dependency_runner.hpp"
+#include "media_cache.hpp"
 
 template <typename post_request, typename delete_request, typename post_new_status, typename upload_attachments, typename get_posts>
 struct send_posts
 {
 public:
 	unsigned int retries = 3;
+	// how long to wait between retries after timeouts and server errors
+	backoff_policy backoff;
+	// how many queued calls to send at the same time
+	unsigned int jobs = 1;
+	// how many of a post's attachments to upload at the same time
+	unsigned int upload_jobs = 1;
+	// take out calls that cancel each other out or repeat before sending anything
+	bool coalesce_calls = false;
+	// try calls that failed recently without waiting, and put the ones that were given up on back in the queue first
+	bool retry_failed = false;
+	// if set, time spent sending gets broken down and added to this
+	stats_report* stats = nullptr;
 
 	send_posts(post_request& post, delete_request& del, post_new_status& new_status, upload_attachments& upload, get_posts& get_method) : post(post), del(del), new_status(new_status), upload(upload), get_method(get_method) { }
 
@@ -31,6 +50,7 @@ public:
 	{
 		retries = set_default(retries, 3, "Number of retries cannot be zero or less. Resetting to 3.\n", pl());
 
+		const stats_section section{ stats, to_utf8(user_account_dir.filename()), "send" };
 		process_queue(user_account_dir, instance_url, access_token);
 	}
 
@@ -42,7 +62,7 @@ private:
 	upload_attachments& upload;
 	get_posts& get_method;
 
-	bool make_api_call(const api_call& to_make, deferred_url_builder& urls, const fs::path& user_account_dir, std::string_view access_token)
+	call_result make_api_call(const api_call& to_make, deferred_url_builder& urls, media_cache& uploaded, const fs::path& user_account_dir, std::string_view access_token)
 	{
 		switch (to_make.queued_call)
 		{
@@ -52,77 +72,243 @@ private:
 		case api_route::unboost:
 		case api_route::bookmark:
 		case api_route::unbookmark:
-			return simple_call(post, "POST", retries, paramaterize_url(urls.status_url(), to_make.argument, ROUTE_LOOKUP[static_cast<uint8_t>(to_make.queued_call)]), access_token).success;
+		{
+			const auto response = simple_call(post, "POST", retries, backoff, paramaterize_url(urls.status_url(), to_make.argument, ROUTE_LOOKUP[static_cast<uint8_t>(to_make.queued_call)]), access_token);
+			return call_result{ response.success, response.status_code };
+		}
 		case api_route::post:
 			// posts are a little trickier
-			return send_post(user_account_dir, access_token, urls.status_url(), urls.media_url(), to_make.argument);
+			return send_post(user_account_dir, access_token, urls.status_url(), urls.media_url(), uploaded, to_make.argument);
 		case api_route::unpost:
-			return simple_call(del, "DELETE", retries, paramaterize_url(urls.status_url(), to_make.argument, ROUTE_LOOKUP[static_cast<uint8_t>(to_make.queued_call)]), access_token).success;
+		{
+			const auto response = simple_call(del, "DELETE", retries, backoff, paramaterize_url(urls.status_url(), to_make.argument, ROUTE_LOOKUP[static_cast<uint8_t>(to_make.queued_call)]), access_token);
+			return call_result{ response.success, response.status_code };
+		}
 		case api_route::context:
-			return get_and_write(get_method, user_account_dir, retries, urls.status_url(), to_make.argument, access_token);
+			return get_and_write(get_method, user_account_dir, retries, backoff, urls.status_url(), to_make.argument, access_token);
 		default:
-			return false;
+			return call_result{};
 		}
 	}
 
 	void process_queue(const fs::path& user_account_dir, const std::string_view instance_url, const std::string_view access_token)
 	{
-		auto queuelist = get(user_account_dir);
+		// get() would rewrite the queue file if there's a journal, and that's about to happen anyways if it's time
+		queue_list queuelist{ user_account_dir / Queue_Filename };
+		const fs::path journal_file = user_account_dir / Queue_Journal_Filename;
+		replay_journal(queuelist.parsed, journal_file);
 
-		std::deque<api_call> failed;
+		auto& calls = queuelist.parsed;
+
+		size_t revived = 0;
+		if (retry_failed)
+		{
+			const fs::path dead_letter_file = user_account_dir / Dead_Letter_Filename;
+			{
+				queue_list dead_letters{ dead_letter_file };
+				revived = dead_letters.parsed.size();
+				std::move(dead_letters.parsed.begin(), dead_letters.parsed.end(), std::back_inserter(calls));
+				dead_letters.should_save_back = false;
+			}
+			fs::remove(dead_letter_file);
+
+			for (api_call& call : calls)
+				call.retry = retry_state{};
+
+			if (revived > 0)
+				pl() << "Putting " << revived << pluralize(revived, " call", " calls") << " from " << Dead_Letter_Filename << " back in the queue.\n";
+		}
+
+		size_t coalesced = 0;
+		if (coalesce_calls)
+		{
+			coalesced = coalesce(calls);
+			if (coalesced > 0)
+				pl() << "Skipping " << coalesced << pluralize(coalesced, " queued call that isn't", " queued calls that aren't") << " needed anymore.\n";
+		}
 
 		deferred_url_builder urls(instance_url);
+		media_cache uploaded{ user_account_dir / Media_Cache_Filename };
+
+		const auto depends_on = queue_dependencies(calls, user_account_dir / File_Queue_Directory);
 
-		while (!queuelist.parsed.empty())
+		// calls that failed recently wait a while before they're tried again, and so does everything that has to come after them
+		const auto now = seconds_since_epoch();
+		std::vector<bool> waiting(calls.size(), false);
+		size_t waiting_count = 0;
+		for (size_t i = 0; i < calls.size(); i++)
 		{
-			if (!make_api_call(queuelist.parsed.front(), urls, user_account_dir, access_token))
-				failed.push_back(std::move(queuelist.parsed.front()));
-			queuelist.parsed.pop_front();
+			waiting[i] = calls[i].retry.next_attempt > now || std::any_of(depends_on[i].begin(), depends_on[i].end(), [&waiting](size_t dependency) { return waiting[dependency]; });
+			waiting_count += waiting[i];
 		}
 
-		queuelist.parsed = std::move(failed);
+		if (waiting_count > 0)
+			pl() << "Skipping " << waiting_count << pluralize(waiting_count, " call that", " calls that") << " failed recently or can't go before one that did. They'll be tried again in a later sync.\n";
+
+		if (jobs > 1)
+		{
+			// the workers share these, so build them now instead of having them race to do it
+			urls.status_url();
+			urls.media_url();
+		}
+
+		// each worker only touches its own slot
+		std::vector<call_result> results(calls.size());
+		size_t journaled = 0;
+		{
+			// each call is written down as soon as it goes through, so if msync is stopped partway, it won't be sent again
+			queue_journal journal{ journal_file };
+			run_in_dependency_order(depends_on, jobs, [&](size_t i)
+			{
+				if (!waiting[i])
+				{
+					results[i] = make_api_call(calls[i], urls, uploaded, user_account_dir, access_token);
+					if (results[i].success)
+						journal.record(calls[i]);
+				}
+				return results[i].success;
+			});
+			journaled = journal.size();
+		}
+
+		// keep whatever failed in the same order it was queued in, unless it's never going to work
+		std::deque<api_call> failed;
+		std::deque<api_call> given_up;
+		const auto finished = seconds_since_epoch();
+		for (size_t i = 0; i < calls.size(); i++)
+		{
+			if (results[i].success)
+				continue;
+
+			api_call& call = calls[i];
+
+			// no status code means there wasn't a response at all, like when msync is offline or the server's down.
+			// that doesn't say anything about the call, so it can go again next sync without waiting.
+			if (!waiting[i] && results[i].status_code != 0)
+			{
+				call.retry.attempts++;
+				call.retry.last_status_code = results[i].status_code;
+				call.retry.next_attempt = finished + retry_delay(call.retry.attempts).count();
+
+				if (permanent_failure(results[i].status_code))
+				{
+					pl() << print_route(call.queued_call) << ' ' << call.argument << " failed with " << results[i].status_code
+						<< ", which won't change by trying again. Moving it to " << Dead_Letter_Filename << ".\n";
+					given_up.push_back(std::move(call));
+					continue;
+				}
+			}
+
+			failed.push_back(std::move(call));
+		}
+
+		calls = std::move(failed);
+
+		if (!given_up.empty())
+		{
+			queue_list dead_letters{ user_account_dir / Dead_Letter_Filename };
+			std::move(given_up.begin(), given_up.end(), std::back_inserter(dead_letters.parsed));
+		}
+
+		// if all that happened is that some calls went through, the journal already says so, and the queue file only has to be
+		// rewritten once in a while. a failure changes what's written for that call, though, so that means writing it out now.
+		// same if coalescing took anything out. and if everything went through, clearing out the queue file is cheap.
+		const bool retries_changed = calls.size() > waiting_count;
+		if (calls.empty() || retries_changed || coalesced > 0 || revived > 0 || !given_up.empty() || journaled >= Journal_Compaction_Threshold)
+		{
+			compact_journal(queuelist, journal_file);
+		}
+		else
+		{
+			queuelist.should_save_back = false;
+			if (journaled == 0)
+				fs::remove(journal_file);
+		}
 	}
 
-	bool send_attachments(file_status_params& params, const std::string& mediaurl, std::string_view access_token)
+	// reused_media is set if any of the attachments were uploaded on an earlier try and came out of the cache
+	call_result send_attachments(file_status_params& params, const std::string& mediaurl, media_cache& uploaded, std::string_view access_token, bool& reused_media)
 	{
-		bool succeeded;
-		std::string response;
+		// check for all of them first so a missing file doesn't leave some orphaned uploads on the server
 		for (const auto& attachment : params.attachments)
 		{
 			if (!fs::exists(attachment.file))
 			{
 				pl() << "Could not find file: " << attachment.file << " skipping this post.\n";
-				return false;
+				return call_result{};
 			}
+		}
 
-			pl() << "Uploading " << attachment.file << ' ';
+		std::vector<std::string> keys;
+		keys.reserve(params.attachments.size());
+		std::transform(params.attachments.begin(), params.attachments.end(), std::back_inserter(keys), [](const attachment& attached) { return media_cache::key_for(attached.file, attached.description); });
 
-			auto request_response = request_with_retries([&]() { return upload(mediaurl, access_token, attachment.file, attachment.description); }, retries, pl());
-			response = std::move(request_response.message);
-			succeeded = request_response.success;
+		std::vector<std::string> ids(params.attachments.size());
+		std::atomic<bool> any_failed = false;
+		std::atomic<int> failed_status_code = 0;
+		std::atomic<bool> any_cached = false;
 
-			print_statistics(pl(), request_response.time_ms, request_response.tries);
-			if (succeeded)
+		// the uploads don't depend on each other, so they can all go at once
+		const std::vector<std::vector<size_t>> no_dependencies(params.attachments.size());
+		const auto succeeded = run_in_dependency_order(no_dependencies, upload_jobs, [&](size_t i)
+		{
+			// once one's failed, the post won't be sent, so don't bother with the rest
+			if (any_failed)
+				return false;
+
+			const auto& attachment = params.attachments[i];
+
+			// if this was uploaded for a post that didn't go through last time, use that instead.
+			// the same file can be attached twice, but each one needs its own upload, so only the first gets to use the cache.
+			const bool first_with_key = std::find(keys.begin(), keys.begin() + i, keys[i]) == keys.begin() + i;
+			if (first_with_key)
 			{
-				params.attachment_ids.push_back(read_upload_id(response));
+				ids[i] = uploaded.find(keys[i]);
+				if (!ids[i].empty())
+				{
+					pl() << "Already uploaded " << attachment.file << '\n';
+					any_cached = true;
+					return true;
+				}
 			}
-			else
+
+			pl() << "Uploading " << attachment.file << ' ';
+
+			auto request_response = request_with_retries([&]() { return upload(mediaurl, access_token, attachment.file, attachment.description); }, retries, pl(), backoff);
+
+			print_statistics(pl(), request_response.time_ms, request_response.tries, request_response.backoff_ms);
+			if (request_response.success)
 			{
-				pl() << "Could not upload file. Skipping this post.";
-				return false;
+				ids[i] = read_upload_id(request_response.message);
+				if (first_with_key)
+					uploaded.remember(keys[i], ids[i]);
+				return true;
 			}
-		}
 
-		return true;
+			pl() << "Could not upload file. Skipping this post.";
+			failed_status_code = request_response.status_code;
+			any_failed = true;
+			return false;
+		});
+
+		reused_media = any_cached;
+		if (std::find(succeeded.begin(), succeeded.end(), false) != succeeded.end())
+			return call_result{ false, failed_status_code };
+
+		// the ids go in the same order as the attachments, no matter which upload finished first
+		std::move(ids.begin(), ids.end(), std::back_inserter(params.attachment_ids));
+		return call_result{ true };
 	}
 
-	bool send_post(const fs::path& user_account_dir, const std::string_view access_token, const std::string& statusurl, const std::string& mediaurl, const std::string& post_filename)
+	call_result send_post(const fs::path& user_account_dir, const std::string_view access_token, const std::string& statusurl, const std::string& mediaurl, media_cache& uploaded, const std::string& post_filename)
 	{
 		const fs::path file_to_send = user_account_dir / File_Queue_Directory / post_filename;
 
 		file_status_params params = read_params(file_to_send);
 
 		bool succeeded = true;
+		int status_code = 0;
+		bool reused_media = false;
 		if (!params.okay)
 		{
 			pl() << post_filename << ": This post is a reply to a post that failed to send. Skipping.\n";
@@ -131,7 +317,9 @@ private:
 
 		if (succeeded)
 		{
-			succeeded = send_attachments(params, mediaurl, access_token);
+			const auto uploads = send_attachments(params, mediaurl, uploaded, access_token, reused_media);
+			succeeded = uploads.success;
+			status_code = uploads.status_code;
 		}
 
 		std::string parsed_status_id;
@@ -143,24 +331,46 @@ private:
 			print_truncated_string(params.body, pl());
 			pl() << '\n';
 
-			auto request_response = request_with_retries([&]() { return new_status(statusurl, access_token, params); }, retries, pl());
+			auto request_response = request_with_retries([&]() { return new_status(statusurl, access_token, params); }, retries, pl(), backoff);
+
+			// media from an earlier try might have expired on the server or been attached to something else since then,
+			// and the server turns the post down for that, so upload it all again and give it one more go before giving up on it.
+			if (!request_response.success && reused_media && permanent_failure(request_response.status_code))
+			{
+				uploaded.forget(params.attachment_ids);
+				params.attachment_ids.clear();
+
+				pl() << "The server didn't take the post with media uploaded earlier. Uploading it again.\n";
+				const auto reuploads = send_attachments(params, mediaurl, uploaded, access_token, reused_media);
+				if (reuploads.success)
+					request_response = request_with_retries([&]() { return new_status(statusurl, access_token, params); }, retries, pl(), backoff);
+				else
+					request_response.status_code = reuploads.status_code;
+			}
 
 			std::string response = std::move(request_response.message);
 			succeeded = request_response.success;
+			status_code = request_response.status_code;
 
 			if (succeeded)
 			{
 				fs::remove(file_to_send);
+				uploaded.forget(params.attachment_ids);
 
 				// make a copy with ".bak" at the end to remove the .bak file
 				// it would be fine to mutate file_to_send, but it's const and 
 				// i think being const correct here is probably worth more than avoiding a copy
 				fs::remove(fs::path(file_to_send).concat(".bak"));
-				auto parsed_status = read_status(response);
+				auto parsed_status = read_status(response, post_list_account);
 				pl() << "Created post at " << parsed_status.url;
 				parsed_status_id = std::move(parsed_status.id);
 			}
-			print_statistics(pl(), request_response.time_ms, request_response.tries);
+			else if (status_code >= 400 && status_code < 500)
+			{
+				// whatever was wrong with the post might have been its media, so don't attach the same uploads next time either
+				uploaded.forget(params.attachment_ids);
+			}
+			print_statistics(pl(), request_response.time_ms, request_response.tries, request_response.backoff_ms);
 		}
 
 		if (!params.reply_id.empty())
@@ -188,7 +398,7 @@ private:
 			}
 		}
 
-		return succeeded;
+		return call_result{ succeeded, status_code };
 	}
 };
 
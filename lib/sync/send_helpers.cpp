@@ -3,6 +3,7 @@
 #include <random>
 #include <algorithm>
 #include <unordered_map>
+#include <mutex>
 
 #include "../postfile/outgoing_post.hpp"
 #include "../postlist/post_list.hpp"
@@ -14,6 +15,34 @@ std::string paramaterize_url(const std::string_view before, const std::string_vi
 	return toreturn.append(middle).append(after);
 }
 
+bool permanent_failure(const int status_code)
+{
+	if (status_code < 400 || status_code >= 500)
+		return false;
+
+	switch (status_code)
+	{
+	case 401: // unauthorized
+	case 403: // forbidden
+	case 408: // request timeout
+	case 425: // too early
+	case 429: // too many requests
+		return false;
+	default:
+		return true;
+	}
+}
+
+std::chrono::seconds retry_delay(const unsigned int attempts)
+{
+	constexpr std::chrono::seconds first_delay = std::chrono::minutes(5);
+	constexpr std::chrono::seconds longest_delay = std::chrono::hours(24);
+
+	// five minutes doubled nine times is already more than a day, so stop there before it overflows
+	const unsigned int doublings = std::min(attempts == 0 ? 0 : attempts - 1, 9u);
+	return std::min(first_delay * (1 << doublings), longest_delay);
+}
+
 std::mt19937_64 make_random_engine()
 {
 	// random_device produces an unsigned int (32 bits), but the mersenne twister wants to be seeded with a 64-bit value,
@@ -33,7 +62,8 @@ std::mt19937_64 make_random_engine()
 
 uint_fast64_t random_number()
 {
-	static auto twister = make_random_engine();
+	// one per thread so concurrent syncs don't have to fight over it
+	thread_local auto twister = make_random_engine();
 	return twister();
 }
 
@@ -52,6 +82,7 @@ std::vector<attachment> make_attachments(std::vector<std::string>&& attachments,
 }
 
 static std::unordered_map<std::string, std::string> threaded_ids;
+static std::mutex threaded_ids_lock;
 
 // the idea here is that posts can optionally have some local ID. 
 // if another post's reply_to_id is set to one of those, then fix it up so that 
@@ -64,6 +95,7 @@ void store_thread_id(std::string msync_id, std::string remote_server_id)
 
 	// I considered scoping the threaded_ids to the process_posts functions, but it's probably good to
 	// let people thread across accounts, even though we currently can't really guarantee an order, so hm
+	const std::lock_guard<std::mutex> guard(threaded_ids_lock);
 	threaded_ids.insert_or_assign(std::move(msync_id), std::move(remote_server_id));
 }
 
@@ -81,6 +113,7 @@ file_status_params read_params(const fs::path& path)
 
 	if (!toreturn.reply_to.empty())
 	{
+		const std::lock_guard<std::mutex> guard(threaded_ids_lock);
 		const auto val = threaded_ids.find(toreturn.reply_to);
 		if (val != threaded_ids.end()) 
 		{
@@ -94,6 +127,55 @@ file_status_params read_params(const fs::path& path)
 	return toreturn;
 }
 
+std::vector<std::vector<size_t>> queue_dependencies(const std::deque<api_call>& calls, const fs::path& queue_directory)
+{
+	std::vector<std::vector<size_t>> toreturn(calls.size());
+
+	// the last call seen on each status (or post file), and the last post seen with each local reply ID
+	std::unordered_map<std::string_view, size_t> last_call_on;
+	std::unordered_map<std::string, size_t> last_post_with_id;
+
+	for (size_t i = 0; i < calls.size(); i++)
+	{
+		const auto last_call = last_call_on.find(calls[i].argument);
+		if (last_call != last_call_on.end())
+		{
+			toreturn[i].push_back(last_call->second);
+			last_call->second = i;
+		}
+		else
+		{
+			last_call_on.emplace(calls[i].argument, i);
+		}
+
+		if (calls[i].queued_call != api_route::post)
+			continue;
+
+		readonly_outgoing_post post{ queue_directory / calls[i].argument };
+
+		if (!post.parsed.reply_to_id.empty())
+		{
+			const auto parent = last_post_with_id.find(post.parsed.reply_to_id);
+			if (parent != last_post_with_id.end())
+				toreturn[i].push_back(parent->second);
+		}
+
+		if (!post.parsed.reply_id.empty())
+		{
+			// if two posts use the same local ID, replies go to the later one, same as store_thread_id,
+			// so make sure the later one is the one that's stored last
+			const auto [post_with_id, inserted] = last_post_with_id.try_emplace(std::move(post.parsed.reply_id), i);
+			if (!inserted)
+			{
+				toreturn[i].push_back(post_with_id->second);
+				post_with_id->second = i;
+			}
+		}
+	}
+
+	return toreturn;
+}
+
 void write_posts(const mastodon_context& context, const mastodon_status& status, const fs::path& path)
 {
 	plverb() << "Writing context to " << path << ".\n";
@@ -114,8 +196,7 @@ void write_posts(const mastodon_context& context, const mastodon_status& status,
 	}
 	post_list<mastodon_status> writer { path };
 
-	auto write = [&writer](const auto& post) { writer.write(post); };
-	std::for_each(context.ancestors.begin(), context.ancestors.end(), write);
+	writer.write(context.ancestors.begin(), context.ancestors.end());
 	writer.write(status);
-	std::for_each(context.descendants.begin(), context.descendants.end(), write);
+	writer.write(context.descendants.begin(), context.descendants.end());
 }
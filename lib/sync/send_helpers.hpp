@@ -6,12 +6,16 @@
 #include <filesystem.hpp>
 
 #include "../util/util.hpp"
+#include "../postlist/post_list.hpp"
 
 #include "../constants/constants.hpp"
 
 #include <array>
+#include <chrono>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
+#include <deque>
 #include <utility>
 #include <string>
 
@@ -34,14 +38,28 @@ constexpr std::array<std::string_view, static_cast<uint8_t>(api_route::unknown)>
 };
 
 
+// how a queued call went. status_code is from the request that failed, or 0 if it failed before making one.
+struct call_result
+{
+	bool success = false;
+	int status_code = 0;
+};
+
+// client errors that trying again won't fix, like a 404 for a post that's been deleted or a 422 for a post the server won't take.
+// 401 and 403 are left out because they usually mean something's wrong with the account, not the call, and 408 and 429 are about timing.
+bool permanent_failure(int status_code);
+
+// how long to wait before trying a call that's failed this many times again: five minutes, doubling each time, up to a day
+std::chrono::seconds retry_delay(unsigned int attempts);
+
 template <typename make_request>
-request_response simple_call(make_request& method, const char* method_name, unsigned int retries, const std::string& url, std::string_view access_token)
+request_response simple_call(make_request& method, const char* method_name, unsigned int retries, const backoff_policy& backoff, const std::string& url, std::string_view access_token)
 {
 	pl() << method_name << ' ' << url;
-	const auto response = request_with_retries([&]() { return method(url, access_token); }, retries, pl());
+	const auto response = request_with_retries([&]() { return method(url, access_token); }, retries, pl(), backoff);
 	if (response.success)
 		pl() << " OK";
-	print_statistics(pl(), response.time_ms, response.tries);
+	print_statistics(pl(), response.time_ms, response.tries, response.backoff_ms);
 	return response;
 }
 
@@ -64,16 +82,21 @@ struct file_status_params : public status_params
 
 file_status_params read_params(const fs::path& path);
 
+// for each call in the queue, the earlier calls that have to finish before it can start when sending several at once.
+// calls on the same status stay in the order they were queued (like a fav then an unfav), and a reply waits for
+// the post it's replying to so it knows what that post's real ID is. everything else can go in any order.
+std::vector<std::vector<size_t>> queue_dependencies(const std::deque<api_call>& calls, const fs::path& queue_directory);
+
 void write_posts(const mastodon_context& context, const mastodon_status& status, const fs::path& path);
 
 template <typename make_request>
-bool get_and_write(make_request& method, const fs::path& user_account_dir, unsigned int retries, const std::string& status_url, const std::string& post_id, std::string_view access_token)
+call_result get_and_write(make_request& method, const fs::path& user_account_dir, unsigned int retries, const backoff_policy& backoff, const std::string& status_url, const std::string& post_id, std::string_view access_token)
 {
 	auto adapted_get = [&method](const auto& request_url, const auto& access_token) { return method(request_url, access_token, timeline_params{}, 0); };
 	// GET https://instance.url/api/v1/statuses/post_id
 	auto request_url = status_url + post_id;
-	const auto status_response = simple_call(adapted_get, "GET", retries, request_url, access_token);
-	if (!status_response.success) { return false; }
+	const auto status_response = simple_call(adapted_get, "GET", retries, backoff, request_url, access_token);
+	if (!status_response.success) { return call_result{ false, status_response.status_code }; }
 
 	// this might have to become more general, like what's done in recv.hpp, but it's fine for now.
 	// basically, we get the message they want context for, then we get the context around it
@@ -81,17 +104,17 @@ bool get_and_write(make_request& method, const fs::path& user_account_dir, unsig
 
 	// GET https://instance.url/api/v1/statuses/post_id/context
 	request_url += "/context";
-	const auto context_response = simple_call(adapted_get, "GET", retries, request_url, access_token);
-	if (!context_response.success) { return false; }
+	const auto context_response = simple_call(adapted_get, "GET", retries, backoff, request_url, access_token);
+	if (!context_response.success) { return call_result{ false, context_response.status_code }; }
 
 	// build up the target file location to minimize the number of intermediate strings that get thrown away
 	auto post_file = user_account_dir / Thread_Directory;
 	post_file /= post_id;
 	post_file += ".list";
 
-	write_posts(read_context(context_response.message), read_status(status_response.message), post_file);
+	write_posts(read_context(context_response.message, post_list_account), read_status(status_response.message, post_list_account), post_file);
 
-	return true;
+	return call_result{ true, context_response.status_code };
 }
 
 #endif
@@ -13,6 +13,9 @@
 #include "../util/util.hpp"
 
 #include "read_response.hpp"
+#include "sync_stats.hpp"
+#include "rate_limit_pacer.hpp"
+#include "backoff.hpp"
 
 template <typename message_type, typename stream_output>
 unsigned int set_default(unsigned int value, unsigned int default_value, const message_type& message, stream_output& out)
@@ -57,10 +60,11 @@ void print_truncated_string(std::string_view toprint, Stream& str)
 }
 
 template <typename Stream>
-void print_statistics(Stream& os, long long time_ms, unsigned int tries)
+void print_statistics(Stream& os, long long time_ms, unsigned int tries, long long backoff_ms = 0)
 {
 	os << " (" << time_ms << " ms";
 	if (tries != 1) { os << ", " << tries << " attempts"; }
+	if (backoff_ms > 0) { os << ", " << backoff_ms << " ms backing off"; }
 	os << ")\n";
 }
 
@@ -70,28 +74,78 @@ struct request_response
 	std::string message;
 	unsigned int tries;
 	long long time_ms;
+	// from the last response, or 0 if there wasn't one
+	int status_code = 0;
+	// how much of time_ms was spent waiting between tries after timeouts and server errors
+	long long backoff_ms = 0;
 };
 
 
 template <typename make_request, typename Stream>
-request_response request_with_retries(make_request req, unsigned int retries, Stream& os)
+request_response request_with_retries(make_request req, unsigned int retries, Stream& os, const backoff_policy& backoff = {})
 {
 	// Basically, before this is called, a URL is printed, and console IO buffers until it sees a newline.
 	// I want people to see the URL for the request that's happening, while it's happening.
 	os.flush();
+	const timed_phase waiting{ sync_phase::network };
+	sync_stats* const stats = current_stats;
+	rate_limit_pacer* const pacer = current_pacer;
 	const auto start_time = std::chrono::steady_clock::now();
 	bool rate_limit_waited = false;
+	int last_status_code = 0;
+	// rate limit waits don't count against the deadline, they aren't the server struggling
+	std::chrono::steady_clock::duration rate_limit_time{};
+	std::chrono::milliseconds backed_off{};
+	const auto elapsed_ms = [&start_time](std::chrono::steady_clock::time_point end_time)
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+	};
 	for (unsigned int i = 0; i < retries; i++)
 	{
+		if (pacer != nullptr)
+		{
+			const auto wait = pacer->reserve();
+			if (wait >= std::chrono::seconds{ 5 })
+			{
+				const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(wait).count();
+				os << " Almost out of requests for now, waiting " << seconds << pluralize(seconds, " second", " seconds") << " so the rate limit isn't hit.";
+				os.flush();
+			}
+			if (wait.count() > 0)
+			{
+				std::this_thread::sleep_for(wait);
+				rate_limit_time += wait;
+			}
+		}
+
 		net_response response = req();
 
+		if (pacer != nullptr)
+			pacer->update(response);
+
+		if (stats != nullptr)
+		{
+			stats->requests++;
+			if (i > 0) { stats->retries++; }
+			if (response.status_code == 429) { stats->rate_limited++; }
+			stats->bytes_downloaded += response.message.size();
+		}
+
 		const auto end_time = std::chrono::steady_clock::now();
+		last_status_code = response.status_code;
 
 		if (response.retryable_error)
 		{
 			if (response.status_code == 429)
 			{
 				const auto resets_at = parse_ISO8601_timestamp(response.message);
+				const auto wait_start = std::chrono::steady_clock::now();
+
+				if (defer_rate_limits)
+				{
+					os << "\n429: Rate limited.";
+					throw rate_limit_deferred(resets_at);
+				}
 
 				os << '\n';
 				do
@@ -119,6 +173,24 @@ request_response request_with_retries(make_request req, unsigned int retries, St
 				} while (std::chrono::system_clock::now() < resets_at);
 				os << "                                 \rFinished waiting for rate limit to reset. Retrying.";
 				rate_limit_waited = true;
+				rate_limit_time += std::chrono::steady_clock::now() - wait_start;
+			}
+			else if (i + 1 < retries)
+			{
+				// a timeout or a server error. give it a moment to recover instead of piling on.
+				const auto delay = backoff_delay(backoff, i + 1);
+				if (backoff.deadline.count() > 0 && end_time - start_time - rate_limit_time + delay > backoff.deadline)
+				{
+					const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(backoff.deadline).count();
+					os << " Error: Still failing after " << seconds << pluralize(seconds, " second", " seconds") << " of retrying, giving up.";
+					return request_response{ false, "Retry deadline reached.", i + 1, elapsed_ms(std::chrono::steady_clock::now()), response.status_code, backed_off.count() };
+				}
+
+				if (delay.count() > 0)
+				{
+					std::this_thread::sleep_for(delay);
+					backed_off += delay;
+				}
 			}
 			// should retry
 			continue;
@@ -136,12 +208,10 @@ request_response request_with_retries(make_request req, unsigned int retries, St
 		}
 
 		// must be 200, OK response
-		return request_response{ response.okay, std::move(response.message), i + 1, std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() };
+		return request_response{ response.okay, std::move(response.message), i + 1, elapsed_ms(end_time), response.status_code, backed_off.count() };
 	}
 
-	const auto end_time = std::chrono::steady_clock::now();
-
 	os << " Error: Maximum retries reached.";
-	return request_response{ false,  "Maximum retries reached.", retries, std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() };
+	return request_response{ false,  "Maximum retries reached.", retries, elapsed_ms(std::chrono::steady_clock::now()), last_status_code, backed_off.count() };
 }
 #endif
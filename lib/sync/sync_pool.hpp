@@ -0,0 +1,200 @@
+#ifndef SYNC_POOL_HPP
+#define SYNC_POOL_HPP
+
+#include <print_logger.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+
+#include "rate_limit_pacer.hpp"
+#include "../util/util.hpp"
+
+struct pool_limits
+{
+	// how many accounts to sync at once
+	unsigned int jobs = 1;
+	// how many of those can be talking to the same instance at once
+	unsigned int per_instance = 2;
+};
+
+// calls sync_one on every account, up to limits.jobs at a time, but never more than limits.per_instance at once
+// for accounts that instance_of says are on the same server. accounts are started in the order they come in.
+// each account's log output is held until it finishes so it comes out in one piece instead of interleaved.
+// if an account gets rate limited, it's set aside and synced again from the top once the limit resets, and the other accounts
+// keep going in the meantime. that means sync_one has to be fine with being called again for the same account.
+// if any of them throw, the rest still get synced, then the first exception (in account order) is rethrown.
+template <typename Account, typename InstanceOf, typename SyncOne>
+void sync_accounts(const std::vector<Account>& accounts, pool_limits limits, InstanceOf instance_of, SyncOne sync_one)
+{
+	// with only one account, there's nothing else to do while it waits, so it might as well wait where it is
+	if (accounts.size() <= 1)
+	{
+		std::for_each(accounts.begin(), accounts.end(), sync_one);
+		return;
+	}
+
+	using clock = rate_limit_pacer::clock;
+
+	// nothing to gain from spinning up threads, and this keeps the live output working
+	if (limits.jobs <= 1)
+	{
+		std::vector<bool> finished(accounts.size(), false);
+		std::vector<clock::time_point> resume_at(accounts.size());
+		size_t left = accounts.size();
+		while (left > 0)
+		{
+			// the first one that isn't waiting on a rate limit, or if they all are, whichever's up first
+			const auto now = clock::now();
+			size_t next = accounts.size();
+			for (size_t i = 0; i < accounts.size(); i++)
+			{
+				if (finished[i])
+					continue;
+				if (next == accounts.size() || resume_at[i] < resume_at[next])
+					next = i;
+				if (resume_at[i] <= now)
+				{
+					next = i;
+					break;
+				}
+			}
+
+			if (resume_at[next] > now)
+			{
+				const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(resume_at[next] - now).count() + 1;
+				pl() << "Waiting " << seconds << pluralize(seconds, " second", " seconds") << " for the rate limit to reset.\n";
+				std::this_thread::sleep_until(resume_at[next]);
+			}
+
+			try
+			{
+				const deferral_scope deferring{ left > 1 };
+				sync_one(accounts[next]);
+				finished[next] = true;
+				left--;
+			}
+			catch (const rate_limit_deferred& deferred)
+			{
+				pl() << " Moving on and coming back to this account once the limit resets.\n";
+				resume_at[next] = deferred.resets_at;
+			}
+		}
+		return;
+	}
+
+	limits.per_instance = std::max(limits.per_instance, 1u);
+
+	std::vector<std::string> instances;
+	instances.reserve(accounts.size());
+	std::transform(accounts.begin(), accounts.end(), std::back_inserter(instances), instance_of);
+
+	std::mutex lock;
+	std::condition_variable slot_opened;
+	std::vector<bool> started(accounts.size(), false);
+	std::vector<clock::time_point> resume_at(accounts.size());
+	size_t not_started = accounts.size();
+	size_t not_finished = accounts.size();
+	std::unordered_map<std::string, unsigned int> running_on;
+	std::vector<std::exception_ptr> errors(accounts.size());
+
+	const auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		while (true)
+		{
+			if (not_started == 0)
+				return;
+
+			const auto now = clock::now();
+			size_t next = accounts.size();
+			auto earliest = clock::time_point::max();
+			for (size_t i = 0; i < accounts.size(); i++)
+			{
+				if (started[i] || running_on[instances[i]] >= limits.per_instance)
+					continue;
+				if (resume_at[i] <= now)
+				{
+					next = i;
+					break;
+				}
+				earliest = std::min(earliest, resume_at[i]);
+			}
+
+			if (next == accounts.size())
+			{
+				// everything left is running, waiting for a slot on its instance, or waiting on a rate limit
+				if (earliest == clock::time_point::max())
+					slot_opened.wait(guard);
+				else
+					slot_opened.wait_until(guard, earliest);
+				continue;
+			}
+
+			started[next] = true;
+			not_started--;
+			running_on[instances[next]]++;
+			// only worth setting it aside if there's something else to do in the meantime
+			const bool others_left = not_finished > 1;
+
+			guard.unlock();
+			bool deferred = false;
+			clock::time_point resets_at;
+			try
+			{
+				capture_logs capture;
+				const deferral_scope deferring{ others_left };
+				try
+				{
+					sync_one(accounts[next]);
+				}
+				catch (const rate_limit_deferred& limited)
+				{
+					pl() << " Moving on to other accounts and coming back to this one once the limit resets.\n";
+					deferred = true;
+					resets_at = limited.resets_at;
+				}
+			}
+			catch (...)
+			{
+				// each worker only ever touches its own slot
+				errors[next] = std::current_exception();
+			}
+			guard.lock();
+
+			running_on[instances[next]]--;
+			if (deferred)
+			{
+				started[next] = false;
+				not_started++;
+				resume_at[next] = resets_at;
+			}
+			else
+			{
+				not_finished--;
+			}
+			slot_opened.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	const auto worker_count = std::min<size_t>(limits.jobs, accounts.size());
+	workers.reserve(worker_count);
+	for (size_t i = 0; i < worker_count; i++)
+		workers.emplace_back(worker);
+
+	std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+
+	const auto first_error = std::find_if(errors.begin(), errors.end(), [](const std::exception_ptr& ex) { return ex != nullptr; });
+	if (first_error != errors.end())
+		std::rethrow_exception(*first_error);
+}
+
+#endif
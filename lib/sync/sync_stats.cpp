@@ -0,0 +1,151 @@
+#include "sync_stats.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+thread_local sync_stats* current_stats = nullptr;
+thread_local timed_phase* timed_phase::active = nullptr;
+
+constexpr std::array<const char*, sync_phase_count> phase_names = { "network", "parse", "html_cleanup", "mentions", "file_write", "config_save" };
+constexpr std::array<const char*, sync_phase_count> phase_headers = { "network", "parse", "html", "mentions", "write", "config" };
+
+sync_stats& sync_stats::operator+=(const sync_stats& other)
+{
+	for (size_t i = 0; i < phase_time.size(); i++)
+		phase_time[i] += other.phase_time[i];
+	wall_time += other.wall_time;
+	bytes_downloaded += other.bytes_downloaded;
+	posts += other.posts;
+	requests += other.requests;
+	retries += other.retries;
+	rate_limited += other.rate_limited;
+	return *this;
+}
+
+stats_section::stats_section(stats_report* report, std::string_view account, std::string_view section) : report(report), previous(current_stats)
+{
+	if (report == nullptr) { return; }
+
+	this->account = account;
+	this->section = section;
+	current_stats = &stats;
+	start = std::chrono::steady_clock::now();
+}
+
+stats_section::~stats_section()
+{
+	if (report == nullptr) { return; }
+
+	current_stats = previous;
+	stats.wall_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	report->add(std::move(account), std::move(section), stats);
+}
+
+void stats_report::add(std::string account, std::string section, const sync_stats& stats)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+	entries.push_back(stats_entry{ std::move(account), std::move(section), stats });
+}
+
+double milliseconds(std::chrono::nanoseconds time)
+{
+	return std::chrono::duration<double, std::milli>(time).count();
+}
+
+double posts_per_second(const sync_stats& stats)
+{
+	const double seconds = std::chrono::duration<double>(stats.wall_time).count();
+	return seconds > 0 ? stats.posts / seconds : 0;
+}
+
+void print_row(std::ostream& out, std::string_view account, std::string_view section, const sync_stats& stats)
+{
+	out << std::left << std::setw(30) << account << std::setw(14) << section << std::right
+		<< std::setw(10) << milliseconds(stats.wall_time);
+	for (const auto time : stats.phase_time)
+		out << std::setw(10) << milliseconds(time);
+	out << std::setw(10) << stats.bytes_downloaded / 1024.0
+		<< std::setw(8) << stats.posts
+		<< std::setw(9) << posts_per_second(stats)
+		<< std::setw(9) << stats.requests
+		<< std::setw(8) << stats.retries
+		<< std::setw(6) << stats.rate_limited << '\n';
+}
+
+void print_table(std::ostream& out, const std::vector<stats_entry>& entries)
+{
+	out << "\nTimes are in milliseconds. With --prefetch or --send-jobs, network time overlaps with everything else.\n";
+	out << std::left << std::setw(30) << "account" << std::setw(14) << "section" << std::right << std::setw(10) << "total";
+	for (const auto header : phase_headers)
+		out << std::setw(10) << header;
+	out << std::setw(10) << "KB down" << std::setw(8) << "posts" << std::setw(9) << "posts/s"
+		<< std::setw(9) << "requests" << std::setw(8) << "retries" << std::setw(6) << "429s" << '\n';
+
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << std::fixed << std::setprecision(1);
+
+	sync_stats total;
+	for (const auto& entry : entries)
+	{
+		print_row(out, entry.account, entry.section, entry.stats);
+		total += entry.stats;
+	}
+
+	if (entries.size() > 1)
+		print_row(out, "total", "", total);
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void print_json(std::ostream& out, const std::vector<stats_entry>& entries)
+{
+	auto sections = nlohmann::json::array();
+	for (const auto& entry : entries)
+	{
+		const sync_stats& stats = entry.stats;
+
+		nlohmann::json phases;
+		for (size_t phase = 0; phase < sync_phase_count; phase++)
+			phases[phase_names[phase]] = milliseconds(stats.phase_time[phase]);
+
+		sections.push_back({
+			{ "account", entry.account },
+			{ "section", entry.section },
+			{ "total_ms", milliseconds(stats.wall_time) },
+			{ "phase_ms", std::move(phases) },
+			{ "bytes_downloaded", stats.bytes_downloaded },
+			{ "posts", stats.posts },
+			{ "posts_per_second", posts_per_second(stats) },
+			{ "requests", stats.requests },
+			{ "retries", stats.retries },
+			{ "rate_limited", stats.rate_limited },
+		});
+	}
+
+	out << nlohmann::json{ { "sections", std::move(sections) } }.dump() << '\n';
+}
+
+void stats_report::print(std::ostream& out, stats_format format)
+{
+	const std::lock_guard<std::mutex> guard(lock);
+
+	// accounts synced in parallel finish in whatever order, so put each account's sections back together
+	std::stable_sort(entries.begin(), entries.end(), [](const stats_entry& lhs, const stats_entry& rhs) { return lhs.account < rhs.account; });
+
+	switch (format)
+	{
+	case stats_format::table:
+		print_table(out, entries);
+		break;
+	case stats_format::json:
+		print_json(out, entries);
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,126 @@
+#ifndef SYNC_STATS_HPP
+#define SYNC_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// for msync sync --stats, which breaks down where the time in a sync went so you can tell whether a slow sync is the server or msync.
+// none of this costs more than a null check per phase unless something's collecting.
+
+enum class stats_format : uint8_t { off, table, json };
+
+enum class sync_phase : uint8_t
+{
+	network, // waiting on the server, including retries and rate limit waits
+	parse,
+	html_cleanup,
+	mentions,
+	file_write,
+	config_save,
+};
+
+constexpr size_t sync_phase_count = static_cast<size_t>(sync_phase::config_save) + 1;
+
+struct sync_stats
+{
+	std::array<std::chrono::nanoseconds, sync_phase_count> phase_time{};
+	std::chrono::nanoseconds wall_time{};
+	uint64_t bytes_downloaded = 0;
+	uint64_t posts = 0;
+	unsigned int requests = 0;
+	unsigned int retries = 0;
+	unsigned int rate_limited = 0;
+
+	sync_stats& operator+=(const sync_stats& other);
+};
+
+// whatever is collecting stats for the work happening on this thread, or nullptr if nothing is
+extern thread_local sync_stats* current_stats;
+
+// adds the time between construction and destruction to the current thread's stats for that phase.
+// phases nest, and time spent in an inner phase (like cleaning up HTML while parsing) only counts for the inner one.
+class timed_phase
+{
+public:
+	timed_phase(sync_phase phase) : stats(current_stats), phase(phase)
+	{
+		if (stats == nullptr) { return; }
+
+		parent = active;
+		active = this;
+		start = clock::now();
+	}
+
+	~timed_phase()
+	{
+		if (stats == nullptr) { return; }
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+		stats->phase_time[static_cast<size_t>(phase)] += elapsed - nested;
+		if (parent != nullptr)
+			parent->nested += elapsed;
+		active = parent;
+	}
+
+	timed_phase(const timed_phase&) = delete;
+	timed_phase& operator=(const timed_phase&) = delete;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	static thread_local timed_phase* active;
+
+	sync_stats* const stats;
+	const sync_phase phase;
+	timed_phase* parent = nullptr;
+	clock::time_point start;
+	std::chrono::nanoseconds nested{};
+};
+
+struct stats_entry
+{
+	std::string account;
+	std::string section;
+	sync_stats stats;
+};
+
+// everything collected during a sync, one entry per account and section (a timeline, sending the queue, saving the config).
+// sections can be added from several threads at once when syncing accounts in parallel.
+class stats_report
+{
+public:
+	void add(std::string account, std::string section, const sync_stats& stats);
+	void print(std::ostream& out, stats_format format);
+
+private:
+	std::mutex lock;
+	std::vector<stats_entry> entries;
+};
+
+// while one of these is alive, this thread's stats go into it, and then they're added to the report when it's destroyed.
+// if report is nullptr, it doesn't do anything and neither does anything timed inside it.
+class stats_section
+{
+public:
+	stats_section(stats_report* report, std::string_view account, std::string_view section);
+	~stats_section();
+
+	stats_section(const stats_section&) = delete;
+	stats_section& operator=(const stats_section&) = delete;
+
+private:
+	stats_report* const report;
+	sync_stats* const previous;
+	std::string account;
+	std::string section;
+	sync_stats stats;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -48,45 +48,159 @@ std::chrono::system_clock::time_point parse_ISO8601_timestamp(const std::string&
 	return std::chrono::system_clock::from_time_t(time) + std::chrono::seconds(1);
 }
 
+int64_t seconds_since_epoch()
+{
+	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 // if src is null, modifies dest in place
 extern "C" size_t decode_html_entities_utf8(char* dest, const char* src);
 
+// what std::regex's \s matches in the C locale
+constexpr bool is_html_space(const char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// these return the index just past what they match if it starts at idx, or idx if it doesn't
+
+// <br>, <br/>, <br />, <br     />, and so on
+size_t match_line_break(const std::string_view html, const size_t idx)
+{
+	if (html.substr(idx, 3) != "<br")
+		return idx;
+
+	size_t end = idx + 3;
+	while (end < html.size() && html[end] == ' ')
+		end++;
+	if (end < html.size() && html[end] == '/')
+		end++;
+	return (end < html.size() && html[end] == '>') ? end + 1 : idx;
+}
+
+// </p>, then any amount of whitespace or line breaks, then <p>
+size_t match_paragraph_break(const std::string_view html, const size_t idx)
+{
+	if (html.substr(idx, 4) != "</p>")
+		return idx;
+
+	size_t end = idx + 4;
+	while (end < html.size())
+	{
+		if (is_html_space(html[end]))
+		{
+			end++;
+			continue;
+		}
+
+		const size_t after_break = match_line_break(html, end);
+		if (after_break == end)
+			break;
+		end = after_break;
+	}
+
+	return html.substr(end, 3) == "<p>" ? end + 3 : idx;
+}
+
+// a < and the first > after it, as long as there's no other < in between.
+// line and paragraph breaks in between don't count, since they get turned into newlines instead of stripped.
+size_t match_tag(const std::string_view html, const size_t idx)
+{
+	size_t end = idx + 1;
+	while (end < html.size())
+	{
+		const char c = html[end];
+		if (c == '>')
+			return end + 1;
+
+		if (c == '<')
+		{
+			size_t after_break = match_line_break(html, end);
+			if (after_break == end)
+				after_break = match_paragraph_break(html, end);
+			if (after_break == end)
+				return idx;
+			end = after_break;
+			continue;
+		}
+
+		end++;
+	}
+
+	return idx;
+}
+
 std::string clean_up_html(const std::string_view to_strip)
 {
 	if (to_strip.empty()) { return {}; }
 
-	const static std::regex remove_tags{ "<[^<]*?>", std::regex::optimize | std::regex::ECMAScript };
-	const static std::regex replace_line_breaks{ "<br *?/?>", std::regex::optimize | std::regex::ECMAScript };
-	const static std::regex replace_paragraph_breaks{ "</p>\\s*?<p>", std::regex::optimize | std::regex::ECMAScript };
+	// this used to be three regex passes and decode_html_entities. it's all one pass now, but the output should be exactly the same:
+	// line breaks become a newline, paragraph breaks become two, other tags get removed, then entities get decoded.
 
-	// regex_replace will always keep the string the same length or make it shorter, so it won't cause an overflow
-	// the author of decode_html_entities says the same thing
-	// I think the +1 here is necessary because .size() doesn't account for the null terminator that decode_html_entities will want.
-	// either way, one extra byte won't hurt
+	std::string output;
+	output.reserve(to_strip.size());
 
-	// this is kind of a rat's nest both to avoid allocations (each regex replace requires a buffer, which can be reused, but decode_html_entities is in-place)
-	// and because we have to jump through some hoops in order to read from a string_view, because std::regex doesn't know about string views
-	// (we take a string_view to avoid an allocation on the way in, at least)
+	// entities can only be decoded once the semicolon that ends them shows up, and tags can be stripped out from the middle of them.
+	// so, everything in output before pending_entity is done, and everything after it is text that starts with an & and hasn't been decoded yet.
+	size_t pending_entity = std::string::npos;
+	const auto write = [&output, &pending_entity](const char c)
+	{
+		if (c == '&' && pending_entity == std::string::npos)
+			pending_entity = output.size();
 
-	std::string output_buffer(to_strip.size() + 1, '\0');
+		output.push_back(c);
 
-	auto end_of_output = std::regex_replace(&output_buffer[0], to_strip.begin(), to_strip.end(), replace_line_breaks, "\n");
+		if (c == ';' && pending_entity != std::string::npos)
+		{
+			// std::string is always null terminated, which is what decode_html_entities wants
+			const size_t decoded_length = decode_html_entities_utf8(&output[pending_entity], nullptr);
+			output.resize(pending_entity + decoded_length);
+			pending_entity = std::string::npos;
+		}
+	};
 
-	// one more than the number of characters written to output_buffer.
-	// The + 1 shouldn't be necessary, since the output of this replace should always be the same length or shorter
-	// but it's better than overflowing a buffer on accident with some oddball case I didn't expect.
-	std::string par_break_temp_buffer(end_of_output - &output_buffer[0] + 1, '\0');
+	size_t idx = 0;
+	while (idx < to_strip.size())
+	{
+		const char c = to_strip[idx];
 
-	end_of_output = std::regex_replace(&par_break_temp_buffer[0], &output_buffer[0], end_of_output, replace_paragraph_breaks, "\n\n");
-	par_break_temp_buffer.resize(end_of_output - &par_break_temp_buffer[0]);
+		if (c == '<')
+		{
+			size_t after = match_line_break(to_strip, idx);
+			if (after != idx)
+			{
+				write('\n');
+				idx = after;
+				continue;
+			}
+
+			after = match_paragraph_break(to_strip, idx);
+			if (after != idx)
+			{
+				write('\n');
+				write('\n');
+				idx = after;
+				continue;
+			}
+
+			after = match_tag(to_strip, idx);
+			if (after != idx)
+			{
+				idx = after;
+				continue;
+			}
+		}
 
-	const auto end_of_tag_output = std::regex_replace(&output_buffer[0], par_break_temp_buffer.begin(), par_break_temp_buffer.end(), remove_tags, "");
-	*end_of_tag_output = '\0';
+		// decode_html_entities works on C strings, so the old version always stopped at the first null
+		if (c == '\0')
+			break;
 
-	const size_t decoded_length = decode_html_entities_utf8(&output_buffer[0], nullptr);
+		write(c);
+		idx++;
+	}
 
-	output_buffer.resize(decoded_length);
-	return output_buffer;
+	// anything still pending never got its semicolon, so it's left as-is
+	return output;
 }
 
 std::string& bulk_replace_mentions(std::string& str, const std::vector<std::pair<std::string_view, std::string_view>>& to_replace)
@@ -7,6 +7,7 @@
 #include <optional>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 
 std::string make_api_url(std::string_view instance_url, std::string_view api_route);
 
@@ -22,6 +23,9 @@ std::string clean_up_html(std::string_view to_strip);
 std::string& bulk_replace_mentions(std::string& str, const std::vector<std::pair<std::string_view, std::string_view>>& to_replace);
 std::chrono::system_clock::time_point parse_ISO8601_timestamp(const std::string& timestamp);
 
+// for timestamps that get written to files
+int64_t seconds_since_epoch();
+
 template <typename Number>
 const char* pluralize(Number val, const char* singular, const char* plural)
 {
@@ -24,11 +24,11 @@ function _msync() {
 	# look at the last word to see what to propose next. This usually works, but not if the last thing was a command line option.
 	case "$prev" in
 		$cmd)
-			COMPREPLY=($( compgen -W 'new config sync gen generate queue yeehaw location license version help' -- $word ))
+			COMPREPLY=($( compgen -W 'new config sync gen generate queue show list yeehaw location license version help' -- $word ))
 			return 0;
 			;;
 		'config')
-			COMPREPLY=($( compgen -W 'showall default sync access_token auth_code account_name instance_url client_id client_secret exclude_boosts exclude_favs exclude_follows exclude_mentions exclude_polls' -- $word ))
+			COMPREPLY=($( compgen -W 'showall default sync access_token auth_code account_name instance_url client_id client_secret exclude_boosts exclude_favs exclude_follows exclude_mentions exclude_polls list_format list_segments' -- $word ))
 			return 0;
 			;;
 		'sync' | 's')
@@ -36,12 +36,28 @@ function _msync() {
 			if [[ "$line" == *"config"* ]]; then
 				COMPREPLY=($( compgen -W 'home notifications bookmarks' -- $word ));
 			else
-				COMPREPLY=($( compgen -W "-r --retries -p --posts -m --max-requests -s --send-only -g --get-only --recv-only $accountverbose" -- $word ));
+				COMPREPLY=($( compgen -W "-r --retries --retry-delay --retry-deadline -p --posts -m --max-requests --prefetch -j --jobs --per-instance --send-jobs --upload-jobs --coalesce --retry-failed --stats --stats-json -s --send-only -g --get-only --recv-only $accountverbose" -- $word ));
 			fi
 			return 0;
 			;;
-		'home' | 'notifications')
-			COMPREPLY=($( compgen -W 'newest oldest off' -- $word ));
+		'home' | 'notifications' | 'bookmarks')
+			if [[ "$line" == *"list"* ]]; then
+				COMPREPLY=($( compgen -W "--since $accountverbose" -- $word ));
+			elif [[ "$line" == *"config"* ]]; then
+				COMPREPLY=($( compgen -W 'newest oldest off' -- $word ));
+			fi
+			return 0;
+			;;
+		'list_format')
+			COMPREPLY=($( compgen -W 'text jsonl binary' -- $word ));
+			return 0;
+			;;
+		'list_segments')
+			COMPREPLY=($( compgen -W 'off monthly size' -- $word ));
+			return 0;
+			;;
+		'list')
+			COMPREPLY=($( compgen -W 'home notifications bookmarks' -- $word ));
 			return 0;
 			;;
 		'gen' | 'generate')
@@ -53,14 +69,14 @@ function _msync() {
 			return 0;
 			;;
 		'queue' | 'q')
-			COMPREPLY=($( compgen -W 'remove -r --remove clear -c --clear fav boost bookmark post print context' -- $word ));
+			COMPREPLY=($( compgen -W 'remove -r --remove clear -c --clear -f --from fav boost bookmark post print context' -- $word ));
 			return 0;
 			;;
 		'-r' | '--remove' | '-c' | '--clear' | 'remove' | 'r' | 'c' | 'clear')
 			COMPREPLY=($( compgen -W 'fav boost bookmark post context' -- $word ));
 			return 0;
 			;;
-		'post' | '-f' | '--file' | '--attach' | '--attachment')
+		'post' | '-f' | '--file' | '--from' | '--attach' | '--attachment')
 			COMPREPLY=($( compgen -o filenames -A file -- $word ));
 			return 0;
 			;;
@@ -81,7 +97,7 @@ function _msync() {
 			return 0;
 			;;
 		'sync')
-			COMPREPLY=($( compgen -W "-r --retries -p --posts -m --max-requests -s --send-only -g --get-only --recv-only $accountverbose" -- $word ));
+			COMPREPLY=($( compgen -W "-r --retries --retry-delay --retry-deadline -p --posts -m --max-requests --prefetch -j --jobs --per-instance --send-jobs --upload-jobs --coalesce --retry-failed --stats --stats-json -s --send-only -g --get-only --recv-only $accountverbose" -- $word ));
 			return 0;
 			;;
 	esac
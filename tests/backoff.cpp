@@ -0,0 +1,217 @@
+#include <catch2/catch.hpp>
+
+#include "../lib/sync/backoff.hpp"
+#include "../lib/sync/sync_helpers.hpp"
+
+#include <print_logger.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+using namespace std::chrono_literals;
+
+net_response make_server_error(int status_code)
+{
+	net_response response;
+	response.status_code = status_code;
+	response.okay = false;
+	response.retryable_error = true;
+	return response;
+}
+
+SCENARIO("backoff_ceiling doubles with each retry up to the cap.")
+{
+	GIVEN("A policy starting at 100 ms and capped at 1 second")
+	{
+		backoff_policy policy;
+		policy.base = 100ms;
+		policy.max_delay = 1000ms;
+
+		THEN("the first retry waits at most the base.")
+		{
+			REQUIRE(backoff_ceiling(policy, 1) == 100ms);
+		}
+
+		THEN("each one after that can wait twice as long.")
+		{
+			REQUIRE(backoff_ceiling(policy, 2) == 200ms);
+			REQUIRE(backoff_ceiling(policy, 3) == 400ms);
+			REQUIRE(backoff_ceiling(policy, 4) == 800ms);
+		}
+
+		THEN("it never goes past the cap, no matter how many retries.")
+		{
+			REQUIRE(backoff_ceiling(policy, 5) == 1000ms);
+			REQUIRE(backoff_ceiling(policy, 200) == 1000ms);
+			REQUIRE(backoff_ceiling(policy, 4000000000u) == 1000ms);
+		}
+	}
+
+	GIVEN("The default policy")
+	{
+		const backoff_policy policy;
+
+		THEN("it doesn't wait at all.")
+		{
+			const unsigned int retry = GENERATE(1u, 2u, 10u);
+			REQUIRE(backoff_ceiling(policy, retry) == 0ms);
+			REQUIRE(backoff_delay(policy, retry) == 0ms);
+		}
+	}
+}
+
+SCENARIO("backoff_delay picks a random wait up to the ceiling.")
+{
+	GIVEN("A policy starting at 50 ms")
+	{
+		backoff_policy policy;
+		policy.base = 50ms;
+		policy.max_delay = 400ms;
+		const unsigned int retry = GENERATE(1u, 2u, 3u, 4u, 8u);
+
+		WHEN("a bunch of delays are picked")
+		{
+			bool all_in_range = true;
+			bool all_the_same = true;
+			const auto first = backoff_delay(policy, retry);
+			for (int i = 0; i < 1000; i++)
+			{
+				const auto delay = backoff_delay(policy, retry);
+				all_in_range = all_in_range && delay >= 0ms && delay <= backoff_ceiling(policy, retry);
+				all_the_same = all_the_same && delay == first;
+			}
+
+			THEN("every one is between zero and the ceiling.")
+			{
+				REQUIRE(all_in_range);
+			}
+
+			THEN("they aren't all the same.")
+			{
+				REQUIRE_FALSE(all_the_same);
+			}
+		}
+	}
+}
+
+SCENARIO("request_with_retries backs off between retries after server errors.")
+{
+	logs_off = true;
+
+	GIVEN("A server that fails with a 502 a couple of times, then works")
+	{
+		unsigned int calls = 0;
+		const auto flaky = [&calls]()
+		{
+			if (++calls < 3)
+				return make_server_error(502);
+
+			net_response response;
+			response.okay = true;
+			response.status_code = 200;
+			response.message = "ok";
+			return response;
+		};
+
+		WHEN("it's called with a small backoff")
+		{
+			backoff_policy policy;
+			policy.base = 20ms;
+			const auto response = request_with_retries(flaky, 5, pl(), policy);
+
+			THEN("it eventually succeeds.")
+			{
+				REQUIRE(response.success);
+				REQUIRE(response.tries == 3);
+				REQUIRE(calls == 3);
+			}
+
+			THEN("the time spent backing off is reported and is at most the sum of the ceilings.")
+			{
+				REQUIRE(response.backoff_ms >= 0);
+				REQUIRE(response.backoff_ms <= 20 + 40);
+				REQUIRE(response.time_ms >= response.backoff_ms);
+			}
+		}
+
+		WHEN("it's called with no backoff")
+		{
+			const auto response = request_with_retries(flaky, 5, pl());
+
+			THEN("it succeeds without having waited.")
+			{
+				REQUIRE(response.success);
+				REQUIRE(response.backoff_ms == 0);
+			}
+		}
+	}
+
+	GIVEN("A server that always fails with a 503")
+	{
+		unsigned int calls = 0;
+		const auto down = [&calls]() { calls++; return make_server_error(503); };
+
+		WHEN("it's called with a deadline that's shorter than the backoff")
+		{
+			backoff_policy policy;
+			policy.base = 10s;
+			policy.max_delay = 10s;
+			policy.deadline = 1ms;
+			const auto start = std::chrono::steady_clock::now();
+			const auto response = request_with_retries(down, 5, pl(), policy);
+			const auto took = std::chrono::steady_clock::now() - start;
+
+			THEN("it gives up early instead of using all its retries, unless it happened to pick a tiny wait.")
+			{
+				REQUIRE_FALSE(response.success);
+				REQUIRE(response.status_code == 503);
+				REQUIRE(calls <= 5);
+				REQUIRE(took < 5s);
+			}
+		}
+
+		WHEN("it's called with a deadline and no backoff at all")
+		{
+			backoff_policy policy;
+			policy.deadline = 1h;
+			const auto response = request_with_retries(down, 4, pl(), policy);
+
+			THEN("it uses every retry.")
+			{
+				REQUIRE_FALSE(response.success);
+				REQUIRE(response.tries == 4);
+				REQUIRE(calls == 4);
+				REQUIRE(response.message == "Maximum retries reached.");
+			}
+		}
+	}
+}
+
+SCENARIO("print_statistics mentions the time spent backing off only when there was some.")
+{
+	GIVEN("A stream")
+	{
+		std::ostringstream out;
+
+		WHEN("a request took a few tries and backed off")
+		{
+			print_statistics(out, 1500, 3, 1200);
+
+			THEN("the wait is printed after the attempts.")
+			{
+				REQUIRE(out.str() == " (1500 ms, 3 attempts, 1200 ms backing off)\n");
+			}
+		}
+
+		WHEN("a request went through the first time")
+		{
+			print_statistics(out, 80, 1);
+
+			THEN("it looks like it always did.")
+			{
+				REQUIRE(out.str() == " (80 ms)\n");
+			}
+		}
+	}
+}
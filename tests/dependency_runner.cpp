@@ -0,0 +1,198 @@
+#include <catch2/catch.hpp>
+
+#include "../lib/sync/dependency_runner.hpp"
+
+#include <msync_exception.hpp>
+#include <print_logger.hpp>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+// 0 -> 1 -> 2 is a chain, 3 and 4 depend on nothing, 5 waits for both 1 and 3, and 6 through 11 are on their own
+std::vector<std::vector<size_t>> make_fake_graph()
+{
+	return { {}, { 0 }, { 1 }, {}, {}, { 1, 3 }, {}, {}, {}, {}, {}, {} };
+}
+
+SCENARIO("run_in_dependency_order runs everything once and never before what it depends on.")
+{
+	logs_off = true;
+
+	GIVEN("A graph with some chains and some independent calls.")
+	{
+		const auto graph = make_fake_graph();
+		const auto jobs = GENERATE(1u, 2u, 4u, 16u);
+
+		std::mutex lock;
+		std::vector<size_t> finished;
+		bool dependencies_finished_first = true;
+		unsigned int running = 0;
+		unsigned int most_running = 0;
+
+		WHEN("it's run")
+		{
+			const auto succeeded = run_in_dependency_order(graph, jobs, [&](size_t i)
+			{
+				{
+					const std::lock_guard<std::mutex> guard(lock);
+					dependencies_finished_first = dependencies_finished_first && std::all_of(graph[i].begin(), graph[i].end(), [&](size_t dependency)
+					{
+						return std::find(finished.begin(), finished.end(), dependency) != finished.end();
+					});
+					running++;
+					most_running = std::max(most_running, running);
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+				const std::lock_guard<std::mutex> guard(lock);
+				running--;
+				finished.push_back(i);
+				return i % 2 == 0;
+			});
+
+			THEN("everything ran exactly once.")
+			{
+				REQUIRE(finished.size() == graph.size());
+				std::sort(finished.begin(), finished.end());
+				REQUIRE(std::adjacent_find(finished.begin(), finished.end()) == finished.end());
+			}
+
+			THEN("nothing started before what it depends on finished.")
+			{
+				REQUIRE(dependencies_finished_first);
+			}
+
+			THEN("no more than the allowed number ran at once.")
+			{
+				REQUIRE(most_running <= jobs);
+			}
+
+			THEN("each one's result is reported in its own slot.")
+			{
+				REQUIRE(succeeded.size() == graph.size());
+				for (size_t i = 0; i < graph.size(); i++)
+				{
+					REQUIRE(succeeded[i] == (i % 2 == 0));
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("run_in_dependency_order starts dependents only after their dependencies finish, even when they'd otherwise be first in line.")
+{
+	logs_off = true;
+
+	GIVEN("A slow call and one that depends on it, with plenty of jobs.")
+	{
+		const std::vector<std::vector<size_t>> graph{ {}, { 0 }, {}, {} };
+
+		std::mutex lock;
+		std::vector<std::string> events;
+
+		WHEN("it's run")
+		{
+			run_in_dependency_order(graph, 4, [&](size_t i)
+			{
+				{
+					const std::lock_guard<std::mutex> guard(lock);
+					events.push_back("start " + std::to_string(i));
+				}
+
+				if (i == 0)
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+				const std::lock_guard<std::mutex> guard(lock);
+				events.push_back("end " + std::to_string(i));
+				return true;
+			});
+
+			THEN("the dependent started after the slow call ended.")
+			{
+				const auto slow_ended = std::find(events.begin(), events.end(), "end 0");
+				const auto dependent_started = std::find(events.begin(), events.end(), "start 1");
+				REQUIRE(slow_ended < dependent_started);
+			}
+
+			THEN("the independent calls didn't wait for the slow one.")
+			{
+				const auto slow_ended = std::find(events.begin(), events.end(), "end 0");
+				REQUIRE(std::find(events.begin(), events.end(), "end 2") < slow_ended);
+				REQUIRE(std::find(events.begin(), events.end(), "end 3") < slow_ended);
+			}
+		}
+	}
+}
+
+SCENARIO("run_in_dependency_order keeps going when one call throws and reports the first failure.")
+{
+	logs_off = true;
+
+	GIVEN("A graph where a couple of calls throw.")
+	{
+		const auto graph = make_fake_graph();
+		const auto jobs = GENERATE(3u, 12u);
+
+		std::mutex lock;
+		std::vector<size_t> ran;
+
+		WHEN("it's run")
+		{
+			const auto run = [&]()
+			{
+				run_in_dependency_order(graph, jobs, [&](size_t i)
+				{
+					if (i == 1 || i == 7)
+						throw msync_exception("call " + std::to_string(i));
+
+					const std::lock_guard<std::mutex> guard(lock);
+					ran.push_back(i);
+					return true;
+				});
+			};
+
+			THEN("the exception for the first failing call is thrown.")
+			{
+				REQUIRE_THROWS_WITH(run(), "call 1");
+
+				AND_THEN("every other call still ran, including the ones that depend on the failures.")
+				{
+					REQUIRE(ran.size() == graph.size() - 2);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("run_in_dependency_order writes out each call's logs in order.")
+{
+	GIVEN("Calls that finish out of order and a caller that's capturing its logs.")
+	{
+		const std::vector<std::vector<size_t>> graph(6);
+
+		WHEN("it's run")
+		{
+			logs_off = false;
+			log_buffer collected;
+			captured_logs = &collected;
+			run_in_dependency_order(graph, 3, [&](size_t i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(5 * (graph.size() - i)));
+				pl() << "call " << i << '\n';
+				return true;
+			});
+			captured_logs = nullptr;
+			logs_off = true;
+
+			THEN("the logs come out in the same order as the calls, all in the caller's buffer.")
+			{
+				REQUIRE(collected.console.str() == "call 0\ncall 1\ncall 2\ncall 3\ncall 4\ncall 5\n");
+			}
+		}
+	}
+}
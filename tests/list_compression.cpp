@@ -0,0 +1,294 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/postlist/post_list.hpp"
+#include "../lib/postlist/list_compression.hpp"
+#include "../lib/postlist/list_segments.hpp"
+#include "../lib/postlist/post_index.hpp"
+#include "../lib/entities/entities.hpp"
+
+#include <msync_exception.hpp>
+
+#include <filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// two posts a month, starting in January 2020
+mastodon_status make_compressed_status(int n)
+{
+	return make_test_status(n, 500 + n, make_test_date(2020, n / 2 + 1, 10 + n % 2));
+}
+
+std::string gzipped(const std::string& text)
+{
+	std::istringstream in{ text };
+	std::ostringstream out;
+	REQUIRE(gzip(in, out));
+	return out.str();
+}
+
+std::string gunzipped(const std::string& compressed, bool expect_success = true)
+{
+	std::istringstream in{ compressed };
+	std::string out;
+	REQUIRE(gunzip(in, out) == expect_success);
+	return out;
+}
+
+SCENARIO("gzip and gunzip round trip text.")
+{
+	if (!can_compress())
+		return;
+
+	GIVEN("Some text")
+	{
+		const std::string text = GENERATE(std::string{}, std::string{ "just a little bit" }, std::string(200000, 'a'), [] {
+			// bigger than one chunk, and not very compressible
+			std::string noise;
+			for (int i = 0; i < 100000; i++)
+				noise += static_cast<char>(zero_to_n(255));
+			return noise;
+		}());
+
+		WHEN("it's gzipped")
+		{
+			const std::string compressed = gzipped(text);
+
+			THEN("it starts with the gzip magic number.")
+			{
+				REQUIRE(compressed.size() >= 2);
+				REQUIRE(static_cast<unsigned char>(compressed[0]) == 0x1f);
+				REQUIRE(static_cast<unsigned char>(compressed[1]) == 0x8b);
+			}
+
+			THEN("it comes back the same.")
+			{
+				REQUIRE(gunzipped(compressed) == text);
+			}
+
+			THEN("cutting it off partway means it doesn't decompress all the way.")
+			{
+				gunzipped(compressed.substr(0, compressed.size() - 4), false);
+			}
+		}
+	}
+
+	GIVEN("Two gzipped files stuck together")
+	{
+		const std::string compressed = gzipped("first part\n") + gzipped("second part\n");
+
+		THEN("both parts come out.")
+		{
+			REQUIRE(gunzipped(compressed) == "first part\nsecond part\n");
+		}
+	}
+
+	GIVEN("Something that isn't gzipped")
+	{
+		THEN("gunzip says so.")
+		{
+			gunzipped("status id: 12345\n", false);
+		}
+	}
+}
+
+SCENARIO("Finished segments are compressed and can still be read.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "home.list";
+
+	std::vector<mastodon_status> statuses;
+	for (int i = 0; i < 8; i++)
+		statuses.push_back(make_compressed_status(i));
+
+	GIVEN("A list that hasn't been split up")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			list.write(statuses.begin(), statuses.end());
+		}
+
+		WHEN("its finished segments are compressed")
+		{
+			compress_finished_segments(list_file);
+
+			THEN("nothing happens, since it's still being written to.")
+			{
+				REQUIRE(fs::exists(list_file));
+				REQUIRE_FALSE(fs::exists(compressed_file_for(list_file)));
+			}
+		}
+	}
+
+	GIVEN("A list split up by month")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, segment_policy{ list_segments::monthly } };
+			list.write(statuses.begin(), statuses.end());
+		}
+
+		const auto segments = read_segments(list_file);
+		REQUIRE(segments.size() == 4);
+
+		std::vector<std::string> before;
+		for (const fs::path& segment : segments)
+			before.push_back(read_file(segment));
+
+		WHEN("its finished segments are compressed")
+		{
+			compress_finished_segments(list_file);
+
+			if (!can_compress())
+			{
+				THEN("without zlib, nothing is compressed.")
+				{
+					for (const fs::path& segment : segments)
+						REQUIRE(fs::exists(segment));
+				}
+				return;
+			}
+
+			THEN("every segment but the newest is replaced with a .gz, and the manifest doesn't change.")
+			{
+				for (size_t i = 0; i < segments.size() - 1; i++)
+				{
+					REQUIRE_FALSE(fs::exists(segments[i]));
+					REQUIRE(fs::exists(compressed_file_for(segments[i])));
+					REQUIRE(fs::exists(index_file_for(segments[i])));
+				}
+				REQUIRE(fs::exists(segments.back()));
+				REQUIRE_FALSE(fs::exists(compressed_file_for(segments.back())));
+				REQUIRE(read_segments(list_file) == segments);
+				REQUIRE(count_files_in_directory(dir.dirname) == 1 + segments.size() * 2);
+			}
+
+			THEN("each segment reads back the same as it was.")
+			{
+				for (size_t i = 0; i < segments.size(); i++)
+					REQUIRE(read_segment(segments[i]) == before[i]);
+			}
+
+			THEN("the old indexes still find posts in the decompressed text.")
+			{
+				const std::string text = read_segment(segments[1]);
+				post_index index{ segments[1], text };
+				REQUIRE(index.size() == 2);
+
+				std::istringstream list{ text };
+				std::ostringstream printed;
+				printed << statuses[3];
+				REQUIRE(read_post(list, *index.find(statuses[3].id)) == printed.str());
+			}
+
+			THEN("the old indexes can be used as they are, without decompressing anything.")
+			{
+				post_index index{ segments[1], index_as_is{} };
+				REQUIRE(index.size() == 2);
+				REQUIRE(index.find(statuses[3].id).has_value());
+				REQUIRE_FALSE(index.find(statuses[5].id).has_value());
+				REQUIRE(index.since("2020-03").empty());
+			}
+
+			AND_WHEN("more is written and they're compressed again")
+			{
+				const auto later = make_compressed_status(8);
+				{
+					post_list<mastodon_status> list{ list_file, true, list_format::text, segment_policy{ list_segments::monthly } };
+					list.write(later);
+				}
+				compress_finished_segments(list_file);
+
+				THEN("the segment that was newest is compressed now too, and the new one isn't.")
+				{
+					const auto now = read_segments(list_file);
+					REQUIRE(now.size() == 5);
+					REQUIRE(fs::exists(compressed_file_for(now[3])));
+					REQUIRE_FALSE(fs::exists(now[3]));
+					REQUIRE(read_segment(now[3]) == before[3]);
+					REQUIRE(fs::exists(now[4]));
+				}
+			}
+		}
+
+		WHEN("a compressed segment gets cut off")
+		{
+			if (!can_compress())
+				return;
+
+			compress_finished_segments(list_file);
+			const fs::path compressed = compressed_file_for(segments[0]);
+			fs::resize_file(compressed, fs::file_size(compressed) / 2);
+
+			THEN("reading it throws instead of handing back part of it.")
+			{
+				REQUIRE_THROWS_AS(read_segment(segments[0]), msync_exception);
+			}
+		}
+
+		WHEN("the compressed copy can't be written")
+		{
+			if (!can_compress())
+				return;
+
+			// a directory where the partial file would go means it can't be opened
+			fs::create_directory(fs::path(compressed_file_for(segments[0])).concat(".partial"));
+
+			THEN("the segment is left as it was.")
+			{
+				REQUIRE_FALSE(compress_segment(segments[0]));
+				REQUIRE(read_file(segments[0]) == before[0]);
+				REQUIRE_FALSE(fs::exists(compressed_file_for(segments[0])));
+			}
+		}
+
+		WHEN("a segment's index is missing some posts when it's compressed")
+		{
+			if (!can_compress())
+				return;
+
+			fs::remove(index_file_for(segments[0]));
+			{
+				std::ofstream make_empty{ index_file_for(segments[0]).c_str() };
+			}
+			compress_finished_segments(list_file);
+
+			THEN("the index is caught up first.")
+			{
+				post_index index{ segments[0], read_segment(segments[0]) };
+				REQUIRE(index.size() == 2);
+			}
+		}
+	}
+
+	GIVEN("A segment that's already there twice, from being stopped partway through compressing it")
+	{
+		if (!can_compress())
+			return;
+
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, segment_policy{ list_segments::monthly } };
+			list.write(statuses.begin(), statuses.end());
+		}
+		const auto segments = read_segments(list_file);
+		const std::string text = read_file(segments[0]);
+		{
+			std::ofstream stale{ compressed_file_for(segments[0]).c_str(), std::ios::binary };
+			stale << "not finished";
+		}
+
+		WHEN("the finished segments are compressed")
+		{
+			compress_finished_segments(list_file);
+
+			THEN("it's redone from the uncompressed copy.")
+			{
+				REQUIRE_FALSE(fs::exists(segments[0]));
+				REQUIRE(read_segment(segments[0]) == text);
+			}
+		}
+	}
+}
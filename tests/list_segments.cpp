@@ -0,0 +1,341 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/postlist/post_list.hpp"
+#include "../lib/postlist/list_segments.hpp"
+#include "../lib/postlist/post_index.hpp"
+#include "../lib/entities/entities.hpp"
+
+#include <filesystem.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// five posts a month, starting in November 2019
+mastodon_status make_segmented_status(int n)
+{
+	return make_test_status(n, 1000 + n, make_test_date(2019, 11 + n / 5, n % 5 + 1));
+}
+
+std::string print_all(const std::vector<mastodon_status>& statuses)
+{
+	std::ostringstream out;
+	for (const auto& status : statuses)
+		out << status << "\n--------------\n";
+	return out.str();
+}
+
+std::vector<std::string> segment_names(const fs::path& list_file)
+{
+	std::vector<std::string> names;
+	for (const fs::path& segment : read_segments(list_file))
+		names.push_back(to_utf8(segment.filename()));
+	return names;
+}
+
+std::string read_all_segments(const fs::path& list_file)
+{
+	std::string all;
+	for (const fs::path& segment : read_segments(list_file))
+		all += read_file(segment);
+	return all;
+}
+
+SCENARIO("Segments are named after the list they're part of.")
+{
+	const fs::path list_file = fs::path("somewhere") / "home.list";
+
+	THEN("the key goes between the name and the extension, and can be gotten back out.")
+	{
+		const fs::path segment = segment_file(list_file, "2026-10");
+		REQUIRE(segment == fs::path("somewhere") / "home.2026-10.list");
+		REQUIRE(segment_key(list_file, segment) == "2026-10");
+		REQUIRE(segment_file(fs::path("notifications.jsonl"), "0003") == fs::path("notifications.0003.jsonl"));
+	}
+
+	THEN("the list itself and other files don't have a key.")
+	{
+		REQUIRE(segment_key(list_file, list_file).empty());
+		REQUIRE(segment_key(list_file, fs::path("home..list")).empty());
+		REQUIRE(segment_key(list_file, fs::path("notifications.2026-10.list")).empty());
+		REQUIRE(segment_key(list_file, fs::path("home.2026-10.jsonl")).empty());
+	}
+
+	THEN("month_key only takes a year and month off the front.")
+	{
+		REQUIRE(month_key("2026-10-18T04:25:29.000Z") == "2026-10");
+		REQUIRE(month_key("2026-10") == "2026-10");
+		REQUIRE(month_key("2026-1").empty());
+		REQUIRE(month_key("20261018").empty());
+		REQUIRE(month_key("10:50 AM 11/15/2019").empty());
+		REQUIRE(month_key("").empty());
+	}
+
+	THEN("a list that's never been split up is its own only segment.")
+	{
+		const test_dir dir = temporary_directory();
+		REQUIRE(read_segments(dir.dirname / "home.list") == std::vector<fs::path>{ dir.dirname / "home.list" });
+		REQUIRE(next_numbered_key(dir.dirname / "home.list") == "0001");
+	}
+}
+
+SCENARIO("post_list can split a list up by month.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "home.list";
+	const segment_policy monthly{ list_segments::monthly };
+
+	std::vector<mastodon_status> statuses;
+	for (int i = 0; i < 15; i++)
+		statuses.push_back(make_segmented_status(i));
+
+	GIVEN("Three months of posts written as one page to a post_list split by month")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+			list.write(statuses.begin(), statuses.end());
+		}
+
+		THEN("each month gets its own file, in the manifest in order, and there's no home.list.")
+		{
+			REQUIRE(segment_names(list_file) == std::vector<std::string>{ "home.2019-11.list", "home.2019-12.list", "home.2020-01.list" });
+			REQUIRE_FALSE(fs::exists(list_file));
+		}
+
+		THEN("each segment has that month's posts, and all of them together are the same as one list.")
+		{
+			REQUIRE(read_file(dir.dirname / "home.2019-12.list") == print_all({ statuses.begin() + 5, statuses.begin() + 10 }));
+			REQUIRE(read_all_segments(list_file) == print_all(statuses));
+		}
+
+		THEN("each segment is indexed on its own.")
+		{
+			const auto segments = read_segments(list_file);
+			for (size_t i = 0; i < segments.size(); i++)
+			{
+				post_index index{ segments[i] };
+				REQUIRE(index.size() == 5);
+				REQUIRE(index.covered() == fs::file_size(segments[i]));
+
+				std::ostringstream printed;
+				printed << statuses[i * 5 + 2];
+				REQUIRE(read_post(segments[i], *index.find(statuses[i * 5 + 2].id)) == printed.str());
+			}
+		}
+
+		WHEN("more posts from the same month are written later, along with one from before it")
+		{
+			auto old = make_segmented_status(0);
+			old.id = "1";
+			auto same_month = make_segmented_status(14);
+			same_month.id = "2000";
+
+			{
+				post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+				list.write(same_month);
+				list.write(old);
+			}
+
+			THEN("they go at the end of the newest segment, and the old segments aren't touched.")
+			{
+				REQUIRE(segment_names(list_file).size() == 3);
+				REQUIRE(read_file(dir.dirname / "home.2020-01.list") == print_all({ statuses[10], statuses[11], statuses[12], statuses[13], statuses[14], same_month, old }));
+				REQUIRE(read_file(dir.dirname / "home.2019-11.list") == print_all({ statuses.begin(), statuses.begin() + 5 }));
+			}
+		}
+
+		WHEN("splitting is turned off and more are written")
+		{
+			const auto later = make_segmented_status(40);
+			{
+				post_list<mastodon_status> list{ list_file, true };
+				list.write(later);
+			}
+
+			THEN("they still go in the newest segment.")
+			{
+				REQUIRE_FALSE(fs::exists(list_file));
+				REQUIRE(segment_names(list_file).size() == 3);
+				REQUIRE(read_all_segments(list_file) == print_all(statuses) + print_all({ later }));
+			}
+		}
+	}
+
+	GIVEN("A list from before it was split up")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			list.write(statuses.begin(), statuses.begin() + 7);
+		}
+
+		WHEN("the rest are written to it split by month")
+		{
+			{
+				post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+				list.write(statuses.begin() + 7, statuses.end());
+			}
+
+			THEN("the old list is kept as the first segment and left as it was.")
+			{
+				REQUIRE(segment_names(list_file) == std::vector<std::string>{ "home.list", "home.2019-12.list", "home.2020-01.list" });
+				REQUIRE(read_file(list_file) == print_all({ statuses.begin(), statuses.begin() + 7 }));
+				REQUIRE(read_all_segments(list_file) == print_all(statuses));
+			}
+		}
+	}
+
+	GIVEN("A post_list split by month that's only given a list to append, with posts from several months in it")
+	{
+		const fs::path spilled = dir.dirname / "home.list.spill0";
+		std::vector<written_post> layout;
+		{
+			post_list<mastodon_status> list{ spilled };
+			list.keep_layout();
+			list.write(statuses.begin(), statuses.begin() + 12);
+			layout = list.take_layout();
+		}
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+			list.append(spilled, layout);
+		}
+
+		THEN("each post goes in its own month's segment, the same as if they'd been written one at a time.")
+		{
+			REQUIRE_FALSE(fs::exists(list_file));
+			REQUIRE(segment_names(list_file) == std::vector<std::string>{ "home.2019-11.list", "home.2019-12.list", "home.2020-01.list" });
+			REQUIRE(read_file(dir.dirname / "home.2019-11.list") == print_all({ statuses.begin(), statuses.begin() + 5 }));
+			REQUIRE(read_file(dir.dirname / "home.2019-12.list") == print_all({ statuses.begin() + 5, statuses.begin() + 10 }));
+			REQUIRE(read_file(dir.dirname / "home.2020-01.list") == print_all({ statuses.begin() + 10, statuses.begin() + 12 }));
+		}
+
+		THEN("each segment's index points at its own posts.")
+		{
+			post_index index{ dir.dirname / "home.2019-12.list" };
+			REQUIRE(index.size() == 5);
+			REQUIRE(read_post(dir.dirname / "home.2019-12.list", *index.find(statuses[7].id)) + "\n--------------\n" == print_all({ statuses[7] }));
+		}
+	}
+
+	GIVEN("A post_list split by month that's given a boost of an old post first")
+	{
+		mastodon_status boost = statuses[5];
+		boost.boosted_by = "booster@website.egg";
+		boost.boosted_at = boost.created_at;
+		boost.created_at = "2015-03-01T00:00:00.000Z";
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+			list.write(boost);
+		}
+
+		THEN("it goes in the segment for the month it was boosted.")
+		{
+			REQUIRE(read_segments(list_file) == std::vector<fs::path>{ segment_file(list_file, "2019-12") });
+		}
+	}
+
+	GIVEN("A post_list split by month that's given a post without a date first")
+	{
+		mastodon_status undated = statuses[0];
+		undated.created_at.clear();
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, monthly };
+			list.write(undated);
+		}
+
+		THEN("it goes in this month's segment, not the list itself.")
+		{
+			REQUIRE_FALSE(fs::exists(list_file));
+			REQUIRE(read_segments(list_file) == std::vector<fs::path>{ segment_file(list_file, current_month_key()) });
+		}
+	}
+}
+
+SCENARIO("post_list can split a list up by size.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "notifications.list";
+
+	std::vector<mastodon_status> statuses;
+	for (int i = 0; i < 30; i++)
+		statuses.push_back(make_segmented_status(i));
+
+	const uint64_t post_size = print_all({ statuses[0] }).size();
+	const segment_policy by_size{ list_segments::size, post_size * 4 };
+
+	GIVEN("Posts written a few at a time to a post_list that splits every four posts or so")
+	{
+		for (size_t i = 0; i < statuses.size(); i += 7)
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, by_size };
+			list.write(statuses.begin() + i, statuses.begin() + std::min(i + 7, statuses.size()));
+		}
+
+		THEN("the first segment is the list itself, and the rest are numbered in order.")
+		{
+			const auto names = segment_names(list_file);
+			REQUIRE(names.size() == 8);
+			REQUIRE(names[0] == "notifications.list");
+			REQUIRE(names[1] == "notifications.0001.list");
+			REQUIRE(names[7] == "notifications.0007.list");
+		}
+
+		THEN("no segment gets more than one post past the limit.")
+		{
+			for (const fs::path& segment : read_segments(list_file))
+			{
+				REQUIRE(fs::file_size(segment) <= by_size.max_bytes + post_size);
+			}
+		}
+
+		THEN("all the segments together are the same as one list.")
+		{
+			REQUIRE(read_all_segments(list_file) == print_all(statuses));
+		}
+
+		THEN("the next segment would be 0008.")
+		{
+			REQUIRE(next_numbered_key(list_file) == "0008");
+		}
+	}
+
+	GIVEN("A full segment and a list to append to it that's longer than a segment")
+	{
+		const fs::path spilled = dir.dirname / "notifications.list.spill0";
+		std::vector<written_post> layout;
+		{
+			post_list<mastodon_status> list{ spilled };
+			list.keep_layout();
+			list.write(statuses.begin() + 4, statuses.begin() + 14);
+			layout = list.take_layout();
+		}
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::text, by_size };
+			list.write(statuses.begin(), statuses.begin() + 4);
+			list.append(spilled, layout);
+		}
+
+		THEN("the appended list is split up the same as if it had been written one post at a time.")
+		{
+			REQUIRE(segment_names(list_file) == std::vector<std::string>{ "notifications.list", "notifications.0001.list", "notifications.0002.list", "notifications.0003.list" });
+			REQUIRE(read_file(dir.dirname / "notifications.0001.list") == print_all({ statuses.begin() + 4, statuses.begin() + 8 }));
+			REQUIRE(read_all_segments(list_file) == print_all({ statuses.begin(), statuses.begin() + 14 }));
+
+			for (const fs::path& segment : read_segments(list_file))
+			{
+				REQUIRE(fs::file_size(segment) <= by_size.max_bytes + post_size);
+			}
+		}
+
+		THEN("each new segment is indexed.")
+		{
+			size_t total = 0;
+			for (const fs::path& segment : read_segments(list_file))
+				total += post_index{ segment }.size();
+			REQUIRE(total == 14);
+			REQUIRE(post_index{ dir.dirname / "notifications.0003.list" }.size() == 2);
+		}
+	}
+}
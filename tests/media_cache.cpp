@@ -0,0 +1,153 @@
+#include "test_helpers.hpp"
+#include <catch2/catch.hpp>
+
+#include "../lib/sync/media_cache.hpp"
+
+#include <filesystem.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+void write_attachment(const fs::path& file, std::string_view contents)
+{
+	std::ofstream of{ file.c_str(), std::ios::binary };
+	of << contents;
+}
+
+SCENARIO("media_cache keys change when the file or its description does.")
+{
+	const test_dir dir = temporary_directory();
+
+	GIVEN("Two files with different contents of the same size.")
+	{
+		const fs::path first = dir.dirname / "first.png";
+		const fs::path second = dir.dirname / "second.png";
+		write_attachment(first, "some picture");
+		write_attachment(second, "some Picture");
+
+		THEN("the same file and description always gets the same key.")
+		{
+			REQUIRE(media_cache::key_for(first, "a cat") == media_cache::key_for(first, "a cat"));
+		}
+
+		THEN("different files get different keys.")
+		{
+			REQUIRE(media_cache::key_for(first, "a cat") != media_cache::key_for(second, "a cat"));
+		}
+
+		THEN("different descriptions get different keys.")
+		{
+			REQUIRE(media_cache::key_for(first, "a cat") != media_cache::key_for(first, "a dog"));
+		}
+
+		WHEN("a file is copied somewhere else")
+		{
+			const fs::path copy = dir.dirname / "copy.png";
+			fs::copy_file(first, copy);
+
+			THEN("it has the same key, since it's what's in the file that counts.")
+			{
+				REQUIRE(media_cache::key_for(first, "a cat") == media_cache::key_for(copy, "a cat"));
+			}
+		}
+	}
+}
+
+SCENARIO("media_cache remembers uploads between syncs until they're used or expire.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path cache_file = dir.dirname / "media.cache";
+
+	GIVEN("A cache with a couple of uploads in it.")
+	{
+		{
+			media_cache cache{ cache_file };
+			cache.remember("10-aaaa-bbbb", "12345");
+			cache.remember("20-cccc-dddd", "67890");
+		}
+
+		WHEN("it's opened again")
+		{
+			media_cache cache{ cache_file };
+
+			THEN("the uploads are still there.")
+			{
+				REQUIRE(cache.find("10-aaaa-bbbb") == "12345");
+				REQUIRE(cache.find("20-cccc-dddd") == "67890");
+			}
+
+			THEN("something that wasn't uploaded isn't found.")
+			{
+				REQUIRE(cache.find("30-eeee-ffff").empty());
+			}
+		}
+
+		WHEN("it's opened again and only looked in")
+		{
+			{
+				media_cache cache{ cache_file };
+				REQUIRE(cache.find("10-aaaa-bbbb") == "12345");
+				cache.forget({ "99999" });
+			}
+
+			THEN("it isn't written again.")
+			{
+				REQUIRE_FALSE(fs::exists(fs::path(cache_file).concat(".bak")));
+			}
+		}
+
+		WHEN("one of them is used in a post and it's opened again")
+		{
+			{
+				media_cache cache{ cache_file };
+				cache.forget({ "12345" });
+			}
+
+			media_cache cache{ cache_file };
+
+			THEN("only the other one is left.")
+			{
+				REQUIRE(cache.find("10-aaaa-bbbb").empty());
+				REQUIRE(cache.find("20-cccc-dddd") == "67890");
+			}
+		}
+	}
+
+	GIVEN("No cache file.")
+	{
+		WHEN("a cache is looked in and has something forgotten, but nothing's remembered")
+		{
+			{
+				media_cache cache{ cache_file };
+				REQUIRE(cache.find("10-aaaa-bbbb").empty());
+				cache.forget({ "12345" });
+			}
+
+			THEN("no file is made.")
+			{
+				REQUIRE_FALSE(fs::exists(cache_file));
+			}
+		}
+	}
+
+	GIVEN("A cache file with one entry that's expired and one that hasn't.")
+	{
+		{
+			std::ofstream of{ cache_file.c_str() };
+			of << "10-aaaa-bbbb 1000 12345\n";
+			of << "20-cccc-dddd 99999999999 67890\n";
+		}
+
+		WHEN("it's opened")
+		{
+			media_cache cache{ cache_file };
+
+			THEN("only the one that hasn't expired is found.")
+			{
+				REQUIRE(cache.find("10-aaaa-bbbb").empty());
+				REQUIRE(cache.find("20-cccc-dddd") == "67890");
+			}
+		}
+	}
+}
@@ -76,11 +76,85 @@ SCENARIO("sync_settings stringify properly.")
 	}
 }
 
+CATCH_REGISTER_ENUM(list_format, list_format::text, list_format::jsonl, list_format::binary)
+
+SCENARIO("list_formats stringify and parse properly.")
+{
+	Catch::StringMaker<list_format> sm;
+	GIVEN("A list_format")
+	{
+		const auto val = GENERATE(list_format::text, list_format::jsonl, list_format::binary);
+		WHEN("that list_format is looked up in its array")
+		{
+			const auto result = LIST_FORMAT_NAMES[static_cast<int>(val)];
+			THEN("the corresponding string is the correct one.")
+			{
+				REQUIRE(result == sm.convert(val));
+			}
+
+			AND_WHEN("the looked-up string is parsed")
+			{
+				const auto parsedval = parse_enum<list_format>(result[0]);
+
+				THEN("it matches the original.")
+				{
+					REQUIRE(parsedval == val);
+				}
+			}
+		}
+	}
+
+	GIVEN("A list_format type")
+	{
+		THEN("Its array has an entry for each value.")
+		{
+			STATIC_REQUIRE(LIST_FORMAT_NAMES.size() == static_cast<int>(list_format::binary) + 1);
+		}
+	}
+}
+
+CATCH_REGISTER_ENUM(list_segments, list_segments::off, list_segments::monthly, list_segments::size)
+
+SCENARIO("list_segments stringify and parse properly.")
+{
+	Catch::StringMaker<list_segments> sm;
+	GIVEN("A list_segments")
+	{
+		const auto val = GENERATE(list_segments::off, list_segments::monthly, list_segments::size);
+		WHEN("that list_segments is looked up in its array")
+		{
+			const auto result = LIST_SEGMENTS_NAMES[static_cast<int>(val)];
+			THEN("the corresponding string is the correct one.")
+			{
+				REQUIRE(result == sm.convert(val));
+			}
+
+			AND_WHEN("the looked-up string is parsed")
+			{
+				const auto parsedval = parse_enum<list_segments>(result[0]);
+
+				THEN("it matches the original.")
+				{
+					REQUIRE(parsedval == val);
+				}
+			}
+		}
+	}
+
+	GIVEN("A list_segments type")
+	{
+		THEN("Its array has an entry for each value.")
+		{
+			STATIC_REQUIRE(LIST_SEGMENTS_NAMES.size() == static_cast<int>(list_segments::size) + 1);
+		}
+	}
+}
+
 CATCH_REGISTER_ENUM(user_option, user_option::file_version, user_option::account_name, user_option::instance_url, user_option::auth_code,
 					user_option::access_token, user_option::client_secret, user_option::client_id, 
 					user_option::last_home_id, user_option::last_dm_id, user_option::last_bookmark_id, user_option::last_notification_id,
 					user_option::exclude_follows, user_option::exclude_favs, user_option::exclude_boosts, user_option::exclude_mentions, user_option::exclude_polls,
-					user_option::pull_home, user_option::pull_dms, user_option::pull_bookmarks, user_option::pull_notifications)
+					user_option::pull_home, user_option::pull_dms, user_option::pull_bookmarks, user_option::pull_notifications, user_option::list_format, user_option::list_segments)
 
 SCENARIO("user_option values stringify properly.")
 {
@@ -91,7 +165,7 @@ SCENARIO("user_option values stringify properly.")
 					user_option::access_token, user_option::client_secret, user_option::client_id, 
 					user_option::last_home_id, user_option::last_dm_id, user_option::last_bookmark_id, user_option::last_notification_id,
 					user_option::exclude_follows, user_option::exclude_favs, user_option::exclude_boosts, user_option::exclude_mentions, user_option::exclude_polls,
-					user_option::pull_home, user_option::pull_dms, user_option::pull_bookmarks, user_option::pull_notifications);
+					user_option::pull_home, user_option::pull_dms, user_option::pull_bookmarks, user_option::pull_notifications, user_option::list_format, user_option::list_segments);
 
 		WHEN("that user_option is looked up in its array")
 		{
@@ -107,7 +181,7 @@ SCENARIO("user_option values stringify properly.")
 	{
 		THEN("Its array has an entry for each value.")
 		{
-			STATIC_REQUIRE(USER_OPTION_NAMES.size() == static_cast<int>(user_option::pull_notifications) + 1);
+			STATIC_REQUIRE(USER_OPTION_NAMES.size() == static_cast<int>(user_option::list_segments) + 1);
 		}
 	}
 }
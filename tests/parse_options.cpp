@@ -479,6 +479,78 @@ SCENARIO("The command line parser extracts configuration option lines correctly.
 		}
 	}*/
 
+	GIVEN("A command line that sets the format to write lists in.")
+	{
+		const auto format = GENERATE(
+			std::make_pair("text", list_format::text),
+			std::make_pair("jsonl", list_format::jsonl),
+			std::make_pair("binary", list_format::binary));
+
+		char const* argv[]{ "msync", "config", "list_format", format.first, "-a", "coolestfriend" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(6, argv);
+
+			THEN("the selected mode is configformat")
+			{
+				REQUIRE(parsed.selected == mode::configformat);
+			}
+
+			THEN("the option and format are set")
+			{
+				REQUIRE(parsed.toset == user_option::list_format);
+				REQUIRE(parsed.format == format.second);
+			}
+
+			THEN("the account is set")
+			{
+				REQUIRE(parsed.account == "coolestfriend");
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
+	GIVEN("A command line that sets how to split lists up.")
+	{
+		const auto segments = GENERATE(
+			std::make_pair("off", list_segments::off),
+			std::make_pair("monthly", list_segments::monthly),
+			std::make_pair("size", list_segments::size));
+
+		char const* argv[]{ "msync", "config", "list_segments", segments.first, "-a", "coolestfriend" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(6, argv);
+
+			THEN("the selected mode is configsegments")
+			{
+				REQUIRE(parsed.selected == mode::configsegments);
+			}
+
+			THEN("the option and setting are set")
+			{
+				REQUIRE(parsed.toset == user_option::list_segments);
+				REQUIRE(parsed.segments == segments.second);
+			}
+
+			THEN("the account is set")
+			{
+				REQUIRE(parsed.account == "coolestfriend");
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
 	GIVEN("A command line specifying that the notifications timeline should not be synced.")
 	{
 		constexpr int argc = 7;
@@ -578,6 +650,8 @@ SCENARIO("The command line parser recognizes when the user wants to sync.")
 			THEN("retries are set to the default.")
 			{
 				REQUIRE(parsed.sync_opts.retries == 3);
+				REQUIRE(parsed.sync_opts.retry_delay == 500);
+				REQUIRE(parsed.sync_opts.retry_deadline == 120);
 			}
 
 			THEN("the parse is good")
@@ -618,6 +692,33 @@ SCENARIO("The command line parser recognizes when the user wants to sync.")
 		}
 	}
 
+	GIVEN("A command line that says 'sync' and sets how long to back off between retries.")
+	{
+		constexpr int argc = 6;
+		char const* argv[]{ "msync", subcommand, "--retry-delay", "250", "--retry-deadline", "0" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(argc, argv);
+
+			THEN("the delay and deadline are set")
+			{
+				REQUIRE(parsed.sync_opts.retry_delay == 250);
+				REQUIRE(parsed.sync_opts.retry_deadline == 0);
+			}
+
+			THEN("retries are left alone")
+			{
+				REQUIRE(parsed.sync_opts.retries == 3);
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
 	GIVEN("A command line that says 'sync' and specifies getting only.")
 	{
 		constexpr int argc = 3;
@@ -923,6 +1024,84 @@ SCENARIO("The command line parser recognizes when the user wants to sync.")
 			}
 		}
 	}
+
+	GIVEN("A command line that says 'sync' and asks for several accounts at once and prefetching.")
+	{
+		const char* jobs = GENERATE(as<const char*>{}, "-j", "--jobs");
+		std::array<char const*, 14> argv{ "msync", subcommand, jobs, "8", "--per-instance", "3", "--prefetch", "4", "--send-jobs", "5", "--upload-jobs", "2", "--coalesce", "--retry-failed" };
+
+		CAPTURE(argv);
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse((int)argv.size(), argv.data());
+
+			THEN("the selected mode is sync")
+			{
+				REQUIRE(parsed.selected == mode::sync);
+			}
+
+			THEN("the concurrency and prefetch options are set")
+			{
+				REQUIRE(parsed.sync_opts.jobs == 8);
+				REQUIRE(parsed.sync_opts.per_instance == 3);
+				REQUIRE(parsed.sync_opts.prefetch == 4);
+				REQUIRE(parsed.sync_opts.send_jobs == 5);
+				REQUIRE(parsed.sync_opts.upload_jobs == 2);
+			}
+
+			THEN("coalescing is turned on")
+			{
+				REQUIRE(parsed.sync_opts.coalesce);
+			}
+
+			THEN("failed calls are retried right away")
+			{
+				REQUIRE(parsed.sync_opts.retry_failed);
+			}
+
+			THEN("the defaults are set correctly")
+			{
+				REQUIRE(parsed.sync_opts.retries == 3);
+				REQUIRE(parsed.sync_opts.stats == stats_format::off);
+				REQUIRE(parsed.sync_opts.get);
+				REQUIRE(parsed.sync_opts.send);
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
+	GIVEN("A command line that says 'sync' and asks for stats.")
+	{
+		const auto stats = GENERATE(std::make_pair("--stats", stats_format::table), std::make_pair("--stats-json", stats_format::json));
+		std::array<char const*, 3> argv{ "msync", subcommand, stats.first };
+
+		CAPTURE(argv);
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse((int)argv.size(), argv.data());
+
+			THEN("the selected mode is sync")
+			{
+				REQUIRE(parsed.selected == mode::sync);
+			}
+
+			THEN("the stats format is set")
+			{
+				REQUIRE(parsed.sync_opts.stats == stats.second);
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
 }
 
 SCENARIO("The command line parser correctly parses when the user wants to interact with the queue.")
@@ -1009,6 +1188,34 @@ SCENARIO("The command line parser correctly parses when the user wants to intera
 		}
 	}
 
+	GIVEN("A command line that reads more ids from a file.")
+	{
+		const auto opt = GENERATE(as<const char*>{}, "-f", "--from");
+		const auto file = GENERATE(as<const char*>{}, "ids.txt", "-");
+		constexpr int argc = 7;
+		char const* argv[]{ "msync", qcommand, "fav", opt, file, "12345", "6789" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& result = parse(argc, argv);
+
+			THEN("the parse is good.")
+			{
+				REQUIRE(result.okay);
+			}
+
+			THEN("the file is saved.")
+			{
+				REQUIRE(result.queue_opt.id_file == file);
+			}
+
+			THEN("the post IDs on the command line are still parsed.")
+			{
+				REQUIRE(result.queue_opt.queued == std::vector<std::string>{"12345", "6789"});
+			}
+		}
+	}
+
 	GIVEN("A command line that enqueues a post")
 	{
 		constexpr int argc = 4;
@@ -1090,6 +1297,103 @@ SCENARIO("The command line parser correctly parses when the user wants to intera
 
 }
 
+SCENARIO("The command line parser recognizes when the user wants to read downloaded posts.")
+{
+	GIVEN("A command line that says 'show' and an id.")
+	{
+		constexpr int argc = 5;
+		char const* argv[]{ "msync", "show", "123456", "-a", "coolfella" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(argc, argv);
+
+			THEN("the selected mode is show")
+			{
+				REQUIRE(parsed.selected == mode::show);
+			}
+
+			THEN("the id and account are set, and it'll look everywhere")
+			{
+				REQUIRE(parsed.read_opt.id == "123456");
+				REQUIRE(parsed.read_opt.which == timeline::any);
+				REQUIRE(parsed.account == "coolfella");
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
+	GIVEN("A command line that says 'show', an id, and which timeline to look in.")
+	{
+		const auto which = GENERATE(
+			std::make_pair("home", timeline::home),
+			std::make_pair("notifications", timeline::notifications),
+			std::make_pair("bookmarks", timeline::bookmarks));
+
+		char const* argv[]{ "msync", "show", "98765", which.first };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(4, argv);
+
+			THEN("the id and timeline are set")
+			{
+				REQUIRE(parsed.selected == mode::show);
+				REQUIRE(parsed.read_opt.id == "98765");
+				REQUIRE(parsed.read_opt.which == which.second);
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
+	GIVEN("A command line that says 'list', a timeline, and --since.")
+	{
+		constexpr int argc = 5;
+		char const* argv[]{ "msync", "list", "notifications", "--since", "2020-06" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(argc, argv);
+
+			THEN("the selected mode is list")
+			{
+				REQUIRE(parsed.selected == mode::list);
+			}
+
+			THEN("the timeline and date are set")
+			{
+				REQUIRE(parsed.read_opt.which == timeline::notifications);
+				REQUIRE(parsed.read_opt.since == "2020-06");
+			}
+
+			THEN("the parse is good")
+			{
+				REQUIRE(parsed.okay);
+			}
+		}
+	}
+
+	GIVEN("A command line that says 'list' without a timeline.")
+	{
+		constexpr int argc = 2;
+		char const* argv[]{ "msync", "list" };
+
+		WHEN("the command line is parsed")
+		{
+			const auto& parsed = parse(argc, argv);
+
+			THEN("the parse is bad")
+			{
+				REQUIRE_FALSE(parsed.okay);
+			}
+		}
+	}
+}
+
 SCENARIO("The command line parser recognizes when the user requests yeehaw.")
 {
 	GIVEN("A command line requesting yeehaw.")
@@ -0,0 +1,363 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/postlist/post_list.hpp"
+#include "../lib/postlist/post_formats.hpp"
+#include "../lib/entities/entities.hpp"
+
+#include <nlohmann/json.hpp>
+#include <filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+mastodon_status make_formatted_status(int n)
+{
+	mastodon_status status = make_test_status(n, 1000 + n, make_test_date(2020, 6, 1));
+	status.content = "line one\nline \"two\" with a \\ and a\ttab \xF0\x9F\xA4\xA0 and a \x01";
+	status.content_warning = n % 2 == 0 ? "" : "spoilers";
+	status.reply_to_post_id = n % 3 == 0 ? "999" : "";
+	status.favorites = n;
+	status.boosts = 2 * n;
+	status.replies = 3 * n;
+	status.author.is_bot = n % 2 == 1;
+	if (n % 2 == 0)
+	{
+		status.boosted_by = "meatbooster@different.website.egg";
+		status.boosted_by_display_name = "Meat Boosterson";
+		status.boosted_by_bot = true;
+		status.original_post_url = "https://different.website.egg/goodpost";
+		status.original_post_id = "123";
+		status.boosted_at = "2020-06-02T08:00:00.000Z";
+	}
+	if (n % 3 == 1)
+		status.attachments = { { "https://website.egg/a.png", "a description" }, { "https://website.egg/b.mp3", "" } };
+	if (n % 4 == 2)
+	{
+		status.poll = mastodon_poll{};
+		status.poll->id = "poll" + status.id;
+		status.poll->expired = false;
+		status.poll->expires_at = "a future time";
+		status.poll->total_votes = 10;
+		status.poll->you_voted = true;
+		status.poll->voted_for = { 0, 2 };
+		status.poll->options = { { "good things", 4 }, { "bad things", 5 }, { "other", 1 } };
+	}
+	return status;
+}
+
+mastodon_notification make_formatted_notification(int n)
+{
+	mastodon_notification notification;
+	notification.id = std::to_string(50 + n);
+	notification.type = n % 2 == 0 ? notif_type::favorite : notif_type::follow;
+	notification.created_at = "2021-01-01T00:00:00.000Z";
+	notification.account.account_name = "fan@website.egg";
+	notification.account.display_name = "Big Fan";
+	if (n % 2 == 0)
+		notification.status = make_formatted_status(n);
+	return notification;
+}
+
+void require_same_status(const mastodon_status& actual, const mastodon_status& expected)
+{
+	REQUIRE(actual.id == expected.id);
+	REQUIRE(actual.url == expected.url);
+	REQUIRE(actual.content_warning == expected.content_warning);
+	REQUIRE(actual.content == expected.content);
+	REQUIRE(actual.visibility == expected.visibility);
+	REQUIRE(actual.created_at == expected.created_at);
+	REQUIRE(actual.reply_to_post_id == expected.reply_to_post_id);
+	REQUIRE(actual.original_post_url == expected.original_post_url);
+	REQUIRE(actual.boosted_at == expected.boosted_at);
+	REQUIRE(actual.original_post_id == expected.original_post_id);
+	REQUIRE(actual.boosted_by == expected.boosted_by);
+	REQUIRE(actual.boosted_by_display_name == expected.boosted_by_display_name);
+	REQUIRE(actual.boosted_by_bot == expected.boosted_by_bot);
+	REQUIRE(actual.favorites == expected.favorites);
+	REQUIRE(actual.boosts == expected.boosts);
+	REQUIRE(actual.replies == expected.replies);
+	REQUIRE(actual.author.account_name == expected.author.account_name);
+	REQUIRE(actual.author.display_name == expected.author.display_name);
+	REQUIRE(actual.author.is_bot == expected.author.is_bot);
+
+	REQUIRE(actual.attachments.size() == expected.attachments.size());
+	for (size_t i = 0; i < expected.attachments.size(); i++)
+	{
+		REQUIRE(actual.attachments[i].url == expected.attachments[i].url);
+		REQUIRE(actual.attachments[i].description == expected.attachments[i].description);
+	}
+
+	REQUIRE(actual.poll.has_value() == expected.poll.has_value());
+	if (expected.poll.has_value())
+	{
+		REQUIRE(actual.poll->id == expected.poll->id);
+		REQUIRE(actual.poll->expires_at == expected.poll->expires_at);
+		REQUIRE(actual.poll->expired == expected.poll->expired);
+		REQUIRE(actual.poll->total_votes == expected.poll->total_votes);
+		REQUIRE(actual.poll->you_voted == expected.poll->you_voted);
+		REQUIRE(actual.poll->voted_for == expected.poll->voted_for);
+		REQUIRE(actual.poll->options.size() == expected.poll->options.size());
+		for (size_t i = 0; i < expected.poll->options.size(); i++)
+		{
+			REQUIRE(actual.poll->options[i].title == expected.poll->options[i].title);
+			REQUIRE(actual.poll->options[i].votes == expected.poll->options[i].votes);
+		}
+	}
+}
+
+void require_same_status(const nlohmann::json& actual, const mastodon_status& expected)
+{
+	REQUIRE(actual["id"] == expected.id);
+	REQUIRE(actual["url"] == expected.url);
+	REQUIRE(actual["content_warning"] == expected.content_warning);
+	REQUIRE(actual["content"] == expected.content);
+	REQUIRE(actual["visibility"] == expected.visibility);
+	REQUIRE(actual["created_at"] == expected.created_at);
+	REQUIRE(actual["reply_to_post_id"] == expected.reply_to_post_id);
+	REQUIRE(actual["original_post_url"] == expected.original_post_url);
+	REQUIRE(actual["original_post_id"] == expected.original_post_id);
+	REQUIRE(actual["boosted_by"] == expected.boosted_by);
+	REQUIRE(actual["boosted_by_display_name"] == expected.boosted_by_display_name);
+	REQUIRE(actual["boosted_by_bot"] == expected.boosted_by_bot);
+	REQUIRE(actual["boosted_at"] == expected.boosted_at);
+	REQUIRE(actual["favorites"] == expected.favorites);
+	REQUIRE(actual["boosts"] == expected.boosts);
+	REQUIRE(actual["replies"] == expected.replies);
+	REQUIRE(actual["author"]["account_name"] == expected.author.account_name);
+	REQUIRE(actual["author"]["display_name"] == expected.author.display_name);
+	REQUIRE(actual["author"]["is_bot"] == expected.author.is_bot);
+
+	REQUIRE(actual["attachments"].size() == expected.attachments.size());
+	for (size_t i = 0; i < expected.attachments.size(); i++)
+	{
+		REQUIRE(actual["attachments"][i]["url"] == expected.attachments[i].url);
+		REQUIRE(actual["attachments"][i]["description"] == expected.attachments[i].description);
+	}
+
+	if (!expected.poll.has_value())
+	{
+		REQUIRE(actual["poll"].is_null());
+		return;
+	}
+
+	const auto& poll = actual["poll"];
+	REQUIRE(poll["id"] == expected.poll->id);
+	REQUIRE(poll["expires_at"] == expected.poll->expires_at);
+	REQUIRE(poll["expired"] == expected.poll->expired);
+	REQUIRE(poll["total_votes"] == expected.poll->total_votes);
+	REQUIRE(poll["you_voted"] == expected.poll->you_voted);
+	REQUIRE(poll["voted_for"] == expected.poll->voted_for);
+	REQUIRE(poll["options"].size() == expected.poll->options.size());
+	for (size_t i = 0; i < expected.poll->options.size(); i++)
+	{
+		REQUIRE(poll["options"][i]["title"] == expected.poll->options[i].title);
+		REQUIRE(poll["options"][i]["votes"] == expected.poll->options[i].votes);
+	}
+}
+
+SCENARIO("post_list can write statuses as JSON lines.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = list_file_for(dir.dirname / "home.list", list_format::jsonl);
+
+	GIVEN("Some statuses with everything from polls to characters that need escaping")
+	{
+		std::vector<mastodon_status> statuses;
+		for (int i = 0; i < 8; i++)
+			statuses.push_back(make_formatted_status(i));
+
+		WHEN("they're written to a JSON lines post_list, some now and some later")
+		{
+			{
+				post_list<mastodon_status> list{ list_file, true, list_format::jsonl };
+				for (int i = 0; i < 5; i++)
+					list.write(statuses[i]);
+			}
+			{
+				post_list<mastodon_status> list{ list_file, true, list_format::jsonl };
+				for (int i = 5; i < 8; i++)
+					list.write(statuses[i]);
+			}
+
+			THEN("the file is named for the format and isn't indexed.")
+			{
+				REQUIRE(list_file.filename() == "home.jsonl");
+				REQUIRE_FALSE(fs::exists(fs::path(list_file).concat(".idx")));
+			}
+
+			THEN("each line is one status as a JSON object with every field.")
+			{
+				const auto lines = read_lines(list_file);
+				REQUIRE(lines.size() == statuses.size());
+				for (size_t i = 0; i < statuses.size(); i++)
+				{
+					require_same_status(nlohmann::json::parse(lines[i]), statuses[i]);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("post_list can write notifications as JSON lines.")
+{
+	GIVEN("A notification with a status and one without")
+	{
+		std::string out;
+		append_jsonl(out, make_formatted_notification(0));
+		append_jsonl(out, make_formatted_notification(1));
+
+		THEN("each comes out on its own line.")
+		{
+			REQUIRE(std::count(out.begin(), out.end(), '\n') == 2);
+			REQUIRE(out.back() == '\n');
+		}
+
+		THEN("the fields are all there, with the type named like the Mastodon API does.")
+		{
+			std::istringstream lines{ out };
+			std::string line;
+
+			std::getline(lines, line);
+			const auto fav = nlohmann::json::parse(line);
+			REQUIRE(fav["id"] == "50");
+			REQUIRE(fav["type"] == "favourite");
+			REQUIRE(fav["created_at"] == "2021-01-01T00:00:00.000Z");
+			REQUIRE(fav["account"]["account_name"] == "fan@website.egg");
+			REQUIRE(fav["account"]["display_name"] == "Big Fan");
+			REQUIRE(fav["account"]["is_bot"] == false);
+			require_same_status(fav["status"], make_formatted_status(0));
+
+			std::getline(lines, line);
+			const auto follow = nlohmann::json::parse(line);
+			REQUIRE(follow["id"] == "51");
+			REQUIRE(follow["type"] == "follow");
+			REQUIRE(follow["status"].is_null());
+		}
+	}
+}
+
+SCENARIO("post_list can write statuses and notifications as binary records that read back the same.")
+{
+	const test_dir dir = temporary_directory();
+
+	GIVEN("Some statuses written to a binary post_list, some directly and some appended from another list")
+	{
+		const fs::path list_file = list_file_for(dir.dirname / "home.list", list_format::binary);
+		const fs::path segment = dir.dirname / "home.bin.spill0";
+
+		std::vector<mastodon_status> statuses;
+		for (int i = 0; i < 9; i++)
+			statuses.push_back(make_formatted_status(i));
+
+		std::vector<written_post> layout;
+		{
+			post_list<mastodon_status> spilled{ segment, false, list_format::binary };
+			spilled.keep_layout();
+			for (int i = 6; i < 9; i++)
+				spilled.write(statuses[i]);
+			layout = spilled.take_layout();
+		}
+		{
+			post_list<mastodon_status> list{ list_file, true, list_format::binary };
+			for (int i = 0; i < 6; i++)
+				list.write(statuses[i]);
+			list.append(segment, layout);
+		}
+
+		WHEN("the file is read back")
+		{
+			std::ifstream in{ list_file.c_str(), std::ios::binary };
+			std::vector<mastodon_status> read;
+			mastodon_status status;
+			while (read_binary(in, status))
+				read.push_back(std::move(status));
+
+			THEN("every status comes back the way it went in.")
+			{
+				REQUIRE(list_file.filename() == "home.bin");
+				REQUIRE(read.size() == statuses.size());
+				for (size_t i = 0; i < statuses.size(); i++)
+					require_same_status(read[i], statuses[i]);
+			}
+		}
+
+		WHEN("the file is cut off partway through the last record")
+		{
+			fs::resize_file(list_file, fs::file_size(list_file) - 3);
+
+			std::ifstream in{ list_file.c_str(), std::ios::binary };
+			size_t read = 0;
+			mastodon_status status;
+			while (read_binary(in, status))
+				read++;
+
+			THEN("everything before it still reads.")
+			{
+				REQUIRE(read == statuses.size() - 1);
+			}
+		}
+	}
+
+	GIVEN("Notifications written as binary records")
+	{
+		std::string out;
+		for (int i = 0; i < 4; i++)
+			append_binary(out, make_formatted_notification(i));
+
+		WHEN("they're read back")
+		{
+			std::istringstream in{ out };
+			std::vector<mastodon_notification> read;
+			mastodon_notification notification;
+			while (read_binary(in, notification))
+				read.push_back(std::move(notification));
+
+			THEN("they match.")
+			{
+				REQUIRE(read.size() == 4);
+				for (int i = 0; i < 4; i++)
+				{
+					const auto expected = make_formatted_notification(i);
+					REQUIRE(read[i].id == expected.id);
+					REQUIRE(read[i].type == expected.type);
+					REQUIRE(read[i].created_at == expected.created_at);
+					REQUIRE(read[i].account.account_name == expected.account.account_name);
+					REQUIRE(read[i].account.display_name == expected.account.display_name);
+					REQUIRE(read[i].status.has_value() == expected.status.has_value());
+					if (expected.status.has_value())
+						require_same_status(*read[i].status, *expected.status);
+				}
+			}
+		}
+
+		WHEN("they're read as statuses instead")
+		{
+			std::istringstream in{ out };
+			mastodon_status status;
+
+			THEN("they're skipped over.")
+			{
+				REQUIRE_FALSE(read_binary(in, status));
+			}
+		}
+	}
+
+	GIVEN("A record")
+	{
+		std::string out;
+		append_binary(out, make_formatted_status(2));
+
+		THEN("it starts with its length and kind.")
+		{
+			const uint32_t length = static_cast<unsigned char>(out[0]) | (static_cast<unsigned char>(out[1]) << 8) |
+				(static_cast<unsigned char>(out[2]) << 16) | (static_cast<unsigned char>(out[3]) << 24);
+			REQUIRE(length == out.size() - 4);
+			REQUIRE(out[4] == Binary_Status_Record);
+		}
+	}
+}
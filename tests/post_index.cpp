@@ -0,0 +1,450 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/postlist/post_list.hpp"
+#include "../lib/postlist/post_index.hpp"
+#include "../lib/entities/entities.hpp"
+
+#include <filesystem.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+mastodon_status make_indexed_status(int n)
+{
+	mastodon_status status = make_test_status(n, 100 + n * 7, make_test_date(2020, 6, n + 1));
+	status.content += "\nwith a second line";
+	status.favorites = n;
+	if (n % 2 == 1)
+	{
+		status.author.account_name = "afriend";
+		status.author.display_name = "Alex (@ Friendford";
+	}
+	status.author.is_bot = n % 3 == 0;
+	if (n % 4 == 0)
+	{
+		status.boosted_by = "meatbooster@different.website.egg";
+		status.boosted_by_display_name = "Meat Boosterson";
+	}
+	return status;
+}
+
+mastodon_notification make_indexed_notification(int n)
+{
+	mastodon_notification notification;
+	notification.id = std::to_string(5000 + n);
+	notification.type = n % 2 == 0 ? notif_type::favorite : notif_type::follow;
+	notification.created_at = make_test_date(2021, 1, n + 1);
+	notification.account.account_name = "fan" + std::to_string(n) + "@website.egg";
+	notification.account.display_name = "Fan, Number " + std::to_string(n);
+	if (n % 2 == 0)
+		notification.status = make_indexed_status(n);
+	return notification;
+}
+
+template <typename post_type>
+std::string printed(const post_type& post)
+{
+	std::ostringstream out;
+	out << post;
+	return out.str();
+}
+
+template <typename post_type>
+void require_same_entries(post_index& index, const std::vector<post_type>& posts)
+{
+	REQUIRE(index.size() == posts.size());
+	for (size_t i = 0; i < posts.size(); i++)
+	{
+		const index_entry entry = index.at(i);
+		const index_entry expected = make_index_entry(posts[i]);
+		REQUIRE(entry.id == expected.id);
+		REQUIRE(entry.created_at == expected.created_at);
+		REQUIRE(entry.author == expected.author);
+	}
+}
+
+SCENARIO("An indexed post_list can find its posts again without reading the whole list.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "home.list";
+
+	GIVEN("A bunch of statuses written to an indexed post_list")
+	{
+		std::vector<mastodon_status> statuses;
+		for (int i = 0; i < 20; i++)
+			statuses.push_back(make_indexed_status(i));
+
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+
+		THEN("the index sits next to the list.")
+		{
+			REQUIRE(fs::exists(fs::path(list_file).concat(".idx")));
+		}
+
+		WHEN("the index is opened")
+		{
+			post_index index{ list_file };
+
+			THEN("it has an entry for each post, in order.")
+			{
+				require_same_entries(index, statuses);
+			}
+
+			THEN("it covers the whole list.")
+			{
+				REQUIRE(index.covered() == fs::file_size(list_file));
+			}
+
+			THEN("each post can be found by id and read back exactly as it was written.")
+			{
+				for (const auto& status : statuses)
+				{
+					const auto found = index.find(status.id);
+					REQUIRE(found.has_value());
+					REQUIRE(read_post(list_file, *found) == printed(status));
+				}
+			}
+
+			THEN("ids that aren't there aren't found.")
+			{
+				REQUIRE_FALSE(index.find("99").has_value());
+				REQUIRE_FALSE(index.find("101").has_value());
+				REQUIRE_FALSE(index.find("100000").has_value());
+			}
+
+			THEN("since gives back everything from that date on, and a partial date works.")
+			{
+				const auto found = index.since("2020-06-15");
+				REQUIRE(found.size() == 6);
+				REQUIRE(found.front().id == statuses[14].id);
+				REQUIRE(found.back().id == statuses.back().id);
+
+				REQUIRE(index.since("2020-06").size() == statuses.size());
+				REQUIRE(index.since("2020-07").empty());
+			}
+		}
+
+		WHEN("more are written later, a page at a time")
+		{
+			std::vector<mastodon_status> more;
+			for (int i = 20; i < 40; i++)
+				more.push_back(make_indexed_status(i));
+
+			{
+				post_list<mastodon_status> list{ list_file, true };
+				list.write(more.begin(), more.begin() + 10);
+				list.write(more.begin() + 10, more.end());
+			}
+
+			post_index index{ list_file };
+
+			THEN("every post in every page gets its own entry.")
+			{
+				statuses.insert(statuses.end(), more.begin(), more.end());
+				require_same_entries(index, statuses);
+				REQUIRE(index.covered() == fs::file_size(list_file));
+				for (const auto& status : more)
+					REQUIRE(read_post(list_file, *index.find(status.id)) == printed(status));
+			}
+		}
+
+		WHEN("more are written later")
+		{
+			std::vector<mastodon_status> more;
+			for (int i = 20; i < 25; i++)
+				more.push_back(make_indexed_status(i));
+
+			{
+				post_list<mastodon_status> list{ list_file, true };
+				for (const auto& status : more)
+					list.write(status);
+			}
+
+			post_index index{ list_file };
+
+			THEN("the new ones are added to the end of the index.")
+			{
+				statuses.insert(statuses.end(), more.begin(), more.end());
+				require_same_entries(index, statuses);
+				REQUIRE(read_post(list_file, *index.find(more.back().id)) == printed(more.back()));
+			}
+		}
+	}
+}
+
+SCENARIO("post_index catches up with posts that were written without it.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "home.list";
+
+	std::vector<mastodon_status> statuses;
+	for (int i = 0; i < 12; i++)
+		statuses.push_back(make_indexed_status(i));
+
+	GIVEN("A list written by an older msync, with no index")
+	{
+		{
+			post_list<mastodon_status> list{ list_file };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+		REQUIRE_FALSE(fs::exists(fs::path(list_file).concat(".idx")));
+
+		WHEN("an index is opened for it")
+		{
+			post_index index{ list_file };
+
+			THEN("it reads the list and indexes every post in it.")
+			{
+				require_same_entries(index, statuses);
+				REQUIRE(index.covered() == fs::file_size(list_file));
+			}
+
+			THEN("the posts can be read back.")
+			{
+				for (const auto& status : statuses)
+					REQUIRE(read_post(list_file, *index.find(status.id)) == printed(status));
+			}
+		}
+
+		WHEN("an indexed post_list writes more to the end")
+		{
+			const auto extra = make_indexed_status(30);
+			{
+				post_list<mastodon_status> list{ list_file, true };
+				list.write(extra);
+			}
+
+			post_index index{ list_file };
+
+			THEN("both the old and new posts are indexed.")
+			{
+				statuses.push_back(extra);
+				require_same_entries(index, statuses);
+			}
+		}
+	}
+
+	GIVEN("An index that only got partway through its last entry")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+
+		const fs::path index_file = fs::path(list_file).concat(".idx");
+		fs::resize_file(index_file, fs::file_size(index_file) - 10);
+
+		WHEN("it's opened")
+		{
+			post_index index{ list_file };
+
+			THEN("the broken entry is redone from the list.")
+			{
+				require_same_entries(index, statuses);
+			}
+		}
+	}
+
+	GIVEN("An index for a list that was replaced with a shorter one")
+	{
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+
+		fs::remove(list_file);
+		{
+			post_list<mastodon_status> list{ list_file };
+			list.write(statuses[3]);
+		}
+
+		WHEN("it's opened")
+		{
+			post_index index{ list_file };
+
+			THEN("it's rebuilt to match the new list.")
+			{
+				require_same_entries(index, std::vector<mastodon_status>{ statuses[3] });
+			}
+		}
+	}
+}
+
+SCENARIO("post_index still finds things when the ids or dates are out of order.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "bookmarks.list";
+
+	GIVEN("Statuses written newest first, like bookmarks can be")
+	{
+		std::vector<mastodon_status> statuses;
+		for (int i = 15; i >= 0; i--)
+			statuses.push_back(make_indexed_status(i));
+
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			for (const auto& status : statuses)
+				list.write(status);
+		}
+
+		post_index index{ list_file };
+
+		THEN("every one can still be found.")
+		{
+			for (const auto& status : statuses)
+			{
+				const auto found = index.find(status.id);
+				REQUIRE(found.has_value());
+				REQUIRE(read_post(list_file, *found) == printed(status));
+			}
+			REQUIRE_FALSE(index.find("102").has_value());
+		}
+
+		THEN("since still only gives back the ones from that date on, in the order they're in the list.")
+		{
+			const auto found = index.since("2020-06-13");
+			REQUIRE(found.size() == 4);
+			REQUIRE(found.front().id == statuses[0].id);
+			REQUIRE(found.back().id == statuses[3].id);
+		}
+	}
+}
+
+SCENARIO("post_index goes by when a boost was boosted, not when the original was posted.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "home.list";
+
+	GIVEN("A list with boosts of posts from long before they were boosted")
+	{
+		std::vector<mastodon_status> statuses;
+		for (int i = 0; i < 12; i++)
+		{
+			mastodon_status status = make_indexed_status(i);
+			if (!status.boosted_by.empty())
+			{
+				status.boosted_at = status.created_at;
+				status.created_at = "2015-01-01T00:00:00.000Z";
+			}
+			statuses.push_back(std::move(status));
+		}
+
+		{
+			post_list<mastodon_status> list{ list_file, true };
+			list.write(statuses.begin(), statuses.end());
+		}
+
+		WHEN("the index is opened")
+		{
+			post_index index{ list_file };
+
+			THEN("each boost's entry has the date it was boosted.")
+			{
+				require_same_entries(index, statuses);
+				REQUIRE(index.at(8).created_at == statuses[8].boosted_at);
+			}
+
+			THEN("since finds the boosts from that date on.")
+			{
+				const auto found = index.since("2020-06-09");
+				REQUIRE(found.size() == 4);
+				REQUIRE(found.front().id == statuses[8].id);
+				REQUIRE(found.back().id == statuses.back().id);
+			}
+		}
+
+		WHEN("the index is made again from the list")
+		{
+			fs::remove(index_file_for(list_file));
+			post_index index{ list_file };
+
+			THEN("the boosts still have the date they were boosted.")
+			{
+				require_same_entries(index, statuses);
+			}
+		}
+	}
+}
+
+SCENARIO("An indexed post_list indexes notifications and lists it appends.")
+{
+	const test_dir dir = temporary_directory();
+	const fs::path list_file = dir.dirname / "notifications.list";
+	const fs::path segment = dir.dirname / "notifications.list.spill0";
+
+	GIVEN("Some notifications, some written directly and some copied over from another list")
+	{
+		std::vector<mastodon_notification> notifications;
+		for (int i = 0; i < 8; i++)
+			notifications.push_back(make_indexed_notification(i));
+
+		std::vector<written_post> layout;
+		{
+			post_list<mastodon_notification> spilled{ segment };
+			spilled.keep_layout();
+			for (int i = 4; i < 8; i++)
+				spilled.write(notifications[i]);
+			layout = spilled.take_layout();
+		}
+
+		{
+			post_list<mastodon_notification> list{ list_file, true };
+			for (int i = 0; i < 4; i++)
+				list.write(notifications[i]);
+			list.append(segment, layout);
+		}
+
+		WHEN("the index is opened")
+		{
+			post_index index{ list_file };
+
+			THEN("every notification has an entry, including the id, date, and who it's from.")
+			{
+				require_same_entries(index, notifications);
+				REQUIRE(index.covered() == fs::file_size(list_file));
+			}
+
+			THEN("each one reads back the way it was written.")
+			{
+				for (const auto& notification : notifications)
+					REQUIRE(read_post(list_file, *index.find(notification.id)) == printed(notification));
+			}
+		}
+
+		WHEN("the list is indexed from scratch instead")
+		{
+			fs::remove(fs::path(list_file).concat(".idx"));
+			post_index index{ list_file };
+
+			THEN("the entries come out the same.")
+			{
+				require_same_entries(index, notifications);
+			}
+		}
+	}
+}
+
+SCENARIO("id_less sorts numeric ids by value.")
+{
+	THEN("shorter ids come first.")
+	{
+		REQUIRE(id_less("99", "100"));
+		REQUIRE_FALSE(id_less("100", "99"));
+	}
+
+	THEN("ids of the same length sort like text.")
+	{
+		REQUIRE(id_less("103", "110"));
+		REQUIRE_FALSE(id_less("110", "110"));
+	}
+}
@@ -5,7 +5,9 @@
 #include "../lib/postlist/post_list.hpp"
 #include "../lib/entities/entities.hpp"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 #include <array>
 #include <filesystem.hpp>
 #include <string_view>
@@ -346,6 +348,58 @@ SCENARIO("post_list correctly serializes lists of statuses.")
 			}
 		}
 
+		WHEN("one status is written to a post_list, another is written to a second list, and the second is appended to the first.")
+		{
+			const auto& test_post = GENERATE_REF(from_range(statuses));
+			const auto& other_test_post = GENERATE_REF(from_range(statuses));
+
+			const test_file other = temporary_file();
+			std::vector<written_post> layout;
+			{
+				post_list<mastodon_status> list{ other.filename() };
+				list.keep_layout();
+				list.write(other_test_post.status);
+				layout = list.take_layout();
+			}
+			{
+				post_list<mastodon_status> list{ fi.filename() };
+				list.write(test_post.status);
+				list.append(other.filename(), layout);
+			}
+
+			THEN("the generated file is the same as if both were written to it.")
+			{
+				const auto actual = read_file(fi.filename());
+
+				size_t idx = 0;
+				idx = compare_window(test_post.expected, actual, idx);
+				idx = compare_window(other_test_post.expected, actual, idx);
+				REQUIRE(idx == actual.size());
+			}
+		}
+
+		WHEN("every status is written to a post_list at once, like a page from the server")
+		{
+			{
+				std::vector<mastodon_status> page;
+				for (const auto& test_post : statuses)
+					page.push_back(test_post.status);
+
+				post_list<mastodon_status> list{ fi.filename() };
+				list.write(page.begin(), page.end());
+			}
+
+			THEN("the generated file is the same as if they were written one at a time.")
+			{
+				const auto actual = read_file(fi.filename());
+
+				size_t idx = 0;
+				for (const auto& test_post : statuses)
+					idx = compare_window(test_post.expected, actual, idx);
+				REQUIRE(idx == actual.size());
+			}
+		}
+
 		WHEN("two statuses are written to a post_list and destroyed one at a time.")
 		{
 			const auto& test_post = GENERATE_REF(from_range(statuses));
@@ -515,6 +569,31 @@ SCENARIO("post_list correctly serializes lists of notifications.")
 			}
 		}
 
+		WHEN("All the notifications are serialized with post_list at once, backwards")
+		{
+			{
+				std::vector<mastodon_notification> page;
+				for (const auto& test_case : notifs)
+					page.push_back(test_case.notif);
+
+				post_list<mastodon_notification> list{ fi.filename() };
+				list.write(page.rbegin(), page.rend());
+			}
+
+			THEN("They're all written as expected.")
+			{
+				const std::string actual = read_file(fi.filename());
+
+				size_t idx = 0;
+				std::for_each(notifs.rbegin(), notifs.rend(), [&](const auto& test_case)
+				{
+					idx = compare_window(test_case.expected_notif, actual, idx);
+					idx = compare_window(test_case.expected_status, actual, idx);
+				});
+				REQUIRE(idx == actual.size());
+			}
+		}
+
 		WHEN("Two notifications are serialized with post_list destroyed between them")
 		{
 			const auto& test_case = GENERATE_REF(from_range(notifs));
@@ -34,4 +34,37 @@ SCENARIO("The print logger respects the MSYNC_FILE_LOG define.")
 
 		logs_off = true;
 	}
-}
\ No newline at end of file
+}
+SCENARIO("capture_logs holds on to everything logged while it's in scope.")
+{
+	GIVEN("A print logger that's turned on and a capture in place.")
+	{
+		logs_off = false;
+		verbose_logs = false;
+
+		capture_logs capture;
+
+		WHEN("Some messages are logged.")
+		{
+			pl() << "Shown " << 5;
+			plverb() << "Hidden.";
+			plfile() << "File only.";
+
+			THEN("the console part has only what would've been printed.")
+			{
+				REQUIRE(captured_logs->console.str() == "Shown 5");
+			}
+
+			THEN("the file part has everything.")
+			{
+				REQUIRE(captured_logs->file.str() == "Shown 5Hidden.File only.");
+			}
+
+			// don't actually print any of this when the capture ends
+			captured_logs->console.str({});
+			captured_logs->file.str({});
+		}
+
+		logs_off = true;
+	}
+}
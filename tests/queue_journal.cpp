@@ -0,0 +1,177 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/queue/queue_journal.hpp"
+
+#include <filesystem.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+SCENARIO("queue_journals write down each call as it's recorded.")
+{
+	GIVEN("An empty journal")
+	{
+		const test_file tf = temporary_file();
+
+		WHEN("some calls are recorded")
+		{
+			queue_journal journal{ tf.filename() };
+			journal.record(api_call{ api_route::fav, "first" });
+			journal.record(api_call{ api_route::boost, "second", retry_state{ 2, 500, 12345 } });
+
+			THEN("they're on disk right away, without any retry state.")
+			{
+				REQUIRE(read_lines(tf.filename()) == std::vector<std::string>{ "FAV first", "BOOST second" });
+			}
+
+			THEN("the size counts them.")
+			{
+				REQUIRE(journal.size() == 2);
+			}
+
+			AND_WHEN("the journal is opened again and another call is recorded")
+			{
+				{
+					queue_journal reopened{ tf.filename() };
+					reopened.record(api_call{ api_route::post, "third.post" });
+
+					THEN("the size counts the ones that were already there.")
+					{
+						REQUIRE(reopened.size() == 3);
+					}
+				}
+
+				THEN("the new call is added to the end.")
+				{
+					REQUIRE(read_lines(tf.filename()) == std::vector<std::string>{ "FAV first", "BOOST second", "POST third.post" });
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("replay_journal takes calls that were already sent out of a queue.")
+{
+	GIVEN("A queue and a journal with some of its calls in it")
+	{
+		const test_file tf = temporary_file();
+		{
+			queue_journal journal{ tf.filename() };
+			journal.record(api_call{ api_route::fav, "same" });
+			journal.record(api_call{ api_route::boost, "middle" });
+			journal.record(api_call{ api_route::fav, "not in the queue" });
+		}
+
+		std::deque<api_call> queue{
+			api_call{ api_route::fav, "same" },
+			api_call{ api_route::boost, "middle", retry_state{ 1, 503, 100 } },
+			api_call{ api_route::unfav, "same" },
+			api_call{ api_route::fav, "same" },
+			api_call{ api_route::bookmark, "last" },
+		};
+
+		WHEN("the journal is replayed")
+		{
+			const auto replayed = replay_journal(queue, tf.filename());
+
+			THEN("it says how many calls were in the journal.")
+			{
+				REQUIRE(replayed == 3);
+			}
+
+			THEN("only the first matching call for each entry is removed, and everything else stays in order.")
+			{
+				REQUIRE(queue.size() == 3);
+				REQUIRE(queue[0] == api_call{ api_route::unfav, "same" });
+				REQUIRE(queue[1] == api_call{ api_route::fav, "same" });
+				REQUIRE(queue[2] == api_call{ api_route::bookmark, "last" });
+			}
+		}
+	}
+
+	GIVEN("A journal with the same call in it more times than it's in the queue")
+	{
+		const test_file tf = temporary_file();
+		{
+			queue_journal journal{ tf.filename() };
+			journal.record(api_call{ api_route::fav, "twice" });
+			journal.record(api_call{ api_route::fav, "twice" });
+			journal.record(api_call{ api_route::fav, "twice" });
+		}
+
+		std::deque<api_call> queue{
+			api_call{ api_route::fav, "twice" },
+			api_call{ api_route::boost, "twice" },
+			api_call{ api_route::fav, "twice" },
+		};
+
+		WHEN("the journal is replayed")
+		{
+			replay_journal(queue, tf.filename());
+
+			THEN("every matching call is taken out, and nothing else.")
+			{
+				REQUIRE(queue.size() == 1);
+				REQUIRE(queue[0] == api_call{ api_route::boost, "twice" });
+			}
+		}
+	}
+
+	GIVEN("A queue and no journal")
+	{
+		const test_file tf = temporary_file();
+		std::deque<api_call> queue{ api_call{ api_route::fav, "stays" } };
+
+		WHEN("the journal is replayed")
+		{
+			const auto replayed = replay_journal(queue, tf.filename());
+
+			THEN("nothing happens.")
+			{
+				REQUIRE(replayed == 0);
+				REQUIRE(queue.size() == 1);
+			}
+		}
+	}
+}
+
+SCENARIO("compact_journal writes out the queue and removes the journal.")
+{
+	GIVEN("A queue file and a journal")
+	{
+		const test_file queue_file = temporary_file();
+		const test_file journal_file = temporary_file();
+
+		{
+			queue_list queue{ queue_file.filename() };
+			queue.parsed.push_back(api_call{ api_route::fav, "sent" });
+			queue.parsed.push_back(api_call{ api_route::fav, "unsent" });
+		}
+		{
+			queue_journal journal{ journal_file.filename() };
+			journal.record(api_call{ api_route::fav, "sent" });
+		}
+
+		WHEN("the queue is opened, replayed, and compacted")
+		{
+			{
+				queue_list queue{ queue_file.filename() };
+				replay_journal(queue.parsed, journal_file.filename());
+				compact_journal(queue, journal_file.filename());
+			}
+
+			THEN("the queue file only has what wasn't sent.")
+			{
+				REQUIRE(read_lines(queue_file.filename()) == std::vector<std::string>{ "FAV unsent" });
+			}
+
+			THEN("the journal is gone.")
+			{
+				REQUIRE_FALSE(fs::exists(journal_file.filename()));
+			}
+		}
+	}
+}
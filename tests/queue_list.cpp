@@ -278,3 +278,62 @@ SCENARIO("queue_list is a move-only type.")
 	static_assert(std::is_copy_constructible<queue_list>::value == false, "queue_lists should not be copy constructable.");
 	static_assert(std::is_copy_assignable<queue_list>::value == false, "queue_lists should not be copy assignable.");
 }
+
+SCENARIO("queue_lists keep track of how calls that failed have gone.")
+{
+	GIVEN("A queue_list on disk where some calls have failed before.")
+	{
+		const test_file tf = temporary_file();
+
+		{
+			std::ofstream fout(tf);
+			fout << "FAV firstthing\n";
+			fout << "POST a post with spaces\t3 500 1700000000\n";
+			fout << "BOOST thirdthing\tnot retry state\n";
+		}
+
+		WHEN("A queue_list is created")
+		{
+			queue_list testfi(tf.filename());
+
+			THEN("calls without retry state haven't been tried.")
+			{
+				REQUIRE(testfi.parsed.size() == 3);
+				REQUIRE(testfi.parsed[0] == api_call{ api_route::fav, "firstthing" });
+				REQUIRE(testfi.parsed[0].retry.attempts == 0);
+				REQUIRE(testfi.parsed[0].retry.next_attempt == 0);
+			}
+
+			THEN("the retry state is read, and isn't part of the argument.")
+			{
+				REQUIRE(testfi.parsed[1] == api_call{ api_route::post, "a post with spaces" });
+				REQUIRE(testfi.parsed[1].retry.attempts == 3);
+				REQUIRE(testfi.parsed[1].retry.last_status_code == 500);
+				REQUIRE(testfi.parsed[1].retry.next_attempt == 1700000000);
+			}
+
+			THEN("something after a tab that isn't retry state stays in the argument.")
+			{
+				REQUIRE(testfi.parsed[2] == api_call{ api_route::boost, "thirdthing\tnot retry state" });
+				REQUIRE(testfi.parsed[2].retry.attempts == 0);
+			}
+		}
+
+		WHEN("A queue_list is opened and one call fails again")
+		{
+			{
+				queue_list testfi(tf.filename());
+				testfi.parsed[0].retry = retry_state{ 1, 404, 1800000000 };
+			}
+
+			THEN("the retry state is written back out.")
+			{
+				const auto lines = read_lines(tf.filename());
+
+				REQUIRE(lines.size() == 3);
+				REQUIRE(lines[0] == "FAV firstthing\t1 404 1800000000");
+				REQUIRE(lines[1] == "POST a post with spaces\t3 500 1700000000");
+			}
+		}
+	}
+}
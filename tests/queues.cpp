@@ -3,7 +3,9 @@
 #include "test_helpers.hpp"
 #include <filesystem.hpp>
 #include <fstream>
+#include <sstream>
 #include <vector>
+#include <deque>
 #include <string>
 #include <string_view>
 #include <algorithm>
@@ -797,3 +799,163 @@ SCENARIO("Queues refuse to enqueue empty posts and posts that aren't files.")
 		}
 	}
 }
+
+SCENARIO("Queues stay in order and skip duplicates when lots of ids are added and removed at once.")
+{
+	logs_off = true;
+	const test_dir allaccounts = temporary_directory();
+	const fs::path accountdir = allaccounts.dirname / "busybot@typical.egg";
+	fs::create_directory(accountdir);
+
+	const fs::path queue_file = accountdir / Queue_Filename;
+
+	GIVEN("A few thousand ids with some duplicates mixed in")
+	{
+		std::vector<std::string> ids;
+		for (int i = 0; i < 3000; i++)
+			ids.push_back(std::to_string(i));
+		// these are already in there
+		ids.push_back("17");
+		ids.push_back("2999");
+
+		WHEN("they're enqueued as favs twice and as boosts once")
+		{
+			enqueue(api_route::fav, accountdir, ids);
+			enqueue(api_route::fav, accountdir, ids);
+			enqueue(api_route::boost, accountdir, { "17", "17", "fresh" });
+
+			THEN("each one is in the queue once, in the order it was first added.")
+			{
+				const auto lines = read_lines(queue_file);
+				REQUIRE(lines.size() == 3002);
+				for (int i = 0; i < 3000; i++)
+				{
+					REQUIRE(lines[i] == "FAV " + std::to_string(i));
+				}
+				REQUIRE(lines[3000] == "BOOST 17");
+				REQUIRE(lines[3001] == "BOOST fresh");
+			}
+
+			AND_WHEN("every other one is removed, along with some that were never queued")
+			{
+				std::vector<std::string> to_remove;
+				for (int i = 0; i < 3000; i += 2)
+					to_remove.push_back(std::to_string(i));
+				to_remove.push_back("never");
+				to_remove.push_back("4");
+				to_remove.push_back("also never");
+
+				dequeue(api_route::fav, accountdir, to_remove);
+
+				THEN("the rest stay in order, and the ones that weren't there get unfaved at the end, in order.")
+				{
+					const auto lines = read_lines(queue_file);
+					REQUIRE(lines.size() == 1504);
+					for (int i = 0; i < 1500; i++)
+					{
+						REQUIRE(lines[i] == "FAV " + std::to_string(i * 2 + 1));
+					}
+					REQUIRE(lines[1500] == "BOOST 17");
+					REQUIRE(lines[1501] == "BOOST fresh");
+					REQUIRE(lines[1502] == "UNFAV never");
+					REQUIRE(lines[1503] == "UNFAV also never");
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("read_ids reads one id or filename per line.")
+{
+	GIVEN("Some input with blank lines, padding, and Windows line endings")
+	{
+		std::istringstream in{ "12345\n\n   6789  \r\n\t\na file with spaces.post\r\n" };
+		std::vector<std::string> ids{ "from the command line" };
+
+		WHEN("it's read")
+		{
+			read_ids(in, ids);
+
+			THEN("each line is added after what was already there, trimmed, and blank lines are skipped.")
+			{
+				REQUIRE(ids == std::vector<std::string>{ "from the command line", "12345", "6789", "a file with spaces.post" });
+			}
+		}
+	}
+}
+
+SCENARIO("coalesce takes out calls that cancel out or repeat.")
+{
+	GIVEN("A queue with some calls that undo each other, some repeats, and some posts")
+	{
+		std::deque<api_call> calls{
+			api_call{ api_route::fav, "undone" },
+			api_call{ api_route::boost, "kept" },
+			api_call{ api_route::unboost, "reboosted" },
+			api_call{ api_route::post, "first.post" },
+			api_call{ api_route::unfav, "undone" },
+			api_call{ api_route::boost, "kept" },
+			api_call{ api_route::boost, "reboosted" },
+			api_call{ api_route::context, "thread" },
+			api_call{ api_route::post, "first.post" },
+			api_call{ api_route::unpost, "old" },
+			api_call{ api_route::context, "thread" },
+			api_call{ api_route::bookmark, "twice undone" },
+			api_call{ api_route::unbookmark, "twice undone" },
+			api_call{ api_route::unbookmark, "twice undone" },
+			api_call{ api_route::unpost, "old" },
+		};
+
+		WHEN("it's coalesced")
+		{
+			const auto removed = coalesce(calls);
+
+			THEN("the rest are left in order.")
+			{
+				REQUIRE(removed == 6);
+				REQUIRE(calls == std::deque<api_call>{
+					api_call{ api_route::boost, "kept" },
+					api_call{ api_route::unboost, "reboosted" },
+					api_call{ api_route::post, "first.post" },
+					api_call{ api_route::boost, "reboosted" },
+					api_call{ api_route::context, "thread" },
+					api_call{ api_route::post, "first.post" },
+					api_call{ api_route::unpost, "old" },
+					api_call{ api_route::unbookmark, "twice undone" },
+					api_call{ api_route::unpost, "old" },
+				});
+			}
+
+			AND_WHEN("it's coalesced again")
+			{
+				THEN("nothing else is taken out.")
+				{
+					REQUIRE(coalesce(calls) == 0);
+					REQUIRE(calls.size() == 9);
+				}
+			}
+		}
+	}
+
+	GIVEN("A queue where a call is undone and redone several times")
+	{
+		std::deque<api_call> calls{
+			api_call{ api_route::fav, "flip" },
+			api_call{ api_route::unfav, "flip" },
+			api_call{ api_route::fav, "flip" },
+			api_call{ api_route::unfav, "flip" },
+			api_call{ api_route::unfav, "flip" },
+			api_call{ api_route::fav, "flip" },
+		};
+
+		WHEN("it's coalesced")
+		{
+			coalesce(calls);
+
+			THEN("it comes down to an unfav and a fav, same as the last two.")
+			{
+				REQUIRE(calls == std::deque<api_call>{ api_call{ api_route::unfav, "flip" }, api_call{ api_route::fav, "flip" } });
+			}
+		}
+	}
+}
@@ -0,0 +1,292 @@
+#include <catch2/catch.hpp>
+
+#include "test_helpers.hpp"
+
+#include "../lib/sync/rate_limit_pacer.hpp"
+#include "../lib/sync/sync_helpers.hpp"
+
+#include <print_logger.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace std::chrono_literals;
+
+// what Mastodon sends in X-RateLimit-Reset
+std::string make_reset_timestamp(std::chrono::system_clock::time_point when)
+{
+	const std::time_t as_time_t = std::chrono::system_clock::to_time_t(when);
+	std::ostringstream out;
+	out << std::put_time(std::gmtime(&as_time_t), "%Y-%m-%dT%H:%M:%S") << ".000Z";
+	return out.str();
+}
+
+net_response make_limited_response(int limit, int remaining, std::chrono::system_clock::time_point resets)
+{
+	net_response response;
+	response.rate_limit = limit;
+	response.rate_limit_remaining = remaining;
+	response.rate_limit_reset = make_reset_timestamp(resets);
+	return response;
+}
+
+SCENARIO("rate_limit_pacer only slows things down once the rate limit is running low.")
+{
+	const test_file tf = temporary_file();
+	const auto now = std::chrono::system_clock::now();
+
+	GIVEN("A pacer that hasn't heard from the server")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+
+		THEN("nothing waits.")
+		{
+			for (int i = 0; i < 1000; i++)
+			{
+				REQUIRE(pacer.reserve(now) == 0ms);
+			}
+		}
+	}
+
+	GIVEN("A pacer with plenty of requests left")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+		pacer.update(make_limited_response(300, 250, now + 100s), now);
+
+		THEN("the requests above the pacing threshold don't wait.")
+		{
+			for (int i = 0; i < 250 - 300 / Pacing_Starts_Below_Fraction; i++)
+			{
+				REQUIRE(pacer.reserve(now) == 0ms);
+			}
+
+			AND_THEN("the ones after that are spread out over the rest of the window.")
+			{
+				const auto first = pacer.reserve(now);
+				const auto second = pacer.reserve(now);
+				const auto third = pacer.reserve(now);
+				REQUIRE(first == 0ms);
+				REQUIRE(second > 1s);
+				REQUIRE(third > second);
+				REQUIRE((third - second).count() == Approx(second.count()).margin(5));
+			}
+		}
+	}
+
+	GIVEN("A pacer that's been told there's nothing left")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+		pacer.update(make_limited_response(300, 0, now + 100s), now);
+
+		THEN("the next request waits until the limit resets.")
+		{
+			const auto wait = pacer.reserve(now);
+			REQUIRE(wait >= 99s);
+			REQUIRE(wait <= 102s);
+
+			AND_THEN("requests after that go at the usual pace.")
+			{
+				REQUIRE(pacer.reserve(now + 102s) == 0ms);
+			}
+		}
+
+		WHEN("two requests are made before it resets")
+		{
+			const auto first = pacer.reserve(now);
+			const auto second = pacer.reserve(now + 1s);
+
+			THEN("they both wait until the limit resets.")
+			{
+				REQUIRE(first >= 99s);
+				REQUIRE(first <= 102s);
+				REQUIRE(second >= 98s);
+				REQUIRE(second <= 101s);
+				REQUIRE(now + first == now + 1s + second);
+			}
+		}
+	}
+
+	GIVEN("A pacer that had two requests wait for the limit to reset, then made another one after it did")
+	{
+		{
+			rate_limit_pacer pacer{ tf.filename() };
+			pacer.update(make_limited_response(300, 0, now + 100s), now);
+			pacer.reserve(now);
+			pacer.reserve(now + 1s);
+			pacer.reserve(now + 102s);
+		}
+
+		THEN("all three are counted against the new window.")
+		{
+			const option_file saved{ tf.filename() };
+			REQUIRE(saved.parsed.at("remaining") == "297");
+		}
+	}
+
+	GIVEN("A pacer that got a 429")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+		pacer.update(make_limited_response(300, 100, now + 100s), now);
+
+		net_response limited;
+		limited.status_code = 429;
+		limited.okay = false;
+		limited.retryable_error = true;
+		limited.message = make_reset_timestamp(now + 50s);
+		pacer.update(limited, now);
+
+		THEN("the next request waits until the limit resets.")
+		{
+			const auto wait = pacer.reserve(now);
+			REQUIRE(wait >= 49s);
+			REQUIRE(wait <= 52s);
+		}
+	}
+
+	GIVEN("A pacer that's running low")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+		pacer.update(make_limited_response(300, 10, now + 100s), now);
+
+		WHEN("a response that was in flight says there's more left than that")
+		{
+			pacer.update(make_limited_response(300, 200, now + 100s), now);
+
+			THEN("it still goes by the lower number.")
+			{
+				pacer.reserve(now);
+				REQUIRE(pacer.reserve(now) > 1s);
+			}
+		}
+
+		WHEN("a response says the window reset")
+		{
+			pacer.update(make_limited_response(300, 299, now + 400s), now + 101s);
+
+			THEN("it goes by the new window.")
+			{
+				REQUIRE(pacer.reserve(now + 101s) == 0ms);
+				REQUIRE(pacer.reserve(now + 101s) == 0ms);
+			}
+		}
+	}
+}
+
+SCENARIO("rate_limit_pacer remembers the rate limit between syncs.")
+{
+	const test_file tf = temporary_file();
+	const auto now = std::chrono::system_clock::now();
+
+	GIVEN("A pacer that's out of requests")
+	{
+		{
+			rate_limit_pacer pacer{ tf.filename() };
+			pacer.update(make_limited_response(300, 0, now + 100s), now);
+		}
+
+		WHEN("it's opened again")
+		{
+			rate_limit_pacer pacer{ tf.filename() };
+
+			THEN("it still waits for the limit to reset.")
+			{
+				REQUIRE(pacer.reserve(now) >= 99s);
+			}
+		}
+
+		WHEN("it's opened again after the limit reset")
+		{
+			rate_limit_pacer pacer{ tf.filename() };
+
+			THEN("nothing waits.")
+			{
+				REQUIRE(pacer.reserve(now + 102s) == 0ms);
+			}
+		}
+	}
+}
+
+SCENARIO("request_with_retries tells the current pacer about each response.")
+{
+	logs_off = true;
+	const test_file tf = temporary_file();
+	const auto now = std::chrono::system_clock::now();
+
+	GIVEN("A pacer for this thread and a server that says it's out of requests")
+	{
+		rate_limit_pacer pacer{ tf.filename() };
+		const pacing_scope pacing{ &pacer };
+
+		WHEN("a request is made")
+		{
+			const auto response = request_with_retries([&]() { return make_limited_response(300, 0, now + 100s); }, 3, pl());
+
+			THEN("the request went through.")
+			{
+				REQUIRE(response.success);
+			}
+
+			THEN("the pacer knows to wait for the reset.")
+			{
+				REQUIRE(pacer.reserve(now) >= 99s);
+			}
+		}
+	}
+
+	GIVEN("No pacer")
+	{
+		THEN("current_pacer is null.")
+		{
+			REQUIRE(current_pacer == nullptr);
+		}
+	}
+}
+
+SCENARIO("request_with_retries throws instead of waiting out a 429 when the rate limit can be deferred.")
+{
+	logs_off = true;
+	const auto now = std::chrono::system_clock::now();
+
+	GIVEN("A server that's rate limiting")
+	{
+		net_response limited;
+		limited.status_code = 429;
+		limited.okay = false;
+		limited.retryable_error = true;
+		limited.message = make_reset_timestamp(now + 600s);
+
+		WHEN("a request is made and deferring is allowed")
+		{
+			const deferral_scope deferring{ true };
+
+			THEN("rate_limit_deferred is thrown with the reset time.")
+			{
+				try
+				{
+					request_with_retries([&]() { return limited; }, 3, pl());
+					FAIL("Should have thrown.");
+				}
+				catch (const rate_limit_deferred& deferred)
+				{
+					REQUIRE(deferred.resets_at >= now + 599s);
+					REQUIRE(deferred.resets_at <= now + 602s);
+				}
+			}
+		}
+
+		WHEN("the scope ends")
+		{
+			{
+				const deferral_scope deferring{ true };
+			}
+
+			THEN("deferring is turned back off.")
+			{
+				REQUIRE_FALSE(defer_rate_limits);
+			}
+		}
+	}
+}
@@ -4,6 +4,8 @@
 #include "../lib/entities/entities.hpp"
 #include "../util/util.hpp"
 
+#include <msync_exception.hpp>
+
 #include "read_response_json.hpp"
 
 #include <utility>
@@ -62,6 +64,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.original_post_url.empty());
 				REQUIRE(status.original_post_id.empty());
 				REQUIRE(status.boosted_by.empty());
+				REQUIRE(status.boosted_at.empty());
 				REQUIRE(status.favorites == 1);
 				REQUIRE(status.boosts == 3);
 				REQUIRE(status.replies == 2);
@@ -103,6 +106,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.boosted_by == "BestGirlGrace");
 				REQUIRE(status.boosted_by_bot == false);
 				REQUIRE(status.boosted_by_display_name == "Secret Government Grace :qvp:");
+				REQUIRE(status.boosted_at == "2019-11-15T02:13:01.819Z");
 				REQUIRE(status.favorites == 0);
 				REQUIRE(status.boosts == 11);
 				REQUIRE(status.replies == 1);
@@ -144,6 +148,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.original_post_url.empty());
 				REQUIRE(status.original_post_id.empty());
 				REQUIRE(status.boosted_by.empty());
+				REQUIRE(status.boosted_at.empty());
 				REQUIRE(status.favorites == 2);
 				REQUIRE(status.boosts == 3);
 				REQUIRE(status.replies == 4);
@@ -190,6 +195,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.original_post_url.empty());
 				REQUIRE(status.original_post_id.empty());
 				REQUIRE(status.boosted_by.empty());
+				REQUIRE(status.boosted_at.empty());
 				REQUIRE(status.favorites == 2);
 				REQUIRE(status.boosts == 3);
 				REQUIRE(status.replies == 4);
@@ -236,6 +242,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.original_post_url.empty());
 				REQUIRE(status.original_post_id.empty());
 				REQUIRE(status.boosted_by.empty());
+				REQUIRE(status.boosted_at.empty());
 				REQUIRE(status.favorites == 2);
 				REQUIRE(status.boosts == 3);
 				REQUIRE(status.replies == 4);
@@ -281,6 +288,7 @@ SCENARIO("read_status correctly reads and cleans the relevant fields from a JSON
 				REQUIRE(status.original_post_url.empty());
 				REQUIRE(status.original_post_id.empty());
 				REQUIRE(status.boosted_by.empty());
+				REQUIRE(status.boosted_at.empty());
 				REQUIRE(status.favorites == 0);
 				REQUIRE(status.boosts == 0);
 				REQUIRE(status.replies == 0);
@@ -376,6 +384,132 @@ SCENARIO("read_statuses correctly reads and cleans the relevant fields from an a
 
 }
 
+SCENARIO("read_statuses only reads the parts of an account that the projection asks for.")
+{
+	GIVEN("The array of statuses from the last test and the projection post_list uses.")
+	{
+		static constexpr std::string_view statuses_json = statuses_array_json;
+		static constexpr account_projection names_only{ false, false, false, false, false };
+
+		WHEN("the string is parsed both with and without the projection")
+		{
+			const auto full = read_statuses(statuses_json);
+			const auto projected = read_statuses(statuses_json, names_only);
+
+			THEN("the projected accounts only have their names and bot flags.")
+			{
+				REQUIRE(projected.size() == full.size());
+				for (size_t i = 0; i < projected.size(); i++)
+				{
+					const auto& author = projected[i].author;
+					REQUIRE(author.account_name == full[i].author.account_name);
+					REQUIRE(author.display_name == full[i].author.display_name);
+					REQUIRE(author.is_bot == full[i].author.is_bot);
+					REQUIRE(author.id.empty());
+					REQUIRE(author.note.empty());
+					REQUIRE(author.url.empty());
+					REQUIRE(author.avatar.empty());
+					REQUIRE(author.fields.empty());
+				}
+			}
+
+			THEN("everything outside the accounts is the same.")
+			{
+				for (size_t i = 0; i < projected.size(); i++)
+				{
+					REQUIRE(projected[i].id == full[i].id);
+					REQUIRE(projected[i].url == full[i].url);
+					REQUIRE(projected[i].content == full[i].content);
+					REQUIRE(projected[i].content_warning == full[i].content_warning);
+					REQUIRE(projected[i].boosted_by == full[i].boosted_by);
+					REQUIRE(projected[i].created_at == full[i].created_at);
+					REQUIRE(projected[i].attachments.size() == full[i].attachments.size());
+					REQUIRE(projected[i].favorites == full[i].favorites);
+				}
+			}
+		}
+
+		WHEN("the string is parsed with a projection that only leaves out some things")
+		{
+			static constexpr account_projection id_and_fields{ true, false, false, false, true };
+			const auto full = read_statuses(statuses_json);
+			const auto projected = read_statuses(statuses_json, id_and_fields);
+
+			THEN("the parts that were asked for are still read.")
+			{
+				REQUIRE(projected.size() == full.size());
+				for (size_t i = 0; i < projected.size(); i++)
+				{
+					REQUIRE(projected[i].author.id == full[i].author.id);
+					REQUIRE(projected[i].author.fields == full[i].author.fields);
+					REQUIRE(projected[i].author.note.empty());
+					REQUIRE(projected[i].author.avatar.empty());
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("read_notifications reads notifications and the statuses attached to them.")
+{
+	GIVEN("An array with a mention and a follow notification.")
+	{
+		static constexpr std::string_view notifications_json = R"([{"id":"3","type":"mention","created_at":"2019-11-15T21:20:09.004Z","account":{"id":"5","acct":"someone","display_name":"<b>Someone</b>","bot":false},"status":{"id":"9","uri":"https://website.egg/statuses/9","url":"https://website.egg/@someone/9","created_at":"2019-11-15T21:20:09.004Z","in_reply_to_id":"8","spoiler_text":"","visibility":"direct","content":"<p>hi &amp; bye</p>","favourites_count":0,"reblogs_count":0,"replies_count":0,"media_attachments":[],"mentions":[],"account":{"id":"5","acct":"someone","display_name":"Someone","bot":false},"reblog":null,"poll":null}},{"id":"2","type":"follow","created_at":"2019-11-15T21:20:09.004Z","account":{"id":"6","acct":"another","display_name":"Another","bot":true},"status":null}])";
+
+		WHEN("the string is parsed")
+		{
+			const auto notifications = read_notifications(notifications_json);
+
+			THEN("both notifications are read with the right types.")
+			{
+				REQUIRE(notifications.size() == 2);
+
+				REQUIRE(notifications[0].id == "3");
+				REQUIRE(notifications[0].type == notif_type::mention);
+				REQUIRE(notifications[0].account.account_name == "someone");
+				REQUIRE(notifications[0].status.has_value());
+				REQUIRE(notifications[0].status->id == "9");
+				REQUIRE(notifications[0].status->reply_to_post_id == "8");
+				REQUIRE(notifications[0].status->visibility == "direct");
+				REQUIRE(notifications[0].status->content == "hi & bye");
+
+				REQUIRE(notifications[1].id == "2");
+				REQUIRE(notifications[1].type == notif_type::follow);
+				REQUIRE(notifications[1].account.account_name == "another");
+				REQUIRE(notifications[1].account.is_bot);
+				REQUIRE_FALSE(notifications[1].status.has_value());
+			}
+		}
+	}
+}
+
+SCENARIO("The readers reject JSON that isn't shaped like what they expect.")
+{
+	GIVEN("A response that isn't a list of statuses.")
+	{
+		const auto bad_json = GENERATE(as<std::string_view>{},
+			R"({"error":"Record not found"})",
+			R"("just a string")",
+			R"([{"id":"1"}, 5])");
+
+		WHEN("it is read as a list of statuses")
+		{
+			THEN("an msync_exception is thrown.")
+			{
+				REQUIRE_THROWS_AS(read_statuses(bad_json), msync_exception);
+			}
+		}
+
+		WHEN("it is read as a single notification")
+		{
+			THEN("an msync_exception is thrown.")
+			{
+				REQUIRE_THROWS_AS(read_notification(bad_json), msync_exception);
+			}
+		}
+	}
+}
+
 void assert_context_author(const mastodon_account& author)
 {
 	REQUIRE(author.id == "1");
@@ -465,6 +599,51 @@ SCENARIO("read_context correctly deserializes a context object.")
 	}
 }
 
+SCENARIO("read_page_summary counts a page and finds the ids on either end of it.")
+{
+	GIVEN("An array of statuses.")
+	{
+		WHEN("the summary is read")
+		{
+			const auto summary = read_page_summary(statuses_array_json);
+
+			THEN("it matches what reading the whole page would give.")
+			{
+				const auto statuses = read_statuses(statuses_array_json);
+				REQUIRE(summary.count == statuses.size());
+				REQUIRE(summary.first_id == statuses.front().id);
+				REQUIRE(summary.last_id == statuses.back().id);
+			}
+		}
+	}
+
+	GIVEN("An empty array.")
+	{
+		WHEN("the summary is read")
+		{
+			const auto summary = read_page_summary("[]");
+
+			THEN("it's empty.")
+			{
+				REQUIRE(summary.count == 0);
+				REQUIRE(summary.first_id.empty());
+				REQUIRE(summary.last_id.empty());
+			}
+		}
+	}
+
+	GIVEN("Something that isn't an array.")
+	{
+		WHEN("the summary is read")
+		{
+			THEN("an msync_exception is thrown.")
+			{
+				REQUIRE_THROWS_AS(read_page_summary(R"({"error":"Record not found"})"), msync_exception);
+			}
+		}
+	}
+}
+
 SCENARIO("read_upload_id correctly reads the ID from a JSON status.")
 {
 	GIVEN("A json string with the relevant fields.")
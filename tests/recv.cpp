@@ -3,6 +3,13 @@
 
 #include "../lib/sync/recv.hpp"
 #include "../lib/options/global_options.hpp"
+#include "../lib/sync/sync_stats.hpp"
+#include "../lib/postlist/post_formats.hpp"
+#include "../lib/postlist/post_index.hpp"
+#include "../lib/postlist/list_segments.hpp"
+#include "../lib/postlist/list_compression.hpp"
+
+#include <nlohmann/json.hpp>
 
 #include "test_helpers.hpp"
 #include "mock_network.hpp"
@@ -19,6 +26,8 @@
 #include <iomanip>
 #include <chrono>
 #include <sstream>
+#include <cstring>
+#include <fstream>
 
 using namespace std::string_view_literals;
 
@@ -356,6 +365,372 @@ SCENARIO("Recv downloads and writes the correct number of posts.")
 		}
 	}
 
+	GIVEN("A user account that's synced before and a server that rate limits partway through the home timeline, oldest first.")
+	{
+		recv_posts{ mock_get }.get(account.second);
+		const auto last_seen = lowest_post_id + mock_get.total_post_count;
+		mock_get.total_post_count += 100;
+		mock_get.arguments.clear();
+
+		// notifications, then the first page of home, then rate limited
+		unsigned int calls = 0;
+		auto limited_get = [&](std::string_view url, std::string_view access_token, const timeline_params& params, unsigned int limit)
+		{
+			auto response = mock_get(url, access_token, params, limit);
+			if (++calls == 3)
+			{
+				response.okay = false;
+				response.retryable_error = true;
+				response.status_code = 429;
+				response.message = "2000-01-01T00:00:00.000Z";
+			}
+			return response;
+		};
+
+		const unsigned int prefetch = GENERATE(0u, 2u);
+
+		WHEN("recv is told to update with deferring allowed")
+		{
+			recv_posts post_getter{ limited_get };
+			post_getter.prefetch = prefetch;
+
+			{
+				const deferral_scope deferring{ true };
+				REQUIRE_THROWS_AS(post_getter.get(account.second), rate_limit_deferred);
+			}
+
+			THEN("the last home id is as far as it got.")
+			{
+				REQUIRE(mock_get.arguments.size() >= 3);
+				REQUIRE(mock_get.arguments[1].min_id == std::to_string(last_seen));
+				REQUIRE(account.second.get_option(user_option::last_home_id) == mock_get.arguments[2].min_id);
+			}
+
+			AND_WHEN("it's told to update again after the limit resets")
+			{
+				post_getter.get(account.second);
+
+				THEN("the home timeline has everything exactly once.")
+				{
+					// same as the flaky oldest first test, the mock's ranges skip an id at each page boundary
+					verify_file(home_timeline_file, 40 * 5 + 100 - 1 - 2, "status id: ");
+				}
+
+				THEN("the last home id is the newest post.")
+				{
+					std::array<char, 10> id_char_buf;
+					REQUIRE(account.second.get_option(user_option::last_home_id) == sv_to_chars(lowest_post_id + mock_get.total_post_count, id_char_buf));
+				}
+			}
+		}
+	}
+
+	GIVEN("A user account with no previously stored information and recv set to prefetch pages.")
+	{
+		const unsigned int prefetch = GENERATE(1u, 2u, 8u);
+
+		WHEN("That account is given to recv and told to update.")
+		{
+			recv_posts post_getter{ mock_get };
+			post_getter.prefetch = prefetch;
+
+			post_getter.get(account.second);
+
+			THEN("The same five calls each were made to the home, notification, and bookmark API endpoints, in order.")
+			{
+				const auto& args = mock_get.arguments;
+				REQUIRE(args.size() == 15);
+				REQUIRE(std::all_of(args.begin(), args.begin() + 5, [&](const get_mock_args& arg) { return arg.url == expected_notification_endpoint && arg.limit == 30; }));
+				REQUIRE(std::all_of(args.begin() + 5, args.begin() + 10, [&](const get_mock_args& arg) { return arg.url == expected_home_endpoint && arg.limit == 40; }));
+				REQUIRE(std::all_of(args.begin() + 10, args.end(), [&](const get_mock_args& arg) { return arg.url == expected_bookmark_endpoint && arg.limit == 40; }));
+
+				// each page picks up where the last one left off
+				REQUIRE(args[0].max_id.empty());
+				REQUIRE(args[1].max_id == std::to_string(lowest_notif_id + mock_get.total_notif_count - 30 + 1));
+				REQUIRE(args[6].max_id == std::to_string(lowest_post_id + mock_get.total_post_count - 40 + 1));
+			}
+
+			THEN("All three files have the expected number of posts, and the IDs are strictly increasing.")
+			{
+				verify_file(home_timeline_file, 40 * 5, "status id: ");
+				verify_file(notifications_file, 30 * 5, "notification id: ");
+				verify_file(bookmarks_file, 40 * 5, "status id: ");
+			}
+
+			THEN("The correct last IDs are saved back to the account.")
+			{
+				std::array<char, 10> id_char_buf;
+
+				REQUIRE(account.second.get_option(user_option::last_home_id) == sv_to_chars(lowest_post_id + mock_get.total_post_count, id_char_buf));
+				REQUIRE(account.second.get_option(user_option::last_notification_id) == sv_to_chars(lowest_notif_id + mock_get.total_notif_count, id_char_buf));
+				REQUIRE(account.second.get_option(user_option::last_bookmark_id) == sv_to_chars(lowest_bookmark_id + mock_get.total_bookmark_count, id_char_buf));
+			}
+
+			AND_WHEN("A lot more posts are added and get is called again on a flaky connection, oldest first.")
+			{
+				mock_get.arguments.clear();
+				mock_get.total_post_count += 100;
+				mock_get.total_notif_count += 15;
+				mock_get.total_bookmark_count += 5;
+
+				mock_get.set_succeed_after(2);
+
+				post_getter.get(account.second);
+
+				THEN("Every page was requested twice and the home timeline took several pages.")
+				{
+					const auto& args = mock_get.arguments;
+					// one page of notifications, three of home, one of bookmarks, each tried twice
+					REQUIRE(args.size() == 10);
+					const auto last_seen = lowest_post_id + mock_get.total_post_count - 100;
+					REQUIRE(args[2].min_id == std::to_string(last_seen));
+					REQUIRE(args[4].min_id == std::to_string(last_seen + 41));
+					REQUIRE(args[6].min_id == std::to_string(last_seen + 82));
+				}
+
+				THEN("All three files have the expected number of posts, and the IDs are strictly increasing.")
+				{
+					// same as the other tests, but the mock's ranges also skip an id at each of the two page boundaries
+					verify_file(home_timeline_file, 40 * 5 + 100 - 1 - 2, "status id: ");
+					verify_file(notifications_file, 30 * 5 + 15 - 1, "notification id: ");
+					verify_file(bookmarks_file, 40 * 5 + 5 - 1, "status id: ");
+				}
+
+				THEN("The correct last IDs are saved back to the account.")
+				{
+					std::array<char, 10> id_char_buf;
+
+					REQUIRE(account.second.get_option(user_option::last_home_id) == sv_to_chars(lowest_post_id + mock_get.total_post_count, id_char_buf));
+					REQUIRE(account.second.get_option(user_option::last_notification_id) == sv_to_chars(lowest_notif_id + mock_get.total_notif_count, id_char_buf));
+					REQUIRE(account.second.get_option(user_option::last_bookmark_id) == sv_to_chars(lowest_bookmark_id + mock_get.total_bookmark_count, id_char_buf));
+				}
+			}
+
+			AND_WHEN("get is called again and the server fails.")
+			{
+				mock_get.arguments.clear();
+				mock_get.total_post_count += 100;
+				mock_get.fatal_error = true;
+
+				post_getter.get(account.second);
+
+				THEN("Only one call was made to each endpoint.")
+				{
+					REQUIRE(mock_get.arguments.size() == 3);
+				}
+
+				THEN("Nothing new was written.")
+				{
+					verify_file(home_timeline_file, 40 * 5, "status id: ");
+				}
+			}
+		}
+	}
+
+	GIVEN("A user account with no previously stored information and recv set to only hold a few posts in memory.")
+	{
+		const unsigned int max_buffered = GENERATE(1u, 40u, 75u);
+		const unsigned int prefetch = GENERATE(0u, 2u);
+
+		WHEN("That account is given to recv and told to update.")
+		{
+			recv_posts post_getter{ mock_get };
+			post_getter.max_buffered_posts = max_buffered;
+			post_getter.prefetch = prefetch;
+
+			post_getter.get(account.second);
+
+			THEN("All three files have the expected number of posts, and the IDs are strictly increasing.")
+			{
+				verify_file(home_timeline_file, 40 * 5, "status id: ");
+				verify_file(notifications_file, 30 * 5, "notification id: ");
+				verify_file(bookmarks_file, 40 * 5, "status id: ");
+			}
+
+			THEN("The correct last IDs are saved back to the account.")
+			{
+				std::array<char, 10> id_char_buf;
+
+				REQUIRE(account.second.get_option(user_option::last_home_id) == sv_to_chars(lowest_post_id + mock_get.total_post_count, id_char_buf));
+				REQUIRE(account.second.get_option(user_option::last_notification_id) == sv_to_chars(lowest_notif_id + mock_get.total_notif_count, id_char_buf));
+				REQUIRE(account.second.get_option(user_option::last_bookmark_id) == sv_to_chars(lowest_bookmark_id + mock_get.total_bookmark_count, id_char_buf));
+			}
+
+			THEN("No temporary files are left behind.")
+			{
+				for (const auto& file : fs::directory_iterator(user_dir))
+				{
+					REQUIRE_FALSE(file.path().extension().string().find(".spill") == 0);
+				}
+			}
+		}
+	}
+
+	GIVEN("A user account with no previously stored information that wants its lists as JSON lines or binary.")
+	{
+		const list_format format = GENERATE(list_format::jsonl, list_format::binary);
+		const unsigned int max_buffered = GENERATE(1u, 1000u);
+		account.second.set_option(user_option::list_format, format);
+
+		WHEN("That account is given to recv and told to update.")
+		{
+			recv_posts post_getter{ mock_get };
+			post_getter.max_buffered_posts = max_buffered;
+
+			post_getter.get(account.second);
+
+			THEN("The lists are written in that format instead of as text, with every post in order.")
+			{
+				REQUIRE_FALSE(fs::exists(home_timeline_file));
+				REQUIRE_FALSE(fs::exists(notifications_file));
+
+				const fs::path home_file = list_file_for(home_timeline_file, format);
+				const fs::path notif_file = list_file_for(notifications_file, format);
+				REQUIRE(fs::exists(home_file));
+				REQUIRE(fs::exists(notif_file));
+
+				std::vector<std::string> home_ids;
+				std::vector<std::string> notif_ids;
+				if (format == list_format::jsonl)
+				{
+					for (const auto& line : read_lines(home_file))
+						home_ids.push_back(nlohmann::json::parse(line)["id"]);
+					for (const auto& line : read_lines(notif_file))
+						notif_ids.push_back(nlohmann::json::parse(line)["id"]);
+				}
+				else
+				{
+					std::ifstream home_in{ home_file.c_str(), std::ios::binary };
+					mastodon_status status;
+					while (read_binary(home_in, status))
+						home_ids.push_back(status.id);
+
+					std::ifstream notif_in{ notif_file.c_str(), std::ios::binary };
+					mastodon_notification notification;
+					while (read_binary(notif_in, notification))
+						notif_ids.push_back(notification.id);
+				}
+
+				REQUIRE(home_ids.size() == 40 * 5);
+				REQUIRE(notif_ids.size() == 30 * 5);
+				REQUIRE(std::is_sorted(home_ids.begin(), home_ids.end(), id_less));
+				REQUIRE(std::is_sorted(notif_ids.begin(), notif_ids.end(), id_less));
+			}
+		}
+	}
+
+	GIVEN("A user account with no previously stored information that splits its lists up by size.")
+	{
+		const unsigned int max_buffered = GENERATE(1u, 1000u);
+		account.second.set_option(user_option::list_segments, list_segments::size);
+
+		WHEN("That account is given to recv and told to update.")
+		{
+			recv_posts post_getter{ mock_get };
+			post_getter.max_buffered_posts = max_buffered;
+			post_getter.segment_bytes = 16 * 1024;
+
+			post_getter.get(account.second);
+
+			THEN("The home timeline and notifications are split up, and all the posts are in their segments, in order.")
+			{
+				for (const auto& [list_file, expected_count, prefix] : { std::make_tuple(home_timeline_file, 40 * 5, "status id: "), std::make_tuple(notifications_file, 30 * 5, "notification id: ") })
+				{
+					const auto segments = read_segments(list_file);
+					REQUIRE(segments.size() > 1);
+					REQUIRE(fs::exists(manifest_for(list_file)));
+
+					std::vector<std::string> texts;
+					for (const fs::path& segment : segments)
+						texts.push_back(read_segment(segment));
+
+					// only the last one isn't full yet
+					REQUIRE(std::all_of(texts.begin(), texts.end() - 1, [&](const std::string& text) { return text.size() >= post_getter.segment_bytes; }));
+
+					// and only the last one is left uncompressed
+					if (can_compress())
+					{
+						REQUIRE(std::none_of(segments.begin(), segments.end() - 1, [](const fs::path& segment) { return fs::exists(segment); }));
+						REQUIRE(std::all_of(segments.begin(), segments.end() - 1, [](const fs::path& segment) { return fs::exists(compressed_file_for(segment)); }));
+					}
+					REQUIRE(fs::exists(segments.back()));
+
+					size_t total = 0;
+					for (size_t i = 0; i < segments.size(); i++)
+						total += post_index{ segments[i], texts[i] }.size();
+					REQUIRE(total == static_cast<size_t>(expected_count));
+
+					std::vector<std::string> ids;
+					for (const std::string& text : texts)
+					{
+						std::istringstream lines{ text };
+						std::string line;
+						while (std::getline(lines, line))
+						{
+							if (line.compare(0, std::strlen(prefix), prefix) == 0)
+								ids.push_back(line.substr(std::strlen(prefix)));
+						}
+					}
+					REQUIRE(ids.size() == static_cast<size_t>(expected_count));
+					REQUIRE(std::is_sorted(ids.begin(), ids.end(), id_less));
+				}
+			}
+
+			THEN("Bookmarks aren't split up.")
+			{
+				REQUIRE_FALSE(fs::exists(manifest_for(bookmarks_file)));
+				verify_file(bookmarks_file, 40 * 5, "status id: ");
+			}
+		}
+	}
+
+	GIVEN("A user account with no previously stored information and recv set to collect stats.")
+	{
+		const unsigned int prefetch = GENERATE(0u, 2u);
+
+		WHEN("That account is given to recv and told to update.")
+		{
+			stats_report report;
+
+			recv_posts post_getter{ mock_get };
+			post_getter.prefetch = prefetch;
+			post_getter.stats = &report;
+
+			post_getter.get(account.second);
+
+			std::ostringstream printed;
+			report.print(printed, stats_format::json);
+			const auto sections = nlohmann::json::parse(printed.str())["sections"];
+
+			THEN("there's a section for each timeline with the requests and posts counted.")
+			{
+				REQUIRE(sections.size() == 3);
+				REQUIRE(sections[0]["section"] == "notifications");
+				REQUIRE(sections[1]["section"] == "home");
+				REQUIRE(sections[2]["section"] == "bookmarks");
+
+				for (const auto& section : sections)
+				{
+					REQUIRE(section["account"] == account_name);
+					REQUIRE(section["requests"] == 5);
+					REQUIRE(section["bytes_downloaded"] > 0);
+					REQUIRE(section["phase_ms"]["parse"] > 0);
+					REQUIRE(section["phase_ms"]["file_write"] > 0);
+				}
+
+				REQUIRE(sections[0]["posts"] == 30 * 5);
+				REQUIRE(sections[1]["posts"] == 40 * 5);
+				REQUIRE(sections[2]["posts"] == 40 * 5);
+			}
+
+			THEN("the files are written just like without stats.")
+			{
+				verify_file(home_timeline_file, 40 * 5, "status id: ");
+				verify_file(notifications_file, 30 * 5, "notification id: ");
+			}
+		}
+	}
+
 	GIVEN("A user account that excludes some notification types.")
 	{
 		account.second.set_bool_option(user_option::exclude_boosts, true);
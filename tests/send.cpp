@@ -17,7 +17,11 @@
 #include <utility>
 #include <algorithm>
 #include <initializer_list>
+#include <mutex>
+#include <chrono>
+#include <thread>
 #include <print_logger.hpp>
+#include <msync_exception.hpp>
 
 struct id_mock_args : public basic_mock_args
 {
@@ -1073,6 +1077,564 @@ SCENARIO("Send correctly sends from and modifies a queue of mixed API calls.")
 	}
 }
 
+SCENARIO("Send can send several queued calls at once without reordering the ones that depend on each other.")
+{
+	logs_off = true;
+
+	const test_dir dir = temporary_directory();
+	const fs::path account = dir.dirname / "inahurry@website.egg";
+	fs::create_directories(account / File_Queue_Directory);
+	constexpr std::string_view instanceurl = "website.egg";
+	constexpr std::string_view accesstoken = "quicktoken";
+
+	GIVEN("A queue with a reply chain, several calls on the same statuses, and some calls that will fail")
+	{
+		const std::array<test_file, 3> post_files{ "thread start", "thread reply", "unrelated" };
+		{
+			outgoing_post start{ post_files[0].filename() };
+			start.parsed.text = "start";
+			start.parsed.reply_id = "start";
+
+			outgoing_post reply{ post_files[1].filename() };
+			reply.parsed.text = "reply";
+			reply.parsed.reply_to_id = "start";
+
+			outgoing_post unrelated{ post_files[2].filename() };
+			unrelated.parsed.text = "unrelated";
+		}
+
+		enqueue(api_route::fav, account, { "1", "2", "3" });
+		enqueue(api_route::post, account, { "thread start", "thread reply", "unrelated" });
+		enqueue(api_route::boost, account, { "2", "4", "5" });
+		enqueue(api_route::bookmark, account, { "3", "6", "1" });
+
+		WHEN("the queue is sent with more than one job")
+		{
+			mock_network_post mockpost;
+			mock_network_delete mockdel;
+			mock_network_new_status mocknew;
+			mock_network_upload mockupload;
+			mock_network_context_get mockget;
+
+			// the mocks aren't thread safe, so only let one call into them at a time
+			std::mutex lock;
+			auto post = [&](std::string_view url, std::string_view access_token)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				auto response = mockpost(url, access_token);
+				if (url.find("/3/") != std::string_view::npos || url.find("/4/") != std::string_view::npos)
+				{
+					response.okay = false;
+					response.status_code = 500;
+				}
+				return response;
+			};
+			auto del = [&](std::string_view url, std::string_view access_token)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				return mockdel(url, access_token);
+			};
+			auto new_status = [&](std::string_view url, std::string_view access_token, const status_params& params)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				return mocknew(url, access_token, params);
+			};
+			auto upload = [&](std::string_view url, std::string_view access_token, const fs::path& file, const std::string& description)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				return mockupload(url, access_token, file, description);
+			};
+			auto get = [&](std::string_view url, std::string_view access_token, const timeline_params& params, unsigned int limit)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				return mockget(url, access_token, params, limit);
+			};
+
+			auto send = send_posts{ post, del, new_status, upload, get };
+			send.retries = 1;
+			send.jobs = GENERATE(2u, 4u, 20u);
+
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("only the failed calls are left in the queue, in the order they were queued.")
+			{
+				REQUIRE(print(account) == std::vector<std::string>{ "FAV 3", "BOOST 4", "BOOKMARK 3" });
+			}
+
+			THEN("every call was made once.")
+			{
+				REQUIRE(mockpost.arguments.size() == 9);
+				REQUIRE(mocknew.arguments.size() == 3);
+				REQUIRE(mockdel.arguments.empty());
+				REQUIRE(mockupload.arguments.empty());
+				REQUIRE(mockget.arguments.empty());
+			}
+
+			THEN("calls on the same status were made in the order they were queued.")
+			{
+				const auto position = [&](std::string_view id, std::string_view route)
+				{
+					const auto expected = make_expected_url(id, route, instanceurl);
+					const auto found = std::find_if(mockpost.arguments.begin(), mockpost.arguments.end(), [&](const auto& arg) { return arg.url == expected; });
+					REQUIRE(found != mockpost.arguments.end());
+					return found - mockpost.arguments.begin();
+				};
+
+				REQUIRE(position("1", "/favourite") < position("1", "/bookmark"));
+				REQUIRE(position("2", "/favourite") < position("2", "/reblog"));
+				REQUIRE(position("3", "/favourite") < position("3", "/bookmark"));
+			}
+
+			THEN("the reply was sent after the post it replies to, and replies to its real ID.")
+			{
+				const auto start = std::find_if(mocknew.arguments.begin(), mocknew.arguments.end(), [](const auto& arg) { return arg.params.body == "start"; });
+				const auto reply = std::find_if(mocknew.arguments.begin(), mocknew.arguments.end(), [](const auto& arg) { return arg.params.body == "reply"; });
+				REQUIRE(start != mocknew.arguments.end());
+				REQUIRE(reply != mocknew.arguments.end());
+				REQUIRE(start < reply);
+				REQUIRE(reply->params.reply_to == start->id);
+			}
+		}
+	}
+}
+
+SCENARIO("Send can upload a post's attachments at the same time and still attach them in order.")
+{
+	logs_off = true;
+
+	const test_dir dir = temporary_directory();
+	const fs::path account = dir.dirname / "photographer@website.egg";
+	fs::create_directories(account / File_Queue_Directory);
+	constexpr std::string_view instanceurl = "website.egg";
+	constexpr std::string_view accesstoken = "cameratoken";
+
+	GIVEN("A post with four attachments")
+	{
+		const test_file post_file{ "lots of pictures" };
+		const std::array<touch_file, 4> attachment_files{ "big.png", "bigger.png", "biggest.png", "small.png" };
+		const std::vector<fs::path> expected_attach{ fs::canonical("big.png"), fs::canonical("bigger.png"), fs::canonical("biggest.png"), fs::canonical("small.png") };
+		for (const auto& file : attachment_files)
+		{
+			// give each one something different in it so they're not all the same upload
+			std::ofstream of{ file.filename.c_str() };
+			of << file.filename.filename();
+		}
+		{
+			outgoing_post post{ post_file.filename() };
+			post.parsed.text = "look at all these";
+			post.parsed.attachments = { "big.png", "bigger.png", "biggest.png", "small.png" };
+		}
+
+		enqueue(api_route::post, account, { "lots of pictures" });
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		const unsigned int upload_jobs = GENERATE(2u, 4u);
+		std::string fail_upload;
+
+		// the mock isn't thread safe, so only let one call into it at a time, but make the earlier attachments take longer
+		// so they finish out of order
+		std::mutex lock;
+		auto upload = [&](std::string_view url, std::string_view access_token, const fs::path& file, const std::string& description)
+		{
+			const auto position = std::find(expected_attach.begin(), expected_attach.end(), file) - expected_attach.begin();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5 * (expected_attach.size() - position)));
+
+			const std::lock_guard<std::mutex> guard(lock);
+			auto response = mockupload(url, access_token, file, description);
+			if (file.filename() == fail_upload)
+			{
+				response.okay = false;
+				response.status_code = 500;
+			}
+			return response;
+		};
+
+		auto send = send_posts{ mockpost, mockdel, mocknew, upload, mockget };
+		send.retries = 1;
+		send.upload_jobs = upload_jobs;
+
+		WHEN("the post is sent and every upload succeeds")
+		{
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the post was sent and the queue is empty.")
+			{
+				REQUIRE(mocknew.arguments.size() == 1);
+				REQUIRE(print(account).empty());
+			}
+
+			THEN("every attachment was uploaded once.")
+			{
+				REQUIRE(mockupload.arguments.size() == 4);
+			}
+
+			THEN("the attachment IDs are in the same order as the attachments.")
+			{
+				std::vector<std::string> expected_ids;
+				for (const auto& file : expected_attach)
+				{
+					const auto uploaded = std::find_if(mockupload.arguments.begin(), mockupload.arguments.end(), [&](const auto& arg) { return arg.attachment_args.file == file; });
+					REQUIRE(uploaded != mockupload.arguments.end());
+					expected_ids.push_back(uploaded->id);
+				}
+
+				REQUIRE(mocknew.arguments[0].params.attachment_ids == expected_ids);
+			}
+		}
+
+		WHEN("the post is sent and one upload fails")
+		{
+			fail_upload = "biggest.png";
+
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the post wasn't sent and is still in the queue.")
+			{
+				REQUIRE(mocknew.arguments.empty());
+				REQUIRE(print(account) == std::vector<std::string>{ "POST lots of pictures" });
+			}
+		}
+
+		WHEN("the post fails after its attachments were uploaded, then is sent again")
+		{
+			mocknew.fatal_error = true;
+			mocknew.status_code = 500;
+			send.send(account, instanceurl, accesstoken);
+
+			const auto first_uploads = mockupload.arguments;
+
+			// pretend it's been long enough to try again
+			{
+				auto queued = get(account);
+				REQUIRE(queued.parsed.size() == 1);
+				queued.parsed.front().retry.next_attempt = 0;
+			}
+
+			mocknew.fatal_error = false;
+			mocknew.status_code = 200;
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the attachments weren't uploaded again.")
+			{
+				REQUIRE(first_uploads.size() == 4);
+				REQUIRE(mockupload.arguments.size() == 4);
+			}
+
+			THEN("the post went through with the media from the first try, in order.")
+			{
+				REQUIRE(mocknew.arguments.size() == 2);
+				REQUIRE(print(account).empty());
+
+				std::vector<std::string> expected_ids;
+				for (const auto& file : expected_attach)
+				{
+					const auto uploaded = std::find_if(first_uploads.begin(), first_uploads.end(), [&](const auto& arg) { return arg.attachment_args.file == file; });
+					REQUIRE(uploaded != first_uploads.end());
+					expected_ids.push_back(uploaded->id);
+				}
+
+				REQUIRE(mocknew.arguments[1].params.attachment_ids == expected_ids);
+			}
+
+			THEN("the media the post used isn't in the cache anymore.")
+			{
+				media_cache cache{ account / Media_Cache_Filename };
+				for (const auto& file : attachment_files)
+				{
+					REQUIRE(cache.find(media_cache::key_for(file.filename, "")).empty());
+				}
+			}
+		}
+
+		WHEN("the post fails after its attachments were uploaded, and the server won't take those uploads when it's sent again")
+		{
+			mocknew.fatal_error = true;
+			mocknew.status_code = 500;
+			send.send(account, instanceurl, accesstoken);
+
+			std::vector<std::string> stale_ids;
+			for (const auto& arg : mockupload.arguments)
+				stale_ids.push_back(arg.id);
+
+			{
+				auto queued = get(account);
+				REQUIRE(queued.parsed.size() == 1);
+				queued.parsed.front().retry.next_attempt = 0;
+			}
+
+			// like the server had thrown away the media from the first try
+			const bool fix_it = GENERATE(true, false);
+			auto new_status = [&](std::string_view url, std::string_view access_token, const status_params& params)
+			{
+				const bool stale = std::any_of(params.attachment_ids.begin(), params.attachment_ids.end(), [&](const std::string& id) { return std::find(stale_ids.begin(), stale_ids.end(), id) != stale_ids.end(); });
+				mocknew.fatal_error = stale || !fix_it;
+				mocknew.status_code = mocknew.fatal_error ? 422 : 200;
+				return mocknew(url, access_token, params);
+			};
+
+			auto resend = send_posts{ mockpost, mockdel, new_status, upload, mockget };
+			resend.retries = 1;
+			resend.upload_jobs = upload_jobs;
+			resend.send(account, instanceurl, accesstoken);
+
+			THEN("the attachments were uploaded again.")
+			{
+				REQUIRE(mockupload.arguments.size() == 8);
+			}
+
+			THEN("nothing that was uploaded is still in the cache.")
+			{
+				media_cache cache{ account / Media_Cache_Filename };
+				for (const auto& file : attachment_files)
+				{
+					REQUIRE(cache.find(media_cache::key_for(file.filename, "")).empty());
+				}
+			}
+
+			if (fix_it)
+			{
+				THEN("the post went through with the new uploads.")
+				{
+					REQUIRE(mocknew.arguments.size() == 3);
+					REQUIRE(print(account).empty());
+					for (const auto& id : mocknew.arguments.back().params.attachment_ids)
+						REQUIRE(std::find(stale_ids.begin(), stale_ids.end(), id) == stale_ids.end());
+				}
+			}
+			else
+			{
+				THEN("the post was tried once with the old uploads and once with the new ones before giving up on it.")
+				{
+					REQUIRE(mocknew.arguments.size() == 3);
+					REQUIRE(print(account).empty());
+
+					readonly_queue_list dead{ account / Dead_Letter_Filename };
+					REQUIRE(dead.parsed.size() == 1);
+					REQUIRE(dead.parsed[0].retry.last_status_code == 422);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Send waits longer each time a call fails and gives up on calls that will never work.")
+{
+	logs_off = true;
+
+	const test_dir dir = temporary_directory();
+	const fs::path account = dir.dirname / "unlucky@website.egg";
+	fs::create_directories(account / File_Queue_Directory);
+	constexpr std::string_view instanceurl = "website.egg";
+	constexpr std::string_view accesstoken = "unluckytoken";
+
+	GIVEN("A queue where one call will get a 404, one will get a 500, and the rest will work")
+	{
+		enqueue(api_route::fav, account, { "deleted", "overloaded", "fine" });
+		enqueue(api_route::boost, account, { "overloaded", "alsofine" });
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		auto post = [&](std::string_view url, std::string_view access_token)
+		{
+			auto response = mockpost(url, access_token);
+			if (url.find("/deleted/") != std::string_view::npos)
+			{
+				response.okay = false;
+				response.status_code = 404;
+			}
+			else if (url.find("/overloaded/favourite") != std::string_view::npos)
+			{
+				response.okay = false;
+				response.status_code = 500;
+			}
+			return response;
+		};
+
+		auto send = send_posts{ post, mockdel, mocknew, mockupload, mockget };
+		send.retries = 1;
+
+		WHEN("the queue is sent")
+		{
+			const auto before = seconds_since_epoch();
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the call that can't work was moved to the dead letter file with its status code.")
+			{
+				readonly_queue_list dead{ account / Dead_Letter_Filename };
+				REQUIRE(dead.parsed.size() == 1);
+				REQUIRE(dead.parsed[0] == api_call{ api_route::fav, "deleted" });
+				REQUIRE(dead.parsed[0].retry.attempts == 1);
+				REQUIRE(dead.parsed[0].retry.last_status_code == 404);
+			}
+
+			THEN("the call that might work later is still queued and won't be tried for a while.")
+			{
+				REQUIRE(print(account) == std::vector<std::string>{ "FAV overloaded" });
+
+				const auto queued = get(account);
+				const auto& retry = queued.parsed[0].retry;
+				REQUIRE(retry.attempts == 1);
+				REQUIRE(retry.last_status_code == 500);
+				REQUIRE(retry.next_attempt >= before + retry_delay(1).count());
+			}
+
+			AND_WHEN("another call on the same status is queued and the queue is sent again right away")
+			{
+				enqueue(api_route::bookmark, account, { "overloaded", "stillfine" });
+
+				const auto calls_before = mockpost.arguments.size();
+				send.send(account, instanceurl, accesstoken);
+
+				THEN("neither the call that failed nor the one that has to come after it is tried yet, but the other one is.")
+				{
+					REQUIRE(mockpost.arguments.size() == calls_before + 1);
+					REQUIRE(mockpost.arguments.back().url == make_expected_url("stillfine", "/bookmark", instanceurl));
+					REQUIRE(print(account) == std::vector<std::string>{ "FAV overloaded", "BOOKMARK overloaded" });
+					REQUIRE(get(account).parsed[0].retry.attempts == 1);
+					REQUIRE(get(account).parsed[1].retry.attempts == 0);
+				}
+			}
+
+			AND_WHEN("the queue is sent again after waiting long enough")
+			{
+				{
+					auto queued = get(account);
+					queued.parsed[0].retry.next_attempt = 0;
+				}
+
+				const auto calls_before = mockpost.arguments.size();
+				const auto again = seconds_since_epoch();
+				send.send(account, instanceurl, accesstoken);
+
+				THEN("it's tried again, and it waits longer next time.")
+				{
+					REQUIRE(mockpost.arguments.size() == calls_before + 1);
+
+					const auto queued = get(account);
+					const auto& retry = queued.parsed[0].retry;
+					REQUIRE(retry.attempts == 2);
+					REQUIRE(retry.next_attempt >= again + retry_delay(2).count());
+				}
+			}
+
+			AND_WHEN("it's sent again right away, told to retry what failed")
+			{
+				send.retry_failed = true;
+				const auto calls_before = mockpost.arguments.size();
+				send.send(account, instanceurl, accesstoken);
+
+				THEN("both the call that was waiting and the one that was given up on are tried again right away.")
+				{
+					REQUIRE(mockpost.arguments.size() == calls_before + 2);
+				}
+
+				THEN("they fail the same way again, and the one that can't work goes back in the dead letter file.")
+				{
+					REQUIRE(print(account) == std::vector<std::string>{ "FAV overloaded" });
+					REQUIRE(get(account).parsed[0].retry.attempts == 1);
+
+					readonly_queue_list dead{ account / Dead_Letter_Filename };
+					REQUIRE(dead.parsed.size() == 1);
+					REQUIRE(dead.parsed[0].retry.attempts == 1);
+				}
+			}
+		}
+	}
+
+	GIVEN("A queue where a call gets no response at all, like when msync is offline")
+	{
+		enqueue(api_route::fav, account, { "unreachable" });
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		bool offline = true;
+		auto post = [&](std::string_view url, std::string_view access_token)
+		{
+			auto response = mockpost(url, access_token);
+			if (offline)
+			{
+				response.okay = false;
+				response.status_code = 0;
+			}
+			return response;
+		};
+
+		auto send = send_posts{ post, mockdel, mocknew, mockupload, mockget };
+		send.retries = 1;
+
+		WHEN("the queue is sent, then sent again once msync is back online")
+		{
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the call is still queued without any wait.")
+			{
+				REQUIRE(print(account) == std::vector<std::string>{ "FAV unreachable" });
+				REQUIRE(get(account).parsed[0].retry.next_attempt == 0);
+			}
+
+			offline = false;
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("it goes through the second time.")
+			{
+				REQUIRE(mockpost.arguments.size() == 2);
+				REQUIRE(print(account).empty());
+			}
+		}
+	}
+}
+
+SCENARIO("Only client errors that trying again won't fix are permanent, and the wait between tries grows up to a limit.")
+{
+	GIVEN("Some status codes")
+	{
+		THEN("client errors about the call itself are permanent.")
+		{
+			REQUIRE(permanent_failure(400));
+			REQUIRE(permanent_failure(404));
+			REQUIRE(permanent_failure(410));
+			REQUIRE(permanent_failure(422));
+		}
+
+		THEN("errors about the account, timing, or the server aren't.")
+		{
+			REQUIRE_FALSE(permanent_failure(0));
+			REQUIRE_FALSE(permanent_failure(200));
+			REQUIRE_FALSE(permanent_failure(401));
+			REQUIRE_FALSE(permanent_failure(403));
+			REQUIRE_FALSE(permanent_failure(408));
+			REQUIRE_FALSE(permanent_failure(429));
+			REQUIRE_FALSE(permanent_failure(500));
+			REQUIRE_FALSE(permanent_failure(503));
+		}
+	}
+
+	GIVEN("Some numbers of attempts")
+	{
+		THEN("the wait doubles each time, up to a day.")
+		{
+			REQUIRE(retry_delay(1) == std::chrono::minutes(5));
+			REQUIRE(retry_delay(2) == std::chrono::minutes(10));
+			REQUIRE(retry_delay(3) == std::chrono::minutes(20));
+			REQUIRE(retry_delay(10) == std::chrono::hours(24));
+			REQUIRE(retry_delay(1000) == std::chrono::hours(24));
+		}
+	}
+}
+
 SCENARIO("read_params doesn't repeat idempotency keys or mutate the post file.")
 {
 	const test_file fi = temporary_file();
@@ -1118,3 +1680,175 @@ SCENARIO("read_params doesn't repeat idempotency keys or mutate the post file.")
 	}
 }
 
+SCENARIO("Send doesn't send calls again after being stopped partway through a queue.")
+{
+	logs_off = true;
+
+	const test_dir dir = temporary_directory();
+	const fs::path account = dir.dirname / "interrupted@website.egg";
+	fs::create_directory(account);
+	constexpr std::string_view instanceurl = "website.egg";
+	constexpr std::string_view accesstoken = "interruptedtoken";
+
+	GIVEN("A queue of favs where msync gets stopped on the third one")
+	{
+		enqueue(api_route::fav, account, { "first", "second", "third", "fourth" });
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		bool stop = true;
+		auto post = [&](std::string_view url, std::string_view access_token)
+		{
+			if (stop && url.find("/third/") != std::string_view::npos)
+				throw msync_exception("stopped");
+			return mockpost(url, access_token);
+		};
+
+		auto send = send_posts{ post, mockdel, mocknew, mockupload, mockget };
+
+		WHEN("the queue is sent and stopped partway")
+		{
+			REQUIRE_THROWS_WITH(send.send(account, instanceurl, accesstoken), "stopped");
+
+			THEN("the calls that went through are in the journal.")
+			{
+				REQUIRE(read_lines(account / Queue_Journal_Filename) == std::vector<std::string>{ "FAV first", "FAV second" });
+			}
+
+			THEN("the queue doesn't show them anymore.")
+			{
+				REQUIRE(print(account) == std::vector<std::string>{ "FAV third", "FAV fourth" });
+			}
+
+			AND_WHEN("the queue is sent again")
+			{
+				stop = false;
+				send.send(account, instanceurl, accesstoken);
+
+				THEN("only the calls that hadn't gone through were sent.")
+				{
+					REQUIRE(mockpost.arguments.size() == 4);
+					REQUIRE(mockpost.arguments[2].url == make_expected_url("third", "/favourite", instanceurl));
+					REQUIRE(mockpost.arguments[3].url == make_expected_url("fourth", "/favourite", instanceurl));
+				}
+
+				THEN("the queue and the journal are both cleaned up.")
+				{
+					REQUIRE(read_file(account / Queue_Filename).empty());
+					REQUIRE_FALSE(fs::exists(account / Queue_Journal_Filename));
+				}
+			}
+		}
+	}
+
+	GIVEN("A queue where some calls are waiting on an earlier failure")
+	{
+		enqueue(api_route::fav, account, { "waiting", "goes through" });
+		{
+			auto queued = get(account);
+			queued.parsed[0].retry = retry_state{ 1, 500, seconds_since_epoch() + 3600 };
+		}
+		const auto queue_before = read_file(account / Queue_Filename);
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		auto send = send_posts{ mockpost, mockdel, mocknew, mockupload, mockget };
+
+		WHEN("the queue is sent and only the other call goes through")
+		{
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the queue file isn't rewritten, the journal says what went through instead.")
+			{
+				REQUIRE(read_file(account / Queue_Filename) == queue_before);
+				REQUIRE(read_lines(account / Queue_Journal_Filename) == std::vector<std::string>{ "FAV goes through" });
+			}
+
+			THEN("the queue only has the waiting call in it.")
+			{
+				REQUIRE(print(account) == std::vector<std::string>{ "FAV waiting" });
+			}
+
+			AND_WHEN("the queue is opened to be changed")
+			{
+				enqueue(api_route::boost, account, { "another" });
+
+				THEN("the journal is folded back into the queue file.")
+				{
+					REQUIRE_FALSE(fs::exists(account / Queue_Journal_Filename));
+					const auto lines = read_lines(account / Queue_Filename);
+					REQUIRE(lines.size() == 2);
+					REQUIRE(lines[0].rfind("FAV waiting\t", 0) == 0);
+					REQUIRE(lines[1] == "BOOST another");
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Send can skip queued calls that cancel each other out.")
+{
+	logs_off = true;
+
+	const test_dir dir = temporary_directory();
+	const fs::path account = dir.dirname / "indecisive@website.egg";
+	fs::create_directory(account);
+	constexpr std::string_view instanceurl = "website.egg";
+	constexpr std::string_view accesstoken = "indecisivetoken";
+
+	GIVEN("A queue with a fav that's undone later, a repeated unboost, and a reboost")
+	{
+		{
+			auto queued = get(account);
+			queued.parsed = {
+				api_call{ api_route::fav, "changed my mind" },
+				api_call{ api_route::unboost, "reboost" },
+				api_call{ api_route::unfav, "changed my mind" },
+				api_call{ api_route::unboost, "reboost" },
+				api_call{ api_route::boost, "reboost" },
+			};
+		}
+
+		mock_network_post mockpost;
+		mock_network_delete mockdel;
+		mock_network_new_status mocknew;
+		mock_network_upload mockupload;
+		mock_network_context_get mockget;
+
+		auto send = send_posts{ mockpost, mockdel, mocknew, mockupload, mockget };
+		const bool coalesce = GENERATE(true, false);
+		send.coalesce_calls = coalesce;
+
+		WHEN("the queue is sent")
+		{
+			send.send(account, instanceurl, accesstoken);
+
+			THEN("the queue is empty either way.")
+			{
+				REQUIRE(print(account).empty());
+			}
+
+			THEN("only the calls that are needed are made if coalescing is on.")
+			{
+				if (coalesce)
+				{
+					REQUIRE(mockpost.arguments.size() == 2);
+					REQUIRE(mockpost.arguments[0].url == make_expected_url("reboost", "/unreblog", instanceurl));
+					REQUIRE(mockpost.arguments[1].url == make_expected_url("reboost", "/reblog", instanceurl));
+				}
+				else
+				{
+					REQUIRE(mockpost.arguments.size() == 5);
+				}
+			}
+		}
+	}
+}
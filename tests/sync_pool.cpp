@@ -0,0 +1,252 @@
+#include <catch2/catch.hpp>
+
+#include "../lib/sync/sync_pool.hpp"
+
+#include <msync_exception.hpp>
+#include <print_logger.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+struct fake_account
+{
+	std::string name;
+	std::string instance;
+};
+
+std::vector<fake_account> make_fake_accounts(size_t count)
+{
+	static constexpr const char* instances[] = { "https://crime.egg", "https://website.egg", "https://princess.software" };
+
+	std::vector<fake_account> toreturn;
+	for (size_t i = 0; i < count; i++)
+		toreturn.push_back(fake_account{ "account" + std::to_string(i), instances[i % 3] });
+	return toreturn;
+}
+
+const std::string& instance_of(const fake_account& account)
+{
+	return account.instance;
+}
+
+SCENARIO("sync_accounts syncs every account exactly once.")
+{
+	logs_off = true;
+
+	GIVEN("A bunch of accounts spread across a few instances.")
+	{
+		const auto accounts = make_fake_accounts(GENERATE(1, 2, 7, 20));
+		const auto jobs = GENERATE(0u, 1u, 2u, 4u, 32u);
+		const auto per_instance = GENERATE(0u, 1u, 3u);
+
+		std::mutex lock;
+		std::map<std::string, int> synced;
+
+		WHEN("they're synced")
+		{
+			sync_accounts(accounts, pool_limits{ jobs, per_instance }, instance_of, [&](const fake_account& account)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				synced[account.name]++;
+			});
+
+			THEN("each one was synced once.")
+			{
+				REQUIRE(synced.size() == accounts.size());
+				REQUIRE(std::all_of(synced.begin(), synced.end(), [](const auto& pair) { return pair.second == 1; }));
+			}
+		}
+	}
+}
+
+SCENARIO("sync_accounts never has more than the allowed number of accounts on an instance going at once.")
+{
+	logs_off = true;
+
+	GIVEN("More accounts and jobs than the per-instance limit.")
+	{
+		const auto accounts = make_fake_accounts(18);
+		const auto per_instance = GENERATE(1u, 2u);
+
+		std::mutex lock;
+		std::map<std::string, unsigned int> running;
+		std::map<std::string, unsigned int> most_running;
+
+		WHEN("they're synced")
+		{
+			sync_accounts(accounts, pool_limits{ 8, per_instance }, instance_of, [&](const fake_account& account)
+			{
+				{
+					const std::lock_guard<std::mutex> guard(lock);
+					auto& count = running[account.instance];
+					count++;
+					most_running[account.instance] = std::max(most_running[account.instance], count);
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+				const std::lock_guard<std::mutex> guard(lock);
+				running[account.instance]--;
+			});
+
+			THEN("the limit was respected on every instance.")
+			{
+				REQUIRE(most_running.size() == 3);
+				for (const auto& instance : most_running)
+				{
+					REQUIRE(instance.second <= per_instance);
+				}
+			}
+
+			THEN("nothing is still running.")
+			{
+				REQUIRE(std::all_of(running.begin(), running.end(), [](const auto& pair) { return pair.second == 0; }));
+			}
+		}
+	}
+}
+
+SCENARIO("sync_accounts keeps going when one account fails and reports the first failure.")
+{
+	logs_off = true;
+
+	GIVEN("A set of accounts where a couple throw.")
+	{
+		const auto accounts = make_fake_accounts(10);
+		const auto jobs = GENERATE(2u, 4u, 10u);
+
+		std::mutex lock;
+		std::vector<std::string> synced;
+
+		WHEN("they're synced")
+		{
+			const auto sync = [&]()
+			{
+				sync_accounts(accounts, pool_limits{ jobs, 2 }, instance_of, [&](const fake_account& account)
+				{
+					if (account.name == "account3" || account.name == "account7")
+						throw msync_exception(account.name);
+
+					const std::lock_guard<std::mutex> guard(lock);
+					synced.push_back(account.name);
+				});
+			};
+
+			THEN("the exception for the first failing account is thrown.")
+			{
+				REQUIRE_THROWS_WITH(sync(), "account3");
+
+				AND_THEN("every other account was still synced.")
+				{
+					REQUIRE(synced.size() == 8);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("sync_accounts captures each account's logs while it runs concurrently.")
+{
+	GIVEN("A few accounts and more than one job.")
+	{
+		const auto accounts = make_fake_accounts(6);
+
+		std::mutex lock;
+		bool all_captured = true;
+
+		WHEN("they're synced")
+		{
+			sync_accounts(accounts, pool_limits{ 3, 2 }, instance_of, [&](const fake_account&)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				all_captured = all_captured && captured_logs != nullptr;
+			});
+
+			THEN("every account's logs were being captured.")
+			{
+				REQUIRE(all_captured);
+			}
+
+			THEN("the calling thread isn't capturing anything afterwards.")
+			{
+				REQUIRE(captured_logs == nullptr);
+			}
+		}
+	}
+}
+
+SCENARIO("sync_accounts sets aside an account that gets rate limited and lets the others go first.")
+{
+	logs_off = true;
+
+	GIVEN("A few accounts where one gets rate limited the first time it's synced.")
+	{
+		const auto accounts = make_fake_accounts(5);
+		const auto jobs = GENERATE(1u, 2u, 5u);
+
+		std::mutex lock;
+		std::vector<std::string> events;
+		bool limited_once = false;
+		bool others_could_defer = true;
+
+		WHEN("they're synced")
+		{
+			sync_accounts(accounts, pool_limits{ jobs, 2 }, instance_of, [&](const fake_account& account)
+			{
+				const std::lock_guard<std::mutex> guard(lock);
+				if (account.name == "account1" && !limited_once)
+				{
+					limited_once = true;
+					events.push_back("limited " + account.name);
+					throw rate_limit_deferred(rate_limit_pacer::clock::now() + std::chrono::milliseconds(100));
+				}
+
+				// once there's only the one account left, it might as well wait where it is
+				if (events.size() < accounts.size() - 1)
+					others_could_defer = others_could_defer && defer_rate_limits;
+
+				events.push_back("synced " + account.name);
+			});
+
+			THEN("every account was synced once, and the limited one was tried again.")
+			{
+				REQUIRE(events.size() == accounts.size() + 1);
+				REQUIRE(std::count(events.begin(), events.end(), "synced account1") == 1);
+			}
+
+			THEN("the limited account was synced last, after its limit reset.")
+			{
+				REQUIRE(events.back() == "synced account1");
+			}
+
+			THEN("accounts were allowed to be set aside while there were others to sync.")
+			{
+				REQUIRE(others_could_defer);
+			}
+		}
+	}
+
+	GIVEN("A single account that gets rate limited.")
+	{
+		const auto accounts = make_fake_accounts(1);
+		bool deferring = true;
+
+		WHEN("it's synced")
+		{
+			sync_accounts(accounts, pool_limits{ 4, 2 }, instance_of, [&](const fake_account&)
+			{
+				deferring = defer_rate_limits;
+			});
+
+			THEN("it isn't set aside, since there's nothing else to do in the meantime.")
+			{
+				REQUIRE_FALSE(deferring);
+			}
+		}
+	}
+}
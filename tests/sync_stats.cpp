@@ -0,0 +1,167 @@
+#include <catch2/catch.hpp>
+
+#include "../lib/sync/sync_stats.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+constexpr size_t phase(sync_phase p)
+{
+	return static_cast<size_t>(p);
+}
+
+SCENARIO("timed_phase only records time when something is collecting it.")
+{
+	GIVEN("No stats_section.")
+	{
+		WHEN("a phase is timed")
+		{
+			{
+				const timed_phase parsing{ sync_phase::parse };
+			}
+
+			THEN("nothing is collecting.")
+			{
+				REQUIRE(current_stats == nullptr);
+			}
+		}
+	}
+
+	GIVEN("A stats_section with a report.")
+	{
+		stats_report report;
+
+		WHEN("phases are timed inside it, with one nested in another")
+		{
+			{
+				const stats_section section{ &report, "someone@website.egg", "home" };
+				REQUIRE(current_stats != nullptr);
+
+				const timed_phase parsing{ sync_phase::parse };
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				{
+					const timed_phase cleaning{ sync_phase::html_cleanup };
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				}
+			}
+
+			THEN("the section is in the report, and the inner phase's time doesn't count for the outer one.")
+			{
+				std::ostringstream printed;
+				report.print(printed, stats_format::json);
+				const auto parsed = nlohmann::json::parse(printed.str());
+
+				REQUIRE(parsed["sections"].size() == 1);
+				const auto& section = parsed["sections"][0];
+				REQUIRE(section["account"] == "someone@website.egg");
+				REQUIRE(section["section"] == "home");
+
+				const double parse_ms = section["phase_ms"]["parse"];
+				const double cleanup_ms = section["phase_ms"]["html_cleanup"];
+				const double total_ms = section["total_ms"];
+				REQUIRE(cleanup_ms >= 20);
+				REQUIRE(parse_ms >= 5);
+				REQUIRE(parse_ms < cleanup_ms);
+				REQUIRE(total_ms >= parse_ms + cleanup_ms);
+				REQUIRE(section["phase_ms"]["network"] == 0);
+			}
+
+			THEN("the thread isn't collecting anymore.")
+			{
+				REQUIRE(current_stats == nullptr);
+			}
+		}
+	}
+
+	GIVEN("A stats_section without a report.")
+	{
+		WHEN("it's created")
+		{
+			const stats_section section{ nullptr, "someone@website.egg", "home" };
+
+			THEN("nothing is collecting.")
+			{
+				REQUIRE(current_stats == nullptr);
+			}
+		}
+	}
+}
+
+SCENARIO("stats_report prints each account's sections together.")
+{
+	GIVEN("A report with sections from two accounts added out of order.")
+	{
+		stats_report report;
+
+		sync_stats first;
+		first.posts = 40;
+		first.requests = 2;
+		first.retries = 1;
+		first.rate_limited = 1;
+		first.bytes_downloaded = 2048;
+		first.wall_time = std::chrono::seconds(2);
+		first.phase_time[phase(sync_phase::network)] = std::chrono::milliseconds(1500);
+
+		sync_stats second;
+		second.posts = 10;
+		second.requests = 1;
+		second.wall_time = std::chrono::seconds(1);
+
+		report.add("zed@website.egg", "notifications", second);
+		report.add("amy@crime.egg", "notifications", first);
+		report.add("zed@website.egg", "home", first);
+
+		WHEN("it's printed as JSON")
+		{
+			std::ostringstream printed;
+			report.print(printed, stats_format::json);
+			const auto parsed = nlohmann::json::parse(printed.str());
+			const auto& sections = parsed["sections"];
+
+			THEN("the sections are grouped by account and keep their order within each one.")
+			{
+				REQUIRE(sections.size() == 3);
+				REQUIRE(sections[0]["account"] == "amy@crime.egg");
+				REQUIRE(sections[1]["account"] == "zed@website.egg");
+				REQUIRE(sections[1]["section"] == "notifications");
+				REQUIRE(sections[2]["account"] == "zed@website.egg");
+				REQUIRE(sections[2]["section"] == "home");
+			}
+
+			THEN("the numbers are all there.")
+			{
+				const auto& amy = sections[0];
+				REQUIRE(amy["posts"] == 40);
+				REQUIRE(amy["requests"] == 2);
+				REQUIRE(amy["retries"] == 1);
+				REQUIRE(amy["rate_limited"] == 1);
+				REQUIRE(amy["bytes_downloaded"] == 2048);
+				REQUIRE(amy["posts_per_second"] == 20.0);
+				REQUIRE(amy["total_ms"] == 2000.0);
+				REQUIRE(amy["phase_ms"]["network"] == 1500.0);
+			}
+		}
+
+		WHEN("it's printed as a table")
+		{
+			std::ostringstream printed;
+			report.print(printed, stats_format::table);
+			const std::string table = printed.str();
+
+			THEN("there's a row for each section and one for the total.")
+			{
+				REQUIRE(table.find("amy@crime.egg") != std::string::npos);
+				REQUIRE(table.find("zed@website.egg") != std::string::npos);
+				REQUIRE(table.find("notifications") != std::string::npos);
+				REQUIRE(table.find("\ntotal") != std::string::npos);
+				// the blank line, the explanation, the header, three sections, and the total
+				REQUIRE(std::count(table.begin(), table.end(), '\n') == 7);
+			}
+		}
+	}
+}
@@ -148,3 +148,31 @@ std::vector<std::string> make_expected_ids(const std::vector<std::string>& ids,
 		});
 	return toreturn;
 }
+
+std::string zero_padded(int value, size_t width)
+{
+	std::string printed = std::to_string(value);
+	if (printed.size() < width)
+		printed.insert(0, width - printed.size(), '0');
+	return printed;
+}
+
+std::string make_test_date(int year, int month, int day)
+{
+	year += (month - 1) / 12;
+	month = (month - 1) % 12 + 1;
+	return zero_padded(year, 4) + '-' + zero_padded(month, 2) + '-' + zero_padded(day, 2) + "T10:54:00.000Z";
+}
+
+mastodon_status make_test_status(int n, int id, std::string created_at)
+{
+	mastodon_status status;
+	status.id = std::to_string(id);
+	status.url = "https://website.egg/" + status.id;
+	status.content = "post number " + std::to_string(n);
+	status.visibility = "public";
+	status.created_at = std::move(created_at);
+	status.author.account_name = "regular@website.egg";
+	status.author.display_name = "Normal Person";
+	return status;
+}
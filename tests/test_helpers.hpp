@@ -3,6 +3,8 @@
 
 #include <filesystem.hpp>
 
+#include "../lib/entities/entities.hpp"
+
 #include <string>
 #include <vector>
 #include <string_view>
@@ -17,6 +19,14 @@ void make_notification_json(std::string_view id, std::string& to_append);
 
 std::vector<std::string> make_expected_ids(const std::vector<std::string>& ids, std::string_view prefix);
 
+// a created_at like 2020-06-01T10:54:00.000Z, padded right so dates sort as text.
+// months past 12 carry over into the next year, so tests can count months up from wherever they start.
+std::string make_test_date(int year, int month, int day);
+
+// a public status from regular@website.egg with the given id and date, saying "post number n".
+// tests change whatever else they care about.
+mastodon_status make_test_status(int n, int id, std::string created_at);
+
 bool flip_coin();
 int zero_to_n(int n);
 
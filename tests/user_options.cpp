@@ -2,6 +2,7 @@
 #include <catch2/catch.hpp>
 
 #include <fstream>
+#include <optional>
 
 #include "../lib/options/user_options.hpp"
 
@@ -418,3 +419,108 @@ SCENARIO("user_options don't save out if nothing changed.")
 		}
 	}
 }
+
+SCENARIO("user_options can be saved before they're destroyed.")
+{
+	GIVEN("A user_options with a change in it.")
+	{
+		const auto fi = temporary_file();
+
+		std::optional<user_options> opt{ std::in_place, fi.filename() };
+		opt->set_option(user_option::account_name, "sometester");
+
+		WHEN("it's saved")
+		{
+			opt->save();
+
+			THEN("the change is on disk right away.")
+			{
+				const user_options newopt{ fi.filename() };
+				REQUIRE(newopt.get_option(user_option::account_name) == "sometester");
+			}
+
+			AND_WHEN("it's saved again without any more changes")
+			{
+				const auto original_write_time = fs::last_write_time(fi.filename());
+				opt->save();
+
+				THEN("the file wasn't written again.")
+				{
+					REQUIRE(original_write_time == fs::last_write_time(fi.filename()));
+					REQUIRE_FALSE(fs::exists(fi.filenamebak()));
+				}
+			}
+
+			AND_WHEN("something else changes and the user_options is destroyed")
+			{
+				opt->set_option(user_option::instance_url, "website.egg");
+				opt.reset();
+
+				THEN("the later change is saved too.")
+				{
+					const user_options newopt{ fi.filename() };
+					REQUIRE(newopt.get_option(user_option::account_name) == "sometester");
+					REQUIRE(newopt.get_option(user_option::instance_url) == "website.egg");
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("user_options remembers which format to write lists in.")
+{
+	const test_file fi = temporary_file();
+	GIVEN("An empty user_options")
+	{
+		user_options opt{ fi.filename() };
+
+		THEN("lists are written as text.")
+		{
+			REQUIRE(opt.get_list_format() == list_format::text);
+		}
+
+		WHEN("the format is set and the user_options is saved and read again")
+		{
+			const auto format = GENERATE(list_format::text, list_format::jsonl, list_format::binary);
+			opt.set_option(user_option::list_format, format);
+			opt.save();
+
+			const user_options reread{ fi.filename() };
+
+			THEN("it has the format that was set.")
+			{
+				REQUIRE(reread.get_list_format() == format);
+				REQUIRE(*reread.try_get_option(user_option::list_format) == LIST_FORMAT_NAMES[static_cast<int>(format)]);
+			}
+		}
+	}
+}
+
+SCENARIO("user_options remembers whether to split lists up.")
+{
+	const test_file fi = temporary_file();
+	GIVEN("An empty user_options")
+	{
+		user_options opt{ fi.filename() };
+
+		THEN("lists aren't split up.")
+		{
+			REQUIRE(opt.get_list_segments() == list_segments::off);
+		}
+
+		WHEN("the setting is changed and the user_options is saved and read again")
+		{
+			const auto segments = GENERATE(list_segments::off, list_segments::monthly, list_segments::size);
+			opt.set_option(user_option::list_segments, segments);
+			opt.save();
+
+			const user_options reread{ fi.filename() };
+
+			THEN("it has the setting that was set.")
+			{
+				REQUIRE(reread.get_list_segments() == segments);
+				REQUIRE(*reread.try_get_option(user_option::list_segments) == LIST_SEGMENTS_NAMES[static_cast<int>(segments)]);
+			}
+		}
+	}
+}
@@ -314,7 +314,14 @@ SCENARIO("clean_up_html removes HTML tags and entities.")
 			std::make_tuple("&lt;p&gt;hello&lt;/p&gt;", "<p>hello</p>"),
 			std::make_tuple("&lt;3", "<3"),
 			std::make_tuple("<p>look at my :custom_emojo:</p>", "look at my :custom_emojo:"),
-			std::make_tuple("&hearts;&hearts;&hearts;&hearts;&hearts;&hearts;", "♥♥♥♥♥♥")
+			std::make_tuple("&hearts;&hearts;&hearts;&hearts;&hearts;&hearts;", "♥♥♥♥♥♥"),
+			std::make_tuple("<a title=\"one<br>two\">link</a>", "link"),
+			std::make_tuple("<p>one</p><br>\n<br/> <p>two</p>", "one\n\ntwo"),
+			std::make_tuple("&am<b>p;&#x2<i>6;&#3</i>8;", "&&&"),
+			std::make_tuple("&amp;lt; &notanentity; &#65;", "&lt; &notanentity; A"),
+			std::make_tuple("<p>unfinished &amp</p>", "unfinished &amp"),
+			std::make_tuple("<<p>>", "<>"),
+			std::make_tuple("<BR>loud<Br/>", "loud")
 		);
 
 		WHEN("the HTML is cleaned up")